@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include "adaptive_dispatcher.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+#include "wagon_intake.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+TEST(AdaptiveDispatcher, ClearsAllWagonsWithLookaheadPlanning) {
+    SortingHill hill = MakeOperatorHill(6, 64);
+    const size_t wagons = 1000;
+    for (size_t i = 0; i < wagons; ++i) {
+        hill.AddWagon(Wagon{static_cast<int>(i), kWagonType[(i * 7 + i / 5) % kWagonType.size()]});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    AdaptiveDispatcher dispatcher;
+    size_t loco = 0;
+    while (hill.IsWagonBuffer()) {
+        const std::optional<EventType> event = dispatcher.NextEvent(hill);
+        ASSERT_TRUE(event.has_value());
+        ASSERT_TRUE(hill.CheckEvent(*event));
+        if (*event == EventType::kLocoArrived) {
+            hill.HandleLocoArrived(kLocoType[loco++ % kLocoType.size()]);
+        } else {
+            hill.HandleEvent(*event);
+        }
+    }
+    hill.HandleEvent(EventType::kShiftEnded);
+
+    const HillMetrics metrics = hill.GetMetrics();
+    EXPECT_EQ(metrics.departed_wagons, wagons);
+    EXPECT_EQ(metrics.missed_wagons, (std::array<size_t, 4>{}));
+    EXPECT_GT(metrics.handled_events, wagons);
+    // Каждая команда, кроме вагонных, обслуживает поезд: накладные расходы ограничены
+    EXPECT_LT(metrics.handled_events, wagons + 4 * metrics.sent_trains + 4 * 6);
+}
+
+TEST(AdaptiveDispatcher, PreparesAndPlansBeforeWagons) {
+    SortingHill hill = MakeOperatorHill(2, 0);
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    AdaptiveDispatcher dispatcher;
+    EXPECT_EQ(dispatcher.NextEvent(hill), EventType::kPreparePath);
+    hill.HandleEvent(EventType::kPreparePath);
+    EXPECT_EQ(dispatcher.NextEvent(hill), EventType::kTrainPlanned);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    EXPECT_EQ(dispatcher.NextEvent(hill), EventType::kLocoArrived);
+}
+
+TEST(AdaptiveDispatcher, NothingToDoWithoutWagons) {
+    SortingHill hill = MakeOperatorHill(2, 0);
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    AdaptiveDispatcher dispatcher;
+    EXPECT_FALSE(dispatcher.NextEvent(hill).has_value());
+}
+
+TEST(AdaptiveDispatcher, WaitsForEmptyIntake) {
+    SortingHill hill = MakeOperatorHill(1, 0);
+    WagonIntake intake;
+    hill.AttachWagonSource(&intake);
+    hill.HandleEvent(EventType::kShiftStarted);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+
+    // Путь занят поездом с локомотивом, вагонов в линиях пока нет - ждать, а не гонять горку вхолостую.
+    AdaptiveDispatcher dispatcher;
+    EXPECT_FALSE(dispatcher.NextEvent(hill).has_value());
+
+    ASSERT_TRUE(intake.Push(Wagon{1, WagonType::kFreight}));
+    EXPECT_EQ(dispatcher.NextEvent(hill), EventType::kWagonArrived);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "dwell_tracker.h"
+#include "log2_histogram.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+#include "common.h"
+
+TEST(Log2Histogram, BucketsByPowersOfTwo) {
+    EXPECT_EQ(Log2Histogram::BucketOf(0.0), 0u);
+    EXPECT_EQ(Log2Histogram::BucketOf(0.5), 0u);
+    EXPECT_EQ(Log2Histogram::BucketOf(1.0), 1u);
+    EXPECT_EQ(Log2Histogram::BucketOf(3.0), 2u);
+    EXPECT_EQ(Log2Histogram::BucketOf(4.0), 3u);
+    EXPECT_EQ(Log2Histogram::BucketOf(1e30), Log2Histogram::kBuckets - 1);
+    EXPECT_DOUBLE_EQ(Log2Histogram::BucketLow(3), 4.0);
+
+    Log2Histogram histogram;
+    for (double value : {1.0, 2.0, 3.0, 5.0, 100.0}) {
+        histogram.Add(value);
+    }
+    EXPECT_EQ(histogram.GetCount(), 5u);
+    EXPECT_DOUBLE_EQ(histogram.GetMean(), 22.2);
+    EXPECT_DOUBLE_EQ(histogram.GetMax(), 100.0);
+    EXPECT_EQ(histogram.GetBucket(2), 2u);
+    EXPECT_DOUBLE_EQ(histogram.GetPercentile(0.5), 4.0);
+    EXPECT_DOUBLE_EQ(histogram.GetPercentile(1.0), 100.0);
+}
+
+TEST(DwellTracker, RingDrainTakesOldestMarks) {
+    DwellTracker tracker;
+    tracker.Reset(/*model_time=*/false);
+    tracker.OnRingPush(WagonType::kPass, 1.0);
+    tracker.OnRingPush(WagonType::kPass, 4.0);
+    tracker.OnRingPush(WagonType::kEmpty, 2.0);
+    tracker.OnRingDrain(WagonType::kPass, 1, 10.0);
+
+    const DwellReport& report = tracker.GetReport();
+    const Log2Histogram& pass = report.ring[static_cast<size_t>(WagonType::kPass)];
+    EXPECT_EQ(pass.GetCount(), 1u);
+    EXPECT_DOUBLE_EQ(pass.GetMax(), 9.0);
+    EXPECT_EQ(report.ring[static_cast<size_t>(WagonType::kEmpty)].GetCount(), 0u);
+
+    tracker.OnIntake(7, 3.0);
+    tracker.OnDeparted({Wagon{7, WagonType::kDanger}, Wagon{8, WagonType::kDanger}}, 11.0);
+    const Log2Histogram& danger = tracker.GetReport().station[static_cast<size_t>(WagonType::kDanger)];
+    EXPECT_EQ(danger.GetCount(), 1u);
+    EXPECT_DOUBLE_EQ(danger.GetMax(), 8.0);
+}
+
+TEST(DwellTracker, RepeatedNumbersKeepEveryIntake) {
+    DwellTracker tracker;
+    tracker.Reset(/*model_time=*/false);
+    tracker.OnIntake(5, 1.0);
+    tracker.OnIntake(5, 3.0);
+
+    // Оба вагона с номером 5 учтены, первым уезжает поступивший раньше.
+    tracker.OnDeparted({Wagon{5, WagonType::kFreight}}, 9.0);
+    tracker.OnDeparted({Wagon{5, WagonType::kFreight}}, 10.0);
+    const Log2Histogram& freight = tracker.GetReport().station[static_cast<size_t>(WagonType::kFreight)];
+    EXPECT_EQ(freight.GetCount(), 2u);
+    EXPECT_DOUBLE_EQ(freight.GetMax(), 8.0);
+    EXPECT_DOUBLE_EQ(freight.GetMean(), 7.5);
+}
+
+TEST(SortingHill, DwellCountsStationAndRingTime) {
+    SortingHill hill = MakeOperatorHill(1);
+    hill.EnableDwellTracking(true);
+    for (int i = 0; i < 16; ++i) {
+        hill.AddWagon(Wagon{i, WagonType::kFreight});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    // Два вагона на кольцо (команды 1, 2), поезд и локомотив выгружают их на команде 5.
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    for (int i = 0; i < 14; ++i) {
+        hill.HandleEvent(EventType::kWagonArrived);
+    }
+    hill.HandleEvent(EventType::kTrainReady); // команда 20
+
+    const DwellReport& dwell = hill.GetDwell();
+    const auto freight = static_cast<size_t>(WagonType::kFreight);
+    EXPECT_EQ(dwell.ring[freight].GetCount(), 2u);
+    EXPECT_DOUBLE_EQ(dwell.ring[freight].GetMax(), 4.0);
+    EXPECT_DOUBLE_EQ(dwell.ring[freight].GetMean(), 3.5);
+    EXPECT_EQ(dwell.station[freight].GetCount(), 16u);
+    EXPECT_DOUBLE_EQ(dwell.station[freight].GetMax(), 20.0);
+    EXPECT_EQ(dwell.station[static_cast<size_t>(WagonType::kPass)].GetCount(), 0u);
+}
+
+TEST(SortingHill, DwellIsNotTrackedByDefault) {
+    SortingHill hill = MakeOperatorHill(1);
+    EXPECT_FALSE(hill.HasDwellTracking());
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.HandleEvent(EventType::kShiftStarted);
+    hill.HandleEvent(EventType::kWagonArrived);
+
+    EXPECT_EQ(hill.GetDwell().ring[static_cast<size_t>(WagonType::kFreight)].GetCount(), 0u);
+    for (const MemoryEntry& entry : hill.GetMemoryReport()) {
+        EXPECT_NE(entry.name, "Время поступления");
+    }
+
+    // Включение посреди смены: вагоны на кольце отмечаются с текущего момента.
+    hill.EnableDwellTracking(true);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    EXPECT_EQ(hill.GetDwell().ring[static_cast<size_t>(WagonType::kFreight)].GetCount(), 1u);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include "event_scheduler.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+#include "wagon_intake.h"
+#include "workload_generator.h"
+
+#include <array>
+#include <optional>
+
+TEST(EventScheduler, SamplesOnlyEnabledEventsWithRenormalizedWeights) {
+    EventScheduler scheduler(3);
+
+    // Допустимы только kLocoArrived (вес 4) и kPreparePath (вес 2)
+    const std::uint32_t mask = (1u << 2) | (1u << 0);
+    std::array<size_t, 7> counts{};
+    const size_t n = 300000;
+    for (size_t i = 0; i < n; ++i) {
+        const std::optional<EventType> event = scheduler.Next(mask);
+        ASSERT_TRUE(event.has_value());
+        counts[static_cast<size_t>(*event)]++;
+    }
+
+    EXPECT_EQ(counts[static_cast<size_t>(EventType::kPreparePath)]
+                  + counts[static_cast<size_t>(EventType::kLocoArrived)],
+              n);
+    EXPECT_NEAR(static_cast<double>(counts[static_cast<size_t>(EventType::kLocoArrived)]) / n, 4.0 / 6.0, 0.01);
+}
+
+TEST(EventScheduler, NothingEnabled) {
+    EventScheduler scheduler(1);
+    EXPECT_FALSE(scheduler.Next(0u).has_value());
+
+    // Нулевой вес: команда не выбирается даже если допустима
+    std::array<double, 7> weights{};
+    weights[static_cast<size_t>(EventType::kWagonArrived)] = 1.0;
+    EventScheduler only_wagons(1, weights);
+    EXPECT_FALSE(only_wagons.Next(1u << 0).has_value());
+    EXPECT_EQ(only_wagons.Next(0b11111u), EventType::kWagonArrived);
+}
+
+TEST(EventScheduler, EveryDrawIsAcceptedByHill) {
+    SortingHill hill = MakeOperatorHill(3);
+    for (int i = 0; i < 500; ++i) {
+        hill.AddWagon(Wagon{i, kWagonType[static_cast<size_t>(i) % kWagonType.size()]});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    EventScheduler scheduler(11);
+    size_t commands = 0;
+    while (hill.IsWagonBuffer()) {
+        const std::optional<EventType> event = scheduler.Next(hill);
+        ASSERT_TRUE(event.has_value());
+        ASSERT_TRUE(hill.CheckEvent(*event));
+        hill.HandleEvent(*event);
+        ++commands;
+    }
+    hill.HandleEvent(EventType::kShiftEnded);
+    EXPECT_GE(commands, 500u);
+    EXPECT_EQ(hill.GetProcessedWagonsCount(), 500u);
+}
+
+TEST(EventScheduler, EmptyIntakeDisablesWagonArrival) {
+    SortingHill hill = MakeOperatorHill(2);
+    WagonIntake intake;
+    hill.AttachWagonSource(&intake);
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    const std::uint32_t wagon_bit = 1u << 3;
+    EXPECT_FALSE(hill.CheckEvent(EventType::kWagonArrived));
+    EXPECT_EQ(EventScheduler::GetEnabledMask(hill) & wagon_bit, 0u);
+    EXPECT_TRUE(hill.HasIncomingWagons());
+
+    ASSERT_TRUE(intake.Push(Wagon{1, WagonType::kFreight}));
+    EXPECT_TRUE(hill.CheckEvent(EventType::kWagonArrived));
+    EXPECT_NE(EventScheduler::GetEnabledMask(hill) & wagon_bit, 0u);
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.GetProcessedWagonsCount(), 1u);
+
+    intake.Close();
+    EXPECT_FALSE(hill.CheckEvent(EventType::kWagonArrived));
+    EXPECT_FALSE(hill.HasIncomingWagons());
+}
+
+TEST(EventScheduler, DiurnalAmplitudeModulatesWagonArrivals) {
+    WorkloadConfig workload;
+    workload.diurnal_amplitude = 0.9;
+    workload.day_length = 2400;
+    EventScheduler scheduler(5, workload);
+
+    // Фаза 6 из 24 - пик прибытия, фаза 18 - спад.
+    const auto wagon_share = [&scheduler](size_t command) {
+        size_t wagons = 0;
+        const size_t n = 100000;
+        for (size_t i = 0; i < n; ++i) {
+            wagons += scheduler.Next(0b11111u, command) == EventType::kWagonArrived ? 1 : 0;
+        }
+        return static_cast<double>(wagons) / n;
+    };
+    const double peak = wagon_share(650);
+    const double low = wagon_share(1850);
+    EXPECT_GT(peak, 2.0 * low);
+
+    // Без амплитуды фаза не влияет.
+    EventScheduler flat(5, WorkloadConfig{});
+    size_t flat_wagons = 0;
+    for (size_t i = 0; i < 100000; ++i) {
+        flat_wagons += flat.Next(0b11111u, 1850) == EventType::kWagonArrived ? 1 : 0;
+    }
+    EXPECT_GT(static_cast<double>(flat_wagons) / 100000, low);
+}
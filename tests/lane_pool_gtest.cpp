@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "lane_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(LanePool, RunsEveryTaskOnce) {
+    LanePool pool(3);
+    EXPECT_EQ(pool.GetWorkers(), 3u);
+
+    for (size_t count : {0u, 1u, 4u, 37u}) {
+        std::vector<std::atomic<int>> runs(count);
+        pool.Run(count, [&runs](size_t i) { runs[i]++; });
+        for (const auto& r : runs) {
+            EXPECT_EQ(r.load(), 1);
+        }
+    }
+}
+
+TEST(LanePool, WorksWithoutWorkers) {
+    LanePool pool(0);
+    int sum = 0;
+    pool.Run(4, [&sum](size_t i) { sum += static_cast<int>(i); });
+    EXPECT_EQ(sum, 6);
+}
+
+TEST(LanePool, RethrowsTaskError) {
+    LanePool pool(2);
+    std::atomic<int> done = 0;
+    EXPECT_THROW(pool.Run(4, [&done](size_t i) {
+                     if (i == 2) {
+                         throw std::runtime_error("lane");
+                     }
+                     done++;
+                 }),
+                 std::runtime_error);
+    EXPECT_EQ(done.load(), 3);
+
+    // После ошибки пул продолжает работать.
+    pool.Run(2, [&done](size_t) { done++; });
+    EXPECT_EQ(done.load(), 5);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include "log_sink.h"
+#include "observer_pipeline.h"
+#include "sorting_reporter.h"
+#include "spsc_ring.h"
+#include "test_helpers.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST(SpscRing, PushPopKeepsOrderAndRespectsCapacity) {
+    SpscRing<int> ring(3); // округляется до 4
+
+    EXPECT_EQ(ring.Capacity(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.TryPush(i));
+    }
+    EXPECT_FALSE(ring.TryPush(4));
+
+    int v = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.TryPop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(ring.TryPop(v));
+}
+
+TEST(SpscRing, TransfersAcrossThreads) {
+    SpscRing<int> ring(16);
+    const int n = 100000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < n; ++i) {
+            while (!ring.TryPush(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    long long sum = 0;
+    int expected = 0;
+    int v = 0;
+    while (expected < n) {
+        if (ring.TryPop(v)) {
+            ASSERT_EQ(v, expected);
+            sum += v;
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(sum, static_cast<long long>(n) * (n - 1) / 2);
+}
+
+TEST(LogSink, WritesLinesInOrderOnFlush) {
+    using namespace std::literals;
+
+    std::ostringstream out;
+    LogSink log(out, 2, OverflowPolicy::kBlock);
+
+    log.Log() << "Очередь вагонов: "s << 42;
+    log.Log();
+    log.Write("конец"s);
+    log.Flush();
+
+    EXPECT_EQ(out.str(), "Очередь вагонов: 42\n\nконец\n");
+    EXPECT_EQ(log.GetDroppedCount(), 0u);
+}
+
+TEST(LogSink, DropPolicyAccountsEveryLine) {
+    std::ostringstream out;
+    size_t accepted = 0;
+    {
+        LogSink log(out, 2, OverflowPolicy::kDrop);
+        for (int i = 0; i < 1000; ++i) {
+            if (log.Write(std::to_string(i))) {
+                ++accepted;
+            }
+        }
+        EXPECT_EQ(accepted + log.GetDroppedCount(), 1000u);
+    }
+
+    // После разрушения журнала всё принятое выведено.
+    size_t lines = 0;
+    for (char c : out.str()) {
+        if (c == '\n') {
+            ++lines;
+        }
+    }
+    EXPECT_EQ(lines, accepted);
+}
+
+// Поток наблюдателей (репортёр в ObserverPipeline) и основной поток пишут в один журнал.
+// Под -DTRAIN_TSAN=ON гонка за очередь журнала видна как ошибка ThreadSanitizer.
+TEST(LogSink, ObserverThreadAndMainThreadWriteTogether) {
+    using namespace std::literals;
+    constexpr int kWagons = 300;
+
+    std::ostringstream out;
+    {
+        LogSink log(out, 8, OverflowPolicy::kBlock);
+        SortingHill hill = MakeOperatorHill(2);
+        std::vector<std::unique_ptr<SortingObserver>> observers;
+        observers.push_back(std::make_unique<SortingReporterImpl>(log));
+        hill.AddObserver(std::make_unique<ObserverPipeline>(std::move(observers), /*capacity=*/4));
+
+        for (int i = 0; i < kWagons; ++i) {
+            hill.AddWagon(Wagon{i, WagonType::kFreight});
+        }
+        hill.HandleEvent(EventType::kShiftStarted);
+        for (int i = 0; i < kWagons; ++i) {
+            hill.HandleEvent(EventType::kWagonArrived);
+            log.Log() << "основной поток "s << i;
+        }
+        hill.HandleEvent(EventType::kShiftEnded);
+        log.Flush();
+    }
+
+    // Каждая строка целиком от одного из писателей, ни одна не потеряна.
+    std::istringstream lines(out.str());
+    std::string line;
+    int main_lines = 0;
+    int command_lines = 0;
+    while (std::getline(lines, line)) {
+        if (line.rfind("основной поток "s, 0) == 0) {
+            EXPECT_EQ(line, "основной поток "s + std::to_string(main_lines));
+            ++main_lines;
+        } else if (line.rfind("Команда дежурного"s, 0) == 0) {
+            ++command_lines;
+        }
+    }
+    EXPECT_EQ(main_lines, kWagons);
+    EXPECT_EQ(command_lines, kWagons);
+}
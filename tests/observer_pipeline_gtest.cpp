@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include "observer_pipeline.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "test_helpers.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Recorded {
+    std::vector<EventType> events;
+    std::vector<bool> dispatcher_commands;
+    std::vector<size_t> ring_totals;
+    size_t starts = 0;
+    size_t ends = 0;
+    size_t sent_at_end = 0;
+    std::thread::id thread;
+};
+
+class RecordingObserver : public SortingObserver {
+public:
+    explicit RecordingObserver(Recorded& out) : out_(out) {
+    }
+
+    void OnShiftStarted(const HillMetrics&) override {
+        out_.starts++;
+        out_.thread = std::this_thread::get_id();
+    }
+
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override {
+        out_.events.push_back(operation_info.event_type);
+        out_.dispatcher_commands.push_back(operation_info.dispatcher_command);
+        out_.ring_totals.push_back(metrics.ring_total);
+    }
+
+    void OnShiftEnded(const HillMetrics& metrics) override {
+        out_.ends++;
+        out_.sent_at_end = metrics.sent_trains;
+    }
+
+private:
+    Recorded& out_;
+};
+
+void RunShortShift(SortingHill& hill) {
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.AddWagon(Wagon{2, WagonType::kFreight});
+
+    hill.HandleEvent(EventType::kShiftStarted);
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleEvent(EventType::kLocoArrived);
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kShiftEnded);
+}
+
+} // namespace
+
+TEST(ObserverPipeline, DeliversOperationsInOrderOnOwnThread) {
+    Recorded recorded;
+    {
+        std::vector<std::unique_ptr<SortingHandler>> handlers;
+        handlers.push_back(std::make_unique<SortingOperatorImpl>());
+        SortingHill hill(1, std::move(handlers));
+
+        std::vector<std::unique_ptr<SortingObserver>> observers;
+        observers.push_back(std::make_unique<RecordingObserver>(recorded));
+        hill.AddObserver(std::make_unique<ObserverPipeline>(std::move(observers), /*capacity=*/2));
+
+        RunShortShift(hill);
+    } // разрушение станции дожидается наблюдателей
+
+    EXPECT_EQ(recorded.starts, 1u);
+    EXPECT_EQ(recorded.ends, 1u);
+    EXPECT_NE(recorded.thread, std::this_thread::get_id());
+
+    // Пять команд + в конце смены принудительная отправка и последняя неудачная попытка
+    const std::vector<EventType> expected = {
+        EventType::kWagonArrived, EventType::kPreparePath, EventType::kTrainPlanned,
+        EventType::kLocoArrived, EventType::kWagonArrived, EventType::kTrainReady,
+        EventType::kTrainReady,
+    };
+    EXPECT_EQ(recorded.events, expected);
+
+    // Первый вагон ушёл на кольцо, локомотив выгрузил его в поезд
+    ASSERT_EQ(recorded.ring_totals.size(), expected.size());
+    EXPECT_EQ(recorded.ring_totals[0], 1u);
+    EXPECT_EQ(recorded.ring_totals[3], 0u);
+    EXPECT_EQ(recorded.sent_at_end, 1u);
+}
+
+TEST(ObserverPipeline, InlineObserverSeesSameStream) {
+    Recorded recorded;
+
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>());
+    SortingHill hill(1, std::move(handlers));
+    hill.AddObserver(std::make_unique<RecordingObserver>(recorded));
+
+    RunShortShift(hill);
+
+    EXPECT_EQ(recorded.events.size(), 7u);
+    EXPECT_EQ(recorded.thread, std::this_thread::get_id());
+}
+
+TEST(ObserverPipeline, MarksOnlyDispatcherCommands) {
+    SortingHill hill = MakeOperatorHill(1);
+    Recorded recorded;
+    hill.AddObserver(std::make_unique<RecordingObserver>(recorded));
+
+    for (int i = 0; i < 3; ++i) {
+        hill.AddWagon(Wagon{i, WagonType::kFreight});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    ASSERT_EQ(hill.HandleWagonBatch(3), 3u);
+    // Неполный поезд уходит принудительно в конце смены - это не команда дежурного.
+    hill.HandleEvent(EventType::kShiftEnded);
+
+    // Подготовка, планирование, локомотив, пакет (три вагона), отправка и пустая попытка отправки.
+    const std::vector<bool> expected = {true, true, true, true, false, false, false, false};
+    EXPECT_EQ(recorded.dispatcher_commands, expected);
+}
+
+TEST(ObserverPipeline, FlushObserversWaitsForConsumer) {
+    Recorded recorded;
+    SortingHill hill = MakeOperatorHill(1);
+    std::vector<std::unique_ptr<SortingObserver>> observers;
+    observers.push_back(std::make_unique<RecordingObserver>(recorded));
+    hill.AddObserver(std::make_unique<ObserverPipeline>(std::move(observers), /*capacity=*/2));
+
+    for (int i = 0; i < 50; ++i) {
+        hill.AddWagon(Wagon{i, WagonType::kFreight});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+    for (int i = 0; i < 50; ++i) {
+        hill.HandleEvent(EventType::kWagonArrived);
+    }
+
+    // Станция жива и поток наблюдателей работает: после сброса он всё уже обработал.
+    hill.FlushObservers();
+    EXPECT_EQ(recorded.starts, 1u);
+    EXPECT_EQ(recorded.events.size(), 50u);
+}
+
+namespace {
+
+// Запоминает размер состава каждой отправки; состав нужен ему, только если needs_details.
+class ConsistObserver : public SortingObserver {
+public:
+    ConsistObserver(std::vector<size_t>& consists, bool needs_details)
+        : consists_(consists),
+          needs_details_(needs_details) {
+    }
+
+    void OnShiftStarted(const HillMetrics&) override {
+    }
+
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics&) override {
+        if (operation_info.train_sent) {
+            consists_.push_back(operation_info.departed_wagons.size());
+        }
+    }
+
+    void OnShiftEnded(const HillMetrics&) override {
+    }
+
+    bool NeedsOperationDetails() const override {
+        return needs_details_;
+    }
+
+private:
+    std::vector<size_t>& consists_;
+    const bool needs_details_;
+};
+
+} // namespace
+
+TEST(ObserverPipeline, CopiesConsistOnlyOnRequest) {
+    for (bool needs_details : {false, true}) {
+        std::vector<size_t> consists;
+        {
+            SortingHill hill = MakeOperatorHill(1);
+            std::vector<std::unique_ptr<SortingObserver>> observers;
+            observers.push_back(std::make_unique<ConsistObserver>(consists, needs_details));
+            hill.AddObserver(std::make_unique<ObserverPipeline>(std::move(observers)));
+            RunShortShift(hill);
+        }
+
+        // Поезд из двух вагонов уходит в конце смены.
+        const std::vector<size_t> expected = {needs_details ? 2u : 0u};
+        EXPECT_EQ(consists, expected);
+    }
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "operation_journal.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST(OperationJournal, ReaderAnswersQueriesAcrossBlocks) {
+    const std::string path = ::testing::TempDir() + "operation_journal_test.bin";
+    {
+        std::vector<std::unique_ptr<SortingHandler>> handlers;
+        handlers.push_back(std::make_unique<SortingOperatorImpl>());
+        SortingHill hill(1, std::move(handlers));
+        // Маленькие блоки, чтобы журнал состоял из нескольких
+        hill.AddObserver(std::make_unique<OperationJournal>(path, /*block_rows=*/3));
+
+        for (int i = 0; i < 5; ++i) {
+            hill.AddWagon(Wagon{100 + i, WagonType::kFreight});
+        }
+        hill.HandleEvent(EventType::kShiftStarted);
+        hill.HandleEvent(EventType::kWagonArrived); // на кольцо: 1
+        hill.HandleEvent(EventType::kWagonArrived); // на кольцо: 2
+        hill.HandleEvent(EventType::kPreparePath);
+        hill.HandleEvent(EventType::kTrainPlanned);
+        hill.HandleLocoArrived(LocoType::kElectro16); // кольцо -> поезд
+        hill.HandleEvent(EventType::kWagonArrived);
+        hill.HandleEvent(EventType::kWagonArrived);
+        hill.HandleEvent(EventType::kWagonArrived);
+        hill.HandleEvent(EventType::kShiftEnded); // отправка 5 вагонов + неудачная попытка
+    }
+
+    const JournalReader reader(path);
+    EXPECT_EQ(reader.GetRowsCount(), 11u);
+    EXPECT_EQ(reader.GetBlocks().size(), 4u);
+
+    const auto counts = reader.CountEvents(/*successful_only=*/true);
+    EXPECT_EQ(counts[static_cast<size_t>(EventType::kWagonArrived)], 5u);
+    EXPECT_EQ(counts[static_cast<size_t>(EventType::kTrainReady)], 1u);
+
+    const auto& first = reader.GetBlocks().front();
+    EXPECT_EQ(first.GetEventType(0), EventType::kShiftStarted);
+    EXPECT_EQ(first.GetEventType(1), EventType::kWagonArrived);
+    EXPECT_EQ(first.GetWagon(2), 101);
+    EXPECT_EQ(reader.GetBlocks().at(1).GetPathId(0), 0);
+
+    const auto ring = reader.RingOccupancy(/*bucket_rows=*/4);
+    // Второе окно начинается с kTrainPlanned: вагоны ещё на кольце до подачи локомотива.
+    const std::vector<std::uint32_t> expected_ring = {2, 2, 0};
+    EXPECT_EQ(ring, expected_ring);
+
+    const auto trains = reader.WagonsPerTrain();
+    ASSERT_EQ(trains.size(), 1u);
+    EXPECT_EQ(trains.at({0, 1}), 5);
+}
+
+TEST(OperationJournal, TrainsOfDifferentShiftsAreNotMerged) {
+    const std::string path = ::testing::TempDir() + "operation_journal_shifts_test.bin";
+    {
+        std::vector<std::unique_ptr<SortingHandler>> handlers;
+        handlers.push_back(std::make_unique<SortingOperatorImpl>());
+        SortingHill hill(1, std::move(handlers));
+        hill.AddObserver(std::make_unique<OperationJournal>(path, /*block_rows=*/4));
+
+        // Две смены подряд, в каждой поезд с номером 1, но разной длины.
+        for (int shift = 0; shift < 2; ++shift) {
+            for (int i = 0; i <= shift; ++i) {
+                hill.AddWagon(Wagon{10 * shift + i, WagonType::kFreight});
+            }
+            hill.HandleEvent(EventType::kShiftStarted);
+            hill.HandleEvent(EventType::kPreparePath);
+            hill.HandleEvent(EventType::kTrainPlanned);
+            hill.HandleLocoArrived(LocoType::kElectro16);
+            for (int i = 0; i <= shift; ++i) {
+                hill.HandleEvent(EventType::kWagonArrived);
+            }
+            hill.HandleEvent(EventType::kShiftEnded);
+        }
+    }
+
+    const JournalReader reader(path);
+    EXPECT_EQ(reader.CountEvents(/*successful_only=*/true)[static_cast<size_t>(EventType::kShiftStarted)], 2u);
+    const auto trains = reader.WagonsPerTrain();
+    ASSERT_EQ(trains.size(), 2u);
+    EXPECT_EQ(trains.at({0, 1}), 1);
+    EXPECT_EQ(trains.at({1, 1}), 2);
+}
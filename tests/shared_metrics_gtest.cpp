@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "shared_metrics.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace {
+
+std::string UniqueName(const char* suffix) {
+    return "/train_tests_"s + std::to_string(getpid()) + "_" + suffix;
+}
+
+HillMetrics Uniform(size_t value) {
+    HillMetrics metrics;
+    metrics.sent_trains = value;
+    metrics.ring_total = value;
+    metrics.ring_max = value;
+    for (auto& missed : metrics.missed_wagons) {
+        missed = value;
+    }
+    metrics.open_trains = value;
+    metrics.busy_paths = value;
+    metrics.processed_wagons = value;
+    metrics.buffer_wagons = value;
+    metrics.handled_events = value;
+    return metrics;
+}
+
+} // namespace
+
+TEST(SharedMetrics, RoundTrip) {
+    SharedMetricsPublisher publisher(UniqueName("roundtrip"));
+    const SharedMetricsReader reader(UniqueName("roundtrip"));
+
+    SharedHillState state;
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_FALSE(state.shift_active);
+    EXPECT_EQ(state.sent_trains, 0u);
+
+    HillMetrics metrics = Uniform(0);
+    metrics.sent_trains = 3;
+    metrics.ring_total = 17;
+    metrics.ring_max = 25;
+    metrics.missed_wagons = {1, 2, 3, 4};
+    metrics.open_trains = 5;
+    metrics.busy_paths = 6;
+    publisher.Publish(metrics, true);
+
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_TRUE(state.shift_active);
+    EXPECT_EQ(state.publications, 2u);
+    EXPECT_EQ(state.sent_trains, 3u);
+    EXPECT_EQ(state.ring_total, 17u);
+    EXPECT_EQ(state.ring_max, 25u);
+    EXPECT_EQ(state.missed_wagons[0], 1u);
+    EXPECT_EQ(state.missed_wagons[3], 4u);
+    EXPECT_EQ(state.open_trains, 5u);
+    EXPECT_EQ(state.busy_paths, 6u);
+}
+
+TEST(SharedMetrics, ReaderRequiresSegment) {
+    EXPECT_THROW(SharedMetricsReader(UniqueName("missing")), std::runtime_error);
+    EXPECT_THROW(SharedMetricsPublisher(""), std::invalid_argument);
+}
+
+TEST(SharedMetrics, ConcurrentReadsAreConsistent) {
+    SharedMetricsPublisher publisher(UniqueName("concurrent"));
+    const SharedMetricsReader reader(UniqueName("concurrent"));
+
+    constexpr size_t kPublications = 20000;
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        for (size_t i = 1; i <= kPublications; ++i) {
+            publisher.Publish(Uniform(i), true);
+            if (i % 64 == 0) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    size_t reads = 0;
+    size_t last = 0;
+    while (!done || reads == 0) {
+        SharedHillState state;
+        if (!reader.TryRead(state)) {
+            continue;
+        }
+        ++reads;
+        // Все поля публикуются одним значением: разнобой означает рваное чтение.
+        const size_t value = state.sent_trains;
+        ASSERT_EQ(state.ring_total, value);
+        ASSERT_EQ(state.ring_max, value);
+        ASSERT_EQ(state.missed_wagons[0], value);
+        ASSERT_EQ(state.missed_wagons[3], value);
+        ASSERT_EQ(state.open_trains, value);
+        ASSERT_EQ(state.busy_paths, value);
+        ASSERT_EQ(state.handled_events, value);
+        ASSERT_GE(value, last);
+        last = value;
+        std::this_thread::yield();
+    }
+    writer.join();
+
+    SharedHillState state;
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_EQ(state.sent_trains, kPublications);
+    EXPECT_GT(reads, 0u);
+}
+
+TEST(SharedMetrics, PublishesShiftOfHill) {
+    SortingHill hill = MakeOperatorHill(8);
+    hill.AddObserver(std::make_unique<SharedMetricsPublisher>(UniqueName("hill")));
+    const SharedMetricsReader reader(UniqueName("hill"));
+
+    hill.HandleEvent(EventType::kShiftStarted);
+    SharedHillState state;
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_TRUE(state.shift_active);
+
+    hill.HandleEvent(EventType::kPreparePath);
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_EQ(state.busy_paths, hill.GetBusyPathsCount());
+    EXPECT_EQ(state.handled_events, hill.GetHandledEventsCount());
+
+    hill.HandleEvent(EventType::kShiftEnded);
+    ASSERT_TRUE(reader.TryRead(state));
+    EXPECT_FALSE(state.shift_active);
+}
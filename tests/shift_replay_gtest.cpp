@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "random.h"
+#include "shift_recorder.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "test_helpers.h"
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(ShiftReplay, ReproducesRecordedRandomShift) {
+    const std::string path = ::testing::TempDir() + "shift_replay_test.bin";
+    const size_t paths = 3;
+
+    HillMetrics recorded;
+    size_t handled = 0;
+    {
+        SortingHill hill = MakeOperatorHill(paths);
+        RecordedStation station;
+        station.number_of_paths = paths;
+        ShiftRecorder recorder(path, station);
+        hill.SetRecorder(&recorder);
+
+        for (int i = 0; i < 300; ++i) {
+            hill.AddWagon(Wagon{i, RandomGen::GetRandomElem<WagonType>(kWagonType)});
+        }
+        hill.HandleEvent(EventType::kShiftStarted);
+        while (hill.IsWagonBuffer()) {
+            const EventType event = RandomGen::GetRandomElem<EventType>(kEventsBalanced);
+            if (hill.CheckEvent(event)) {
+                hill.HandleEvent(event);
+                ++handled;
+            }
+        }
+        // Часть вагонов приходит уже во время смены
+        hill.AddWagon(Wagon{1000, WagonType::kDanger});
+        hill.HandleEvent(EventType::kWagonArrived);
+        hill.HandleEvent(EventType::kShiftEnded);
+        handled += 3;
+
+        recorded = hill.GetMetrics();
+    }
+
+    const ShiftReplay replay = ShiftReplay::Load(path);
+    EXPECT_EQ(replay.GetNumberOfPaths(), paths);
+    EXPECT_EQ(replay.GetEventsCount(), handled);
+
+    SortingHill hill = MakeOperatorHill(replay.GetNumberOfPaths());
+    replay.Run(hill);
+    ExpectSameMetrics(hill.GetMetrics(), recorded);
+}
+
+TEST(ShiftReplay, RecordsStationSettings) {
+    const std::string path = ::testing::TempDir() + "shift_replay_settings.bin";
+    RecordedStation station;
+    station.number_of_paths = 4;
+    station.ring_limits.total = 12;
+    station.ring_limits.per_kind = {5, 0, 3, 0};
+    station.hump_reordering = HumpReordering{8, 2};
+    station.dispatch_policy = DispatchPolicy{0.75, 40.0, true};
+    station.planning_window = 16;
+    station.loco_assignment = LocoAssignment::kCapacityAware;
+
+    const auto make_hill = [](const RecordedStation& settings) {
+        std::vector<std::unique_ptr<SortingHandler>> handlers;
+        handlers.push_back(
+            std::make_unique<SortingOperatorImpl>(settings.planning_window, settings.loco_assignment));
+        SortingHill hill(settings.number_of_paths, std::move(handlers));
+        hill.SetRingLimits(settings.ring_limits);
+        hill.SetHumpReordering(settings.hump_reordering);
+        hill.SetDispatchPolicy(settings.dispatch_policy);
+        return hill;
+    };
+
+    HillMetrics recorded;
+    {
+        SortingHill hill = make_hill(station);
+        ShiftRecorder recorder(path, station);
+        hill.SetRecorder(&recorder);
+        for (int i = 0; i < 400; ++i) {
+            hill.AddWagon(Wagon{i, kWagonType[static_cast<size_t>(i * 7 + i / 3) % kWagonType.size()]});
+        }
+        hill.HandleEvent(EventType::kShiftStarted);
+        for (double t = 0.0; hill.IsWagonBuffer(); t += 30.0) {
+            hill.SetModelTime(t);
+            const EventType event = RandomGen::GetRandomElem<EventType>(kEventsBalanced);
+            if (hill.CheckEvent(event)) {
+                hill.HandleEvent(event);
+            } else if (!hill.CheckEvent(EventType::kWagonArrived) && hill.CheckEvent(EventType::kTrainReady)) {
+                hill.HandleEvent(EventType::kTrainReady);
+            }
+        }
+        hill.HandleEvent(EventType::kShiftEnded);
+        recorded = hill.GetMetrics();
+    }
+
+    const ShiftReplay replay = ShiftReplay::Load(path);
+    const RecordedStation& loaded = replay.GetStation();
+    EXPECT_EQ(loaded.number_of_paths, station.number_of_paths);
+    EXPECT_EQ(loaded.ring_limits.total, station.ring_limits.total);
+    EXPECT_EQ(loaded.ring_limits.per_kind, station.ring_limits.per_kind);
+    EXPECT_EQ(loaded.hump_reordering.window, station.hump_reordering.window);
+    EXPECT_EQ(loaded.hump_reordering.max_bypass, station.hump_reordering.max_bypass);
+    EXPECT_EQ(loaded.dispatch_policy.min_fill, station.dispatch_policy.min_fill);
+    EXPECT_EQ(loaded.dispatch_policy.max_age, station.dispatch_policy.max_age);
+    EXPECT_EQ(loaded.dispatch_policy.path_pressure, station.dispatch_policy.path_pressure);
+    EXPECT_EQ(loaded.planning_window, station.planning_window);
+    EXPECT_EQ(loaded.loco_assignment, station.loco_assignment);
+
+    SortingHill hill = make_hill(loaded);
+    replay.Run(hill);
+    ExpectSameMetrics(hill.GetMetrics(), recorded);
+    EXPECT_GT(recorded.reordered_wagons, 0u);
+    EXPECT_GT(recorded.early_departures, 0u);
+}
+
+TEST(ShiftReplay, RejectsForeignFile) {
+    const std::string path = ::testing::TempDir() + "shift_replay_garbage.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "not a recording";
+    }
+    EXPECT_THROW(ShiftReplay::Load(path), std::runtime_error);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "adaptive_dispatcher.h"
+#include "event_scheduler.h"
+#include "shift_simulator.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+#include "workload_generator.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+WorkloadConfig SingleLocoTypeWorkload() {
+    WorkloadConfig workload;
+    workload.seed = 5;
+    workload.loco_type_weights = {0.0, 1.0, 0.0, 0.0}; // только ЭВЛ-32
+    return workload;
+}
+
+SimulationReport RunAdaptive(size_t paths, size_t wagons, SimulationConfig config) {
+    SortingHill hill = MakeOperatorHill(paths, /*planning_window=*/64);
+    WorkloadGenerator generator(SingleLocoTypeWorkload());
+    for (const Wagon& wagon : generator.GenerateWagons(wagons)) {
+        hill.AddWagon(wagon);
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    AdaptiveDispatcher dispatcher;
+    ShiftSimulator simulator(hill, dispatcher, generator, std::move(config));
+    const SimulationReport report = simulator.Run();
+    EXPECT_EQ(simulator.GetClock(), report.elapsed_seconds);
+    hill.HandleEvent(EventType::kShiftEnded);
+    return report;
+}
+
+} // namespace
+
+TEST(ShiftSimulator, ClearsStationAndReportsKpis) {
+    const size_t wagons = 640;
+    const SimulationReport report = RunAdaptive(4, wagons, SimulationConfig{});
+
+    EXPECT_EQ(report.departed_wagons, wagons);
+    // Горка пропускает вагоны по одному
+    EXPECT_GE(report.elapsed_seconds, wagons * OperationDurations{}.hump_passage);
+    EXPECT_DOUBLE_EQ(report.wagons_per_hour, wagons * 3600.0 / report.elapsed_seconds);
+    EXPECT_GT(report.path_utilization, 0.0);
+    EXPECT_LE(report.path_utilization, 1.0);
+    EXPECT_GT(report.mean_dwell_seconds, 0.0);
+    EXPECT_GT(report.commands, wagons);
+}
+
+TEST(ShiftSimulator, ScalesWithDurations) {
+    SimulationConfig base;
+    SimulationConfig slow;
+    slow.durations.hump_passage *= 2;
+    slow.durations.path_preparation *= 2;
+    slow.durations.train_planning *= 2;
+    slow.durations.loco_arrival *= 2;
+    slow.durations.departure *= 2;
+
+    const SimulationReport a = RunAdaptive(3, 300, base);
+    const SimulationReport b = RunAdaptive(3, 300, slow);
+    EXPECT_EQ(a.commands, b.commands);
+    EXPECT_DOUBLE_EQ(b.elapsed_seconds, 2 * a.elapsed_seconds);
+    EXPECT_DOUBLE_EQ(b.wagons_per_hour, a.wagons_per_hour / 2);
+}
+
+TEST(ShiftSimulator, InboundFlowAndHorizon) {
+    SimulationConfig config;
+    WorkloadGenerator wagons_source(SingleLocoTypeWorkload());
+    config.inbound_wagons = wagons_source.GenerateWagons(1000);
+    config.inbound_interval = 120.0;
+    config.horizon = 10 * 3600.0;
+
+    const SimulationReport report = RunAdaptive(4, 0, config);
+    // Новые команды после горизонта не выдаются, выполняемые - завершаются.
+    EXPECT_GE(report.elapsed_seconds, config.horizon);
+    EXPECT_LE(report.elapsed_seconds, config.horizon + OperationDurations{}.loco_arrival);
+    EXPECT_GT(report.departed_wagons, 0u);
+    EXPECT_LT(report.departed_wagons, 1000u);
+}
+
+TEST(ShiftSimulator, RandomSchedulerRespectsBusyChannels) {
+    SortingHill hill = MakeOperatorHill(3, /*planning_window=*/64);
+    WorkloadGenerator generator(SingleLocoTypeWorkload());
+    for (const Wagon& wagon : generator.GenerateWagons(200)) {
+        hill.AddWagon(wagon);
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    EventScheduler scheduler(9);
+    ShiftSimulator simulator(hill, scheduler, generator, SimulationConfig{});
+    const SimulationReport report = simulator.Run();
+    EXPECT_EQ(hill.GetProcessedWagonsCount(), 200u);
+    EXPECT_GE(report.elapsed_seconds, 200 * OperationDurations{}.hump_passage);
+}
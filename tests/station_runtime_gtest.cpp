@@ -5,8 +5,11 @@
 #include "sorting_operator.h"
 #include "handler_interface.h"
 #include "common.h"
+#include "test_helpers.h"
 
+#include <array>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -255,6 +258,470 @@ TEST(StationRuntime, EndShiftDoesNotCrash) {
 }
 
 
+TEST(StationRuntime, PlanningWindowFollowsUpcomingWagons) {
+    auto hill = MakeHill(2);
+    for (int i = 0; i < 10; ++i) {
+        hill.AddWagon(W(i, WagonType::kDanger));
+    }
+
+    // Без окна: пустое кольцо -> ротация начинается с грузового
+    StationRuntime plain;
+    plain.StartShift(hill.GetNumberOfPaths());
+    OperationInfo op;
+    ASSERT_TRUE(plain.PreparePath(&op));
+    ASSERT_TRUE(plain.AllocateTrain(hill, &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "Г"));
+
+    StationRuntime planned;
+    planned.SetPlanningWindow(8);
+    planned.StartShift(hill.GetNumberOfPaths());
+    ASSERT_TRUE(planned.PreparePath(&op));
+    ASSERT_TRUE(planned.AllocateTrain(hill, &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "О"));
+}
+
+TEST(StationRuntime, PlanningWindowAccountsForOpenCapacity) {
+    auto hill = MakeHill(2);
+    for (int i = 0; i < 12; ++i) {
+        hill.AddWagon(W(i, WagonType::kPass));
+    }
+    for (int i = 12; i < 18; ++i) {
+        hill.AddWagon(W(i, WagonType::kEmpty));
+    }
+
+    StationRuntime rt;
+    rt.SetPlanningWindow(64);
+    rt.StartShift(hill.GetNumberOfPaths());
+
+    OperationInfo op;
+    ASSERT_TRUE(rt.PreparePath(&op));
+    ASSERT_TRUE(rt.AllocateTrain(hill, &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "Л"));
+
+    // 12 пассажирских уместятся в уже запланированный поезд: следующий - под порожние
+    ASSERT_TRUE(rt.PreparePath(&op));
+    ASSERT_TRUE(rt.AllocateTrain(hill, &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "П"));
+}
+
+// Поезд Л (3 вагона на кольце) запланирован раньше поезда Г (40 вагонов).
+static void PlanSmallThenLargeBacklog(StationRuntime& rt) {
+    OperationInfo op;
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(rt.HandleWagon(W(i, WagonType::kPass), &op));
+    ASSERT_TRUE(rt.PreparePath(&op));
+    ASSERT_TRUE(rt.AllocateTrain(&op));
+    ASSERT_TRUE(EndsWith(*op.train_number, "Л"));
+
+    for (int i = 100; i < 140; ++i) ASSERT_TRUE(rt.HandleWagon(W(i, WagonType::kFreight), &op));
+    ASSERT_TRUE(rt.PreparePath(&op));
+    ASSERT_TRUE(rt.AllocateTrain(&op));
+    ASSERT_TRUE(EndsWith(*op.train_number, "Г"));
+}
+
+TEST(StationRuntime, FifoLocoGoesToOldestTrain) {
+    auto hill = MakeHill(3);
+    StationRuntime rt;
+    rt.StartShift(hill.GetNumberOfPaths());
+    PlanSmallThenLargeBacklog(rt);
+
+    OperationInfo op;
+    ASSERT_TRUE(rt.HandleLocomotive(hill, L(LocoType::kDiesel64), &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "Л"));
+}
+
+TEST(StationRuntime, CapacityAwareLocoGoesToLargestBacklog) {
+    auto hill = MakeHill(3);
+    StationRuntime rt;
+    rt.SetLocoAssignment(LocoAssignment::kCapacityAware);
+    rt.StartShift(hill.GetNumberOfPaths());
+    PlanSmallThenLargeBacklog(rt);
+
+    OperationInfo op;
+    ASSERT_TRUE(rt.HandleLocomotive(hill, L(LocoType::kDiesel64), &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "Г"));
+    EXPECT_EQ(op.train_wagons, 40u);
+
+    ASSERT_TRUE(rt.HandleLocomotive(hill, L(LocoType::kElectro16), &op));
+    EXPECT_TRUE(EndsWith(*op.train_number, "Л"));
+    EXPECT_EQ(rt.RingTotal(), 0u);
+}
+
+TEST(StationRuntime, ReservePoolPicksLocoByPolicy) {
+    auto hill = MakeHill(2);
+    for (LocoAssignment policy : {LocoAssignment::kFifo, LocoAssignment::kCapacityAware}) {
+        StationRuntime rt;
+        rt.SetLocoAssignment(policy);
+        rt.StartShift(hill.GetNumberOfPaths());
+
+        OperationInfo op;
+        ASSERT_TRUE(rt.HandleLocomotive(hill, L(LocoType::kDiesel64), &op));
+        ASSERT_TRUE(rt.HandleLocomotive(hill, L(LocoType::kElectro16), &op));
+        EXPECT_EQ(op.loco_reserved, true);
+        EXPECT_EQ(rt.ReservedLocos(), 2u);
+        EXPECT_EQ(rt.ReservedLocos(LocoType::kDiesel64), 1u);
+
+        for (int i = 0; i < 10; ++i) ASSERT_TRUE(rt.HandleWagon(W(i, WagonType::kEmpty), &op));
+        ASSERT_TRUE(rt.PreparePath(&op));
+        ASSERT_TRUE(rt.AllocateTrain(hill, &op));
+        // fifo - первый прибывший ТДЛ-64, capacity - наименьший вмещающий 10 вагонов ЭВЛ-16
+        EXPECT_EQ(op.loco_capacity, policy == LocoAssignment::kFifo ? 64 : 16);
+        EXPECT_EQ(rt.ReservedLocos(), 1u);
+    }
+}
+
+TEST(StationRuntime, RingLimitsRejectWagons) {
+    auto hill = MakeHill(1);
+    StationRuntime rt;
+    RingLimits limits;
+    limits.total = 3;
+    limits.per_kind[1] = 1; // Л
+    rt.SetRingLimits(limits);
+    rt.StartShift(hill.GetNumberOfPaths());
+
+    OperationInfo op;
+    ASSERT_TRUE(rt.HandleWagon(W(1, WagonType::kPass), &op));
+    EXPECT_FALSE(rt.HandleWagon(W(2, WagonType::kPass), &op));
+    EXPECT_FALSE(op.success);
+    ASSERT_TRUE(rt.HandleWagon(W(3, WagonType::kFreight), &op));
+    ASSERT_TRUE(rt.HandleWagon(W(4, WagonType::kFreight), &op));
+    EXPECT_FALSE(rt.HandleWagon(W(5, WagonType::kDanger), &op));
+    EXPECT_EQ(rt.RingTotal(), 3u);
+}
+
+TEST(SortingHill, FullRingThrottlesInputUntilDrained) {
+    RingLimits limits;
+    limits.total = 2;
+    auto hill = MakeOperatorHill(1, limits);
+    for (int i = 0; i < 5; ++i) {
+        hill.AddWagon(W(i, WagonType::kFreight));
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_FALSE(hill.IsInputThrottled());
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_TRUE(hill.IsInputThrottled());
+    EXPECT_FALSE(hill.CheckEvent(EventType::kWagonArrived));
+
+    // Команда в обход CheckEvent вагон не пропускает
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.GetNumberOfWagBuffer(), 3u);
+    EXPECT_EQ(hill.GetRingTotal(), 2u);
+
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    EXPECT_TRUE(hill.IsInputThrottled());
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    EXPECT_FALSE(hill.IsInputThrottled());
+    EXPECT_EQ(hill.GetRingTotal(), 0u);
+    EXPECT_EQ(hill.GetThrottledEventsCount(), 3u);
+
+    while (hill.IsWagonBuffer()) {
+        ASSERT_TRUE(hill.CheckEvent(EventType::kWagonArrived));
+        hill.HandleEvent(EventType::kWagonArrived);
+    }
+    EXPECT_EQ(hill.GetRingMax(), 2u);
+}
+
+TEST(SortingHill, ThrottledInputAllowsPartialDeparture) {
+    RingLimits limits;
+    limits.per_kind[1] = 1; // Л
+    auto hill = MakeOperatorHill(1, limits);
+    hill.AddWagon(W(1, WagonType::kPass));
+    hill.AddWagon(W(2, WagonType::kPass));
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    // Единственный путь занят грузовым поездом, пассажирскому вагону места нет
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kWagonArrived);
+    ASSERT_TRUE(hill.IsInputThrottled());
+
+    ASSERT_TRUE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kTrainReady);
+    EXPECT_EQ(hill.GetSentTrainsCount(), 1u);
+    EXPECT_TRUE(hill.CheckEvent(EventType::kPreparePath));
+}
+
+TEST(SortingHill, ThrottledInputPrefersPlanningOverDeparture) {
+    RingLimits limits;
+    limits.per_kind[2] = 1; // О
+    auto hill = MakeOperatorHill(2, limits);
+    hill.AddWagon(W(1, WagonType::kDanger));
+    hill.AddWagon(W(2, WagonType::kDanger));
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    // Грузовой поезд под локомотивом, второй путь свободен.
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    hill.HandleEvent(EventType::kWagonArrived); // О на кольцо
+    ASSERT_TRUE(hill.IsInputThrottled());
+
+    // Путь под новый поезд есть: отправлять пустой поезд незачем.
+    EXPECT_FALSE(hill.IsThrottleReleaseDue());
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kPreparePath);
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+    EXPECT_TRUE(hill.CheckEvent(EventType::kTrainPlanned));
+}
+
+TEST(SortingHill, ThrottleReleaseSendsNonEmptyTrainFirst) {
+    RingLimits limits;
+    limits.per_kind[2] = 1; // О
+    auto hill = MakeOperatorHill(2, limits);
+    hill.AddWagon(W(1, WagonType::kDanger));
+    hill.AddWagon(W(2, WagonType::kPass));
+    hill.AddWagon(W(3, WagonType::kDanger));
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    // На пустом кольце поезда идут по ротации: грузовой, затем пассажирский; оба под локомотивами.
+    for (int i = 0; i < 2; ++i) {
+        hill.HandleEvent(EventType::kPreparePath);
+        hill.HandleEvent(EventType::kTrainPlanned);
+        hill.HandleLocoArrived(LocoType::kElectro16);
+    }
+    hill.HandleEvent(EventType::kWagonArrived); // О на кольцо
+    hill.HandleEvent(EventType::kWagonArrived); // Л в пассажирский поезд
+    ASSERT_TRUE(hill.IsInputThrottled());
+
+    // Все пути заняты, поезда для О нет и не будет: отправляется непустой поезд, а не первый.
+    ASSERT_TRUE(hill.IsThrottleReleaseDue());
+    ASSERT_TRUE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kTrainReady);
+    EXPECT_EQ(hill.GetSentTrainsCount(), 1u);
+    EXPECT_EQ(hill.GetDepartedWagonsCount(), 1u);
+    EXPECT_EQ(hill.GetBusyPathsCount(), 1u);
+    EXPECT_TRUE(hill.CheckEvent(EventType::kPreparePath));
+    hill.HandleEvent(EventType::kPreparePath);
+    EXPECT_EQ(hill.GetBusyPathsCount(), 2u);
+}
+
+// Путь с грузовым поездом под ЭВЛ-16 (на пустом кольце первый поезд по ротации - грузовой).
+static SortingHill MakeHillWithOpenFreightTrain(const HumpReordering& reordering) {
+    auto hill = MakeOperatorHill(1, RingLimits{});
+    hill.SetHumpReordering(reordering);
+    hill.EnableWagonLocator(true);
+    hill.HandleEvent(EventType::kShiftStarted);
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    return hill;
+}
+
+TEST(SortingHill, HumpWindowSendsWagonStraightToOpenTrain) {
+    HumpReordering reordering;
+    reordering.window = 4;
+    auto hill = MakeHillWithOpenFreightTrain(reordering);
+    hill.AddWagon(W(1, WagonType::kPass));
+    hill.AddWagon(W(2, WagonType::kDanger));
+    hill.AddWagon(W(3, WagonType::kFreight));
+    hill.AddWagon(W(4, WagonType::kFreight));
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.GetRingTotal(), 0u);
+    EXPECT_EQ(hill.GetReorderedWagonsCount(), 1u);
+    EXPECT_EQ(hill.LocateWagon(3)->place, WagonPlace::kTrain);
+    // Обойдённые вагоны сохраняют порядок.
+    EXPECT_EQ(hill.LocateWagon(1)->position, 0u);
+    EXPECT_EQ(hill.LocateWagon(2)->position, 1u);
+    EXPECT_EQ(hill.LocateWagon(4)->position, 2u);
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.LocateWagon(4)->place, WagonPlace::kTrain);
+
+    // Грузовых в окне нет - по очереди.
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.LocateWagon(1)->place, WagonPlace::kRing);
+    EXPECT_EQ(hill.GetRingEntriesCount(), 1u);
+    EXPECT_EQ(hill.GetReorderedWagonsCount(), 2u);
+}
+
+TEST(SortingHill, HumpWindowAgingBoundServesHead) {
+    HumpReordering reordering;
+    reordering.window = 8;
+    reordering.max_bypass = 2;
+    auto hill = MakeHillWithOpenFreightTrain(reordering);
+    hill.AddWagon(W(1, WagonType::kPass));
+    for (int i = 2; i <= 5; ++i) {
+        hill.AddWagon(W(i, WagonType::kFreight));
+    }
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.LocateWagon(1)->place, WagonPlace::kBuffer);
+
+    // Голову обошли дважды - дальше она идёт первой, хотя грузовому поезду есть место.
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.LocateWagon(1)->place, WagonPlace::kRing);
+    EXPECT_EQ(hill.LocateWagon(4)->place, WagonPlace::kBuffer);
+    EXPECT_EQ(hill.GetReorderedWagonsCount(), 2u);
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_EQ(hill.LocateWagon(4)->place, WagonPlace::kTrain);
+    EXPECT_EQ(hill.GetRingEntriesCount(), 1u);
+}
+
+static SortingHill MakeHillWithDispatchPolicy(const DispatchPolicy& policy) {
+    auto hill = MakeHillWithOpenFreightTrain(HumpReordering{});
+    hill.SetDispatchPolicy(policy);
+    return hill;
+}
+
+TEST(SortingHill, EarlyDispatchByFillRatio) {
+    DispatchPolicy policy;
+    policy.min_fill = 0.75;
+    auto hill = MakeHillWithDispatchPolicy(policy);
+    for (int i = 0; i < 20; ++i) {
+        hill.AddWagon(W(i, WagonType::kFreight));
+    }
+
+    for (int i = 0; i < 11; ++i) {
+        hill.HandleEvent(EventType::kWagonArrived);
+    }
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kWagonArrived); // 12 из 16
+    ASSERT_TRUE(hill.CheckEvent(EventType::kTrainReady));
+
+    hill.HandleEvent(EventType::kTrainReady);
+    EXPECT_EQ(hill.GetSentTrainsCount(), 1u);
+    EXPECT_EQ(hill.GetDepartedWagonsCount(), 12u);
+    EXPECT_EQ(hill.GetEarlyDeparturesCount(), 1u);
+    EXPECT_TRUE(hill.CheckEvent(EventType::kPreparePath));
+}
+
+TEST(SortingHill, EarlyDispatchByAge) {
+    DispatchPolicy policy;
+    policy.max_age = 5; // поезд запланирован второй командой
+    auto hill = MakeHillWithDispatchPolicy(policy);
+    hill.AddWagon(W(1, WagonType::kFreight));
+    hill.AddWagon(W(2, WagonType::kPass));
+    hill.AddWagon(W(3, WagonType::kPass));
+
+    hill.HandleEvent(EventType::kWagonArrived); // команда 4
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kWagonArrived); // команда 6
+    hill.AddWagon(W(4, WagonType::kPass));
+    hill.HandleEvent(EventType::kWagonArrived); // команда 7: прошло 5 команд
+    ASSERT_TRUE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kTrainReady);
+    EXPECT_EQ(hill.GetEarlyDeparturesCount(), 1u);
+}
+
+TEST(SortingHill, EarlyDispatchUnderPathPressure) {
+    DispatchPolicy policy;
+    policy.path_pressure = true;
+    auto hill = MakeHillWithDispatchPolicy(policy);
+    hill.AddWagon(W(1, WagonType::kFreight));
+    hill.AddWagon(W(2, WagonType::kFreight));
+    hill.AddWagon(W(3, WagonType::kPass));
+    hill.AddWagon(W(4, WagonType::kFreight));
+
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kWagonArrived);
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+
+    // Пассажирскому вагону нет ни поезда, ни свободного пути.
+    hill.HandleEvent(EventType::kWagonArrived);
+    ASSERT_TRUE(hill.CheckEvent(EventType::kTrainReady));
+    hill.HandleEvent(EventType::kTrainReady);
+    EXPECT_EQ(hill.GetDepartedWagonsCount(), 2u);
+    EXPECT_EQ(hill.GetEarlyDeparturesCount(), 1u);
+}
+
+TEST(SortingHill, DispatchPolicyRejectsBadFill) {
+    auto hill = MakeOperatorHill(1, RingLimits{});
+    DispatchPolicy policy;
+    policy.min_fill = 1.5;
+    EXPECT_THROW(hill.SetDispatchPolicy(policy), std::invalid_argument);
+}
+
+static const MemoryEntry& FindEntry(const std::vector<MemoryEntry>& report, const std::string& name) {
+    for (const MemoryEntry& entry : report) {
+        if (entry.name == name) return entry;
+    }
+    ADD_FAILURE() << "Нет записи " << name;
+    static const MemoryEntry kEmpty;
+    return kEmpty;
+}
+
+TEST(SortingHill, MemoryReportTracksLiveAndPeak) {
+    auto hill = MakeOperatorHill(2, RingLimits{});
+    for (int i = 0; i < 1000; ++i) {
+        hill.AddWagon(W(i, WagonType::kDanger));
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    auto report = hill.GetMemoryReport();
+    EXPECT_EQ(FindEntry(report, "Входной буфер").elements, 1000u);
+    EXPECT_GE(FindEntry(report, "Входной буфер").bytes, 1000 * sizeof(Wagon));
+    EXPECT_STREQ(report.back().name, "Всего");
+
+    for (int i = 0; i < 600; ++i) {
+        hill.HandleEvent(EventType::kWagonArrived);
+    }
+    report = hill.GetMemoryReport();
+    const MemoryEntry& buffer = FindEntry(report, "Входной буфер");
+    const MemoryEntry& ring = FindEntry(report, "Кольцевой путь");
+    EXPECT_EQ(buffer.elements, 400u);
+    EXPECT_LT(buffer.bytes, buffer.peak_bytes);
+    EXPECT_EQ(ring.elements, 600u);
+    EXPECT_GE(ring.bytes, 600 * sizeof(Wagon));
+
+    size_t sum = 0;
+    for (size_t i = 0; i + 1 < report.size(); ++i) sum += report[i].bytes;
+    EXPECT_EQ(report.back().bytes, sum);
+    EXPECT_GE(report.back().peak_bytes, report.back().bytes);
+}
+
+static std::string State(const StationRuntime& rt) {
+    BinaryWriter out;
+    rt.SaveState(out);
+    return out.Data();
+}
+
+TEST(StationRuntime, ForkDivergesWithoutTouchingOriginal) {
+    auto hill = MakeHill(2);
+    StationRuntime rt;
+    rt.StartShift(hill.GetNumberOfPaths());
+
+    OperationInfo op;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(rt.HandleWagon(W(i, WagonType::kFreight), &op));
+    }
+    ASSERT_TRUE(rt.PreparePath(&op));
+    ASSERT_TRUE(rt.AllocateTrain(&op));
+    const std::string before = State(rt);
+
+    // Ветка 1: локомотив забирает вагоны с кольца в поезд
+    StationRuntime with_loco = rt.Fork();
+    ASSERT_TRUE(with_loco.HandleLocomotive(L(LocoType::kElectro16), &op));
+    EXPECT_EQ(op.loco_attached, true);
+    EXPECT_EQ(with_loco.RingTotal(), 0u);
+    ASSERT_TRUE(with_loco.HandleWagon(W(10, WagonType::kFreight), &op));
+    EXPECT_EQ(op.wagon_to_ring, false);
+    EXPECT_EQ(op.train_wagons, 6u);
+
+    // Ветка 2: вагоны продолжают копиться на кольце
+    StationRuntime waiting = rt.Fork();
+    ASSERT_TRUE(waiting.HandleWagon(W(11, WagonType::kFreight), &op));
+    EXPECT_EQ(op.wagon_to_ring, true);
+    EXPECT_EQ(waiting.RingTotal(), 6u);
+
+    // Исходное состояние не изменилось
+    EXPECT_EQ(State(rt), before);
+    EXPECT_EQ(rt.RingTotal(), 5u);
+
+    // ...и продолжает работать независимо от веток
+    ASSERT_TRUE(rt.HandleLocomotive(L(LocoType::kElectro32), &op));
+    EXPECT_EQ(op.train_wagons, 5u);
+    EXPECT_EQ(with_loco.RingTotal(), 0u);
+    EXPECT_EQ(waiting.RingTotal(), 6u);
+}
+
 TEST(SortingHill, ShiftEndForcesSendingAndFreesPaths) {
     using namespace std::literals;
 
@@ -286,3 +753,98 @@ TEST(SortingHill, ShiftEndForcesSendingAndFreesPaths) {
     // После конца смены путь должен быть свободен и доступен к подготовке
     EXPECT_TRUE(hill.CheckEvent(EventType::kPreparePath));
 }
+
+// Четыре поезда с локомотивами (по одному каждого вида) и немного вагонов на кольце.
+static StationRuntime MakeBatchRuntime(const RingLimits& limits) {
+    StationRuntime rt;
+    rt.SetRingLimits(limits);
+    rt.StartShift(4);
+    OperationInfo op;
+    const std::array<LocoType, 4> locos = {LocoType::kElectro16, LocoType::kDiesel24, LocoType::kElectro32,
+                                           LocoType::kDiesel64};
+    for (LocoType loco : locos) {
+        EXPECT_TRUE(rt.PreparePath(&op));
+        EXPECT_TRUE(rt.AllocateTrain(&op));
+        EXPECT_TRUE(rt.HandleLocomotive(L(loco), &op));
+    }
+    for (int i = 0; i < 5; ++i) EXPECT_TRUE(rt.HandleWagon(W(900 + i, WagonType::kDanger), &op));
+    return rt;
+}
+
+static std::vector<Wagon> MakeBatchWagons(size_t count) {
+    const std::array<WagonType, 4> types = {WagonType::kFreight, WagonType::kPass, WagonType::kDanger,
+                                            WagonType::kEmpty};
+    std::vector<Wagon> wagons;
+    for (size_t i = 0; i < count; ++i) {
+        wagons.push_back(W(static_cast<int>(i), types[(i * 7 + i / 5) % types.size()]));
+    }
+    return wagons;
+}
+
+TEST(StationRuntime, WagonBatchMatchesSequentialPlacement) {
+    RingLimits unlimited;
+    RingLimits total;
+    total.total = 300;
+    RingLimits per_kind;
+    per_kind.per_kind = {200, 50, 0, 120};
+
+    auto pool = std::make_shared<LanePool>(3);
+    for (const RingLimits& limits : {unlimited, total, per_kind}) {
+        for (bool parallel : {false, true}) {
+            StationRuntime sequential = MakeBatchRuntime(limits);
+            StationRuntime batched = sequential.Fork();
+            if (parallel) {
+                batched.SetLanePool(pool);
+            }
+            const std::vector<Wagon> wagons = MakeBatchWagons(1000);
+
+            std::vector<OperationInfo> expected;
+            for (const Wagon& wagon : wagons) {
+                OperationInfo op;
+                if (!sequential.HandleWagon(wagon, &op)) break;
+                expected.push_back(op);
+            }
+
+            std::vector<OperationInfo> ops;
+            const size_t accepted = batched.HandleWagonBatch(wagons, &ops);
+            ASSERT_EQ(accepted, expected.size());
+            ASSERT_EQ(ops.size(), expected.size());
+            for (size_t i = 0; i < ops.size(); ++i) {
+                EXPECT_EQ(ops[i].wagon_to_ring, expected[i].wagon_to_ring);
+                EXPECT_EQ(ops[i].ring_total, expected[i].ring_total);
+                EXPECT_EQ(ops[i].ring_max, expected[i].ring_max);
+                EXPECT_EQ(ops[i].train_number, expected[i].train_number);
+                EXPECT_EQ(ops[i].train_wagons, expected[i].train_wagons);
+                EXPECT_EQ(ops[i].message, expected[i].message);
+            }
+            EXPECT_EQ(batched.RingMax(), sequential.RingMax());
+            EXPECT_EQ(State(batched), State(sequential));
+        }
+    }
+}
+
+TEST(SortingHill, WagonBatchCountsAsSeparateCommands) {
+    RingLimits limits;
+    limits.total = 40;
+    auto single = MakeOperatorHill(2, limits);
+    auto batched = MakeOperatorHill(2, limits);
+    for (const Wagon& wagon : MakeBatchWagons(100)) {
+        single.AddWagon(wagon);
+        batched.AddWagon(wagon);
+    }
+    single.HandleEvent(EventType::kShiftStarted);
+    batched.HandleEvent(EventType::kShiftStarted);
+
+    while (single.CheckEvent(EventType::kWagonArrived)) {
+        single.HandleEvent(EventType::kWagonArrived);
+    }
+    EXPECT_EQ(batched.HandleWagonBatch(1000), 40u);
+    EXPECT_EQ(batched.HandleWagonBatch(1000), 0u);
+    EXPECT_TRUE(batched.IsInputThrottled());
+
+    EXPECT_EQ(batched.GetProcessedWagonsCount(), single.GetProcessedWagonsCount());
+    EXPECT_EQ(batched.GetHandledEventsCount(), single.GetHandledEventsCount());
+    EXPECT_EQ(batched.GetRingTotal(), single.GetRingTotal());
+    EXPECT_EQ(batched.GetRingMax(), single.GetRingMax());
+    EXPECT_EQ(batched.GetNumberOfWagBuffer(), 60u);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include "event_scheduler.h"
+#include "random.h"
+#include "sorting_hill.h"
+#include "station_snapshot.h"
+#include "test_helpers.h"
+#include "workload_generator.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// Случайные команды до опустошения буфера, не больше max_events.
+void RunRandomEvents(SortingHill& hill, size_t max_events) {
+    for (size_t handled = 0; hill.IsWagonBuffer() && handled < max_events;) {
+        const EventType event = RandomGen::GetRandomElem<EventType>(kEventsBalanced);
+        if (hill.CheckEvent(event)) {
+            hill.HandleEvent(event);
+            ++handled;
+        }
+    }
+}
+
+} // namespace
+
+TEST(StationSnapshot, RestoredHillContinuesIdentically) {
+    const size_t paths = 4;
+    SortingHill original = MakeOperatorHill(paths);
+    for (int i = 0; i < 500; ++i) {
+        original.AddWagon(Wagon{i, RandomGen::GetRandomElem<WagonType>(kWagonType)});
+    }
+    original.HandleEvent(EventType::kShiftStarted);
+    RunRandomEvents(original, 400);
+
+    const std::string data = SaveSnapshot(original);
+    EXPECT_EQ(GetSnapshotNumberOfPaths(data), paths);
+
+    SortingHill restored = MakeOperatorHill(paths);
+    RestoreSnapshot(restored, data);
+    ExpectSameMetrics(original.GetMetrics(), restored.GetMetrics());
+    // Снимок восстановленной станции совпадает побайтно
+    EXPECT_EQ(SaveSnapshot(restored), data);
+
+    // Генератор тоже восстановлен: обе станции проходят остаток смены одинаково.
+    RunRandomEvents(original, 1000000);
+    original.HandleEvent(EventType::kShiftEnded);
+    const HillMetrics expected = original.GetMetrics();
+
+    RestoreSnapshot(restored, data);
+    RunRandomEvents(restored, 1000000);
+    restored.HandleEvent(EventType::kShiftEnded);
+    ExpectSameMetrics(expected, restored.GetMetrics());
+}
+
+TEST(StationSnapshot, RejectsIncompatibleOrDamagedData) {
+    SortingHill hill = MakeOperatorHill(3);
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.HandleEvent(EventType::kShiftStarted);
+    const std::string data = SaveSnapshot(hill);
+
+    SortingHill other_paths = MakeOperatorHill(5);
+    EXPECT_THROW(RestoreSnapshot(other_paths, data), std::runtime_error);
+
+    SortingHill target = MakeOperatorHill(3);
+    EXPECT_THROW(RestoreSnapshot(target, "XXXX"s + data.substr(4)), std::runtime_error);
+    EXPECT_THROW(RestoreSnapshot(target, data.substr(0, data.size() / 2)), std::runtime_error);
+    EXPECT_THROW(RestoreSnapshot(target, data + "x"s), std::runtime_error);
+}
+
+TEST(StationSnapshot, FailedRestoreLeavesStationUnchanged) {
+    SortingHill source = MakeOperatorHill(3);
+    for (int i = 0; i < 200; ++i) {
+        source.AddWagon(Wagon{i, kWagonType[static_cast<size_t>(i) % kWagonType.size()]});
+    }
+    source.HandleEvent(EventType::kShiftStarted);
+    RunRandomEvents(source, 150);
+    const std::string data = SaveSnapshot(source);
+
+    SortingHill target = MakeOperatorHill(3);
+    for (int i = 1000; i < 1010; ++i) {
+        target.AddWagon(Wagon{i, WagonType::kDanger});
+    }
+    target.HandleEvent(EventType::kShiftStarted);
+    RunRandomEvents(target, 5);
+    const std::string before = SaveSnapshot(target);
+
+    // Ошибка в хвосте снимка обнаруживается уже после секции станции и обработчиков.
+    EXPECT_THROW(RestoreSnapshot(target, data + "x"s), std::runtime_error);
+    EXPECT_THROW(RestoreSnapshot(target, data.substr(0, data.size() - 3)), std::runtime_error);
+    EXPECT_EQ(SaveSnapshot(target), before);
+}
+
+TEST(StationSnapshot, RejectsCountsBeyondData) {
+    SortingHill hill = MakeOperatorHill(2);
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.HandleEvent(EventType::kShiftStarted);
+    std::string data = SaveSnapshot(hill);
+
+    // Число вагонов буфера идёт сразу за заголовком: "STSN", версия, число путей.
+    const size_t buffer_count_offset = 4 + 2 + 4;
+    for (size_t i = 0; i < 8; ++i) {
+        data[buffer_count_offset + i] = '\xFF';
+    }
+    SortingHill target = MakeOperatorHill(2);
+    EXPECT_THROW(RestoreSnapshot(target, data), std::runtime_error);
+}
+
+TEST(StationSnapshot, RestoresGeneratorStates) {
+    WorkloadConfig config;
+    config.seed = 7;
+    WorkloadGenerator workload(config);
+    EventScheduler scheduler(8);
+    for (int i = 0; i < 10; ++i) {
+        workload.NextLocoType();
+        scheduler.Next(0b11111);
+    }
+
+    SortingHill hill = MakeOperatorHill(2);
+    hill.HandleEvent(EventType::kShiftStarted);
+    const std::string data = SaveSnapshot(hill, SnapshotRngs{&workload, &scheduler});
+
+    config.seed = 100;
+    WorkloadGenerator restored_workload(config);
+    EventScheduler restored_scheduler(101);
+    SortingHill restored = MakeOperatorHill(2);
+    RestoreSnapshot(restored, data, SnapshotRngs{&restored_workload, &restored_scheduler});
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(restored_workload.NextLocoType(), workload.NextLocoType());
+        EXPECT_EQ(restored_scheduler.Next(0b11111), scheduler.Next(0b11111));
+    }
+
+    // Снимок без генераторов восстанавливается и в прогон с генераторами: их состояние не трогается.
+    const std::string without_rngs = SaveSnapshot(hill);
+    const auto state = restored_scheduler.GetRngState();
+    RestoreSnapshot(restored, without_rngs, SnapshotRngs{&restored_workload, &restored_scheduler});
+    EXPECT_EQ(restored_scheduler.GetRngState(), state);
+}
+
+TEST(StationSnapshot, FileRoundTrip) {
+    const std::string path = ::testing::TempDir() + "station_snapshot_test.bin";
+    SortingHill hill = MakeOperatorHill(2);
+    for (int i = 0; i < 50; ++i) {
+        hill.AddWagon(Wagon{i, WagonType::kPass});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+    RunRandomEvents(hill, 30);
+
+    WriteSnapshotFile(hill, path);
+    EXPECT_EQ(ReadSnapshotFile(path), SaveSnapshot(hill));
+    EXPECT_THROW(ReadSnapshotFile(path + ".missing"), std::runtime_error);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "common.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// Станция с единственным обработчиком - оператором.
+inline SortingHill MakeOperatorHill(size_t paths, size_t planning_window = 0,
+                                    LocoAssignment loco_assignment = LocoAssignment::kFifo) {
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>(planning_window, loco_assignment));
+    return SortingHill(paths, std::move(handlers));
+}
+
+// То же с ограниченным кольцевым путём.
+inline SortingHill MakeOperatorHill(size_t paths, const RingLimits& limits) {
+    SortingHill hill = MakeOperatorHill(paths);
+    hill.SetRingLimits(limits);
+    return hill;
+}
+
+// Итоговые метрики двух прогонов одной смены совпадают - все поля HillMetrics.
+inline void ExpectSameMetrics(const HillMetrics& a, const HillMetrics& b) {
+    EXPECT_EQ(a.prepared_paths, b.prepared_paths);
+    EXPECT_EQ(a.planned_trains, b.planned_trains);
+    EXPECT_EQ(a.arrived_locos, b.arrived_locos);
+    EXPECT_EQ(a.processed_wagons, b.processed_wagons);
+    EXPECT_EQ(a.sent_trains, b.sent_trains);
+    EXPECT_EQ(a.handled_events, b.handled_events);
+    EXPECT_EQ(a.departed_wagons, b.departed_wagons);
+    EXPECT_EQ(a.throttled_events, b.throttled_events);
+    EXPECT_EQ(a.ring_entries, b.ring_entries);
+    EXPECT_EQ(a.reordered_wagons, b.reordered_wagons);
+    EXPECT_EQ(a.early_departures, b.early_departures);
+
+    EXPECT_EQ(a.open_trains, b.open_trains);
+    EXPECT_EQ(a.busy_paths, b.busy_paths);
+    EXPECT_EQ(a.buffer_wagons, b.buffer_wagons);
+    EXPECT_EQ(a.ring_total, b.ring_total);
+    EXPECT_EQ(a.ring_max, b.ring_max);
+    EXPECT_EQ(a.missed_wagons, b.missed_wagons);
+
+    // Разделы отчёта об окончании смены.
+    ASSERT_EQ(a.memory.size(), b.memory.size());
+    for (size_t i = 0; i < a.memory.size(); ++i) {
+        EXPECT_EQ(a.memory[i].name, b.memory[i].name);
+        EXPECT_EQ(a.memory[i].elements, b.memory[i].elements);
+        EXPECT_EQ(a.memory[i].bytes, b.memory[i].bytes);
+        EXPECT_EQ(a.memory[i].peak_bytes, b.memory[i].peak_bytes);
+    }
+
+    EXPECT_EQ(a.utilization.model_time, b.utilization.model_time);
+    EXPECT_DOUBLE_EQ(a.utilization.elapsed, b.utilization.elapsed);
+    EXPECT_EQ(a.utilization.paths, b.utilization.paths);
+    EXPECT_EQ(a.utilization.loco_reserve_time, b.utilization.loco_reserve_time);
+    EXPECT_EQ(a.utilization.loco_attached_time, b.utilization.loco_attached_time);
+    EXPECT_EQ(a.utilization.departures, b.utilization.departures);
+    EXPECT_EQ(a.utilization.departure_fill_sum, b.utilization.departure_fill_sum);
+
+    EXPECT_EQ(a.dwell.model_time, b.dwell.model_time);
+    const auto expect_same_histograms = [](const std::array<Log2Histogram, 4>& x,
+                                           const std::array<Log2Histogram, 4>& y) {
+        for (size_t k = 0; k < x.size(); ++k) {
+            EXPECT_EQ(x[k].GetCount(), y[k].GetCount());
+            for (size_t i = 0; i < Log2Histogram::kBuckets; ++i) {
+                EXPECT_EQ(x[k].GetBucket(i), y[k].GetBucket(i));
+            }
+        }
+    };
+    expect_same_histograms(a.dwell.station, b.dwell.station);
+    expect_same_histograms(a.dwell.ring, b.dwell.ring);
+}
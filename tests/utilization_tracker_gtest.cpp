@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "utilization_tracker.h"
+#include "sorting_hill.h"
+#include "test_helpers.h"
+#include "common.h"
+
+static size_t StateIndex(PathState state) {
+    return static_cast<size_t>(state);
+}
+
+TEST(UtilizationTracker, AccumulatesPathStatesAndLocos) {
+    UtilizationTracker tracker;
+    tracker.Reset(2, 10.0, /*model_time=*/false);
+
+    tracker.SetPathState(0, PathState::kPreparedIdle, 12.0);
+    tracker.SetPathState(0, PathState::kWaitingLoco, 15.0);
+    tracker.OnLocoReserved(LocoType::kDiesel24, 15.0);
+    tracker.OnLocoAttached(LocoType::kDiesel24, /*from_reserve=*/true, 18.0);
+    tracker.SetPathState(0, PathState::kFilling, 18.0);
+    tracker.OnTrainDeparted(LocoType::kDiesel24, 12, 24, 20.0);
+    tracker.SetPathState(0, PathState::kFree, 20.0);
+
+    const UtilizationReport report = tracker.GetReport(30.0);
+    EXPECT_DOUBLE_EQ(report.elapsed, 20.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kFree)], 2.0 + 10.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kPreparedIdle)], 3.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kWaitingLoco)], 3.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kFilling)], 2.0);
+    EXPECT_DOUBLE_EQ(report.paths[1][StateIndex(PathState::kFree)], 20.0);
+
+    const auto k = static_cast<size_t>(LocoType::kDiesel24);
+    EXPECT_DOUBLE_EQ(report.loco_reserve_time[k], 3.0);
+    EXPECT_DOUBLE_EQ(report.loco_attached_time[k], 2.0);
+    EXPECT_EQ(report.departures[k], 1u);
+    EXPECT_DOUBLE_EQ(report.departure_fill_sum[k], 0.5);
+}
+
+TEST(UtilizationTracker, RestartKeepsStatesAndDropsTotals) {
+    UtilizationTracker tracker;
+    tracker.Reset(1, 0.0, /*model_time=*/false);
+    tracker.SetPathState(0, PathState::kFilling, 5.0);
+    tracker.OnLocoAttached(LocoType::kElectro16, /*from_reserve=*/false, 5.0);
+
+    tracker.Restart(100.0, /*model_time=*/true);
+    const UtilizationReport report = tracker.GetReport(160.0);
+    EXPECT_TRUE(report.model_time);
+    EXPECT_DOUBLE_EQ(report.elapsed, 60.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kFilling)], 60.0);
+    EXPECT_DOUBLE_EQ(report.paths[0][StateIndex(PathState::kFree)], 0.0);
+    EXPECT_DOUBLE_EQ(report.loco_attached_time[static_cast<size_t>(LocoType::kElectro16)], 60.0);
+}
+
+TEST(SortingHill, UtilizationFollowsPathTransitions) {
+    SortingHill hill = MakeOperatorHill(1);
+    for (int i = 0; i < 16; ++i) {
+        hill.AddWagon(Wagon{i, WagonType::kFreight});
+    }
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    hill.HandleEvent(EventType::kPreparePath);         // команда 1: путь подготовлен
+    hill.HandleEvent(EventType::kTrainPlanned);        // 2: поезд ждёт локомотив
+    hill.HandleLocoArrived(LocoType::kElectro16);      // 3: набор
+    for (int i = 0; i < 16; ++i) {
+        hill.HandleEvent(EventType::kWagonArrived);    // 4..19, на 19-й поезд полон
+    }
+    hill.HandleLocoArrived(LocoType::kDiesel64);       // 20: в резерв
+    hill.HandleEvent(EventType::kTrainReady);          // 21: путь свободен
+
+    const UtilizationReport report = hill.GetUtilization();
+    ASSERT_EQ(report.paths.size(), 1u);
+    EXPECT_FALSE(report.model_time);
+    EXPECT_DOUBLE_EQ(report.elapsed, 21.0);
+    const auto& path = report.paths[0];
+    EXPECT_DOUBLE_EQ(path[StateIndex(PathState::kFree)], 1.0);
+    EXPECT_DOUBLE_EQ(path[StateIndex(PathState::kPreparedIdle)], 1.0);
+    EXPECT_DOUBLE_EQ(path[StateIndex(PathState::kWaitingLoco)], 1.0);
+    EXPECT_DOUBLE_EQ(path[StateIndex(PathState::kFilling)], 16.0);
+    EXPECT_DOUBLE_EQ(path[StateIndex(PathState::kFullWaiting)], 2.0);
+
+    EXPECT_DOUBLE_EQ(report.loco_attached_time[static_cast<size_t>(LocoType::kElectro16)], 18.0);
+    EXPECT_DOUBLE_EQ(report.loco_reserve_time[static_cast<size_t>(LocoType::kDiesel64)], 1.0);
+    EXPECT_EQ(report.departures[static_cast<size_t>(LocoType::kElectro16)], 1u);
+    EXPECT_DOUBLE_EQ(report.departure_fill_sum[static_cast<size_t>(LocoType::kElectro16)], 1.0);
+}
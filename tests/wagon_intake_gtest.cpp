@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "station_runtime.h"
+#include "wagon_intake.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(WagonIntake, ManyProducersDeliverEveryWagonOnce) {
+    const int lines = 4;
+    const int per_line = 5000;
+
+    WagonIntake intake(/*capacity=*/64);
+    std::vector<std::thread> producers;
+    for (int line = 0; line < lines; ++line) {
+        producers.emplace_back([&intake, line] {
+            for (int i = 0; i < per_line; ++i) {
+                const WagonType type = kWagonType[static_cast<size_t>(line)];
+                ASSERT_TRUE(intake.Push(Wagon{line * per_line + i, type}));
+            }
+        });
+    }
+
+    std::vector<Wagon> received;
+    std::thread closer([&] {
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        intake.Close();
+    });
+
+    while (!intake.IsExhausted()) {
+        if (intake.Pull(received, 128) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    closer.join();
+
+    ASSERT_EQ(received.size(), static_cast<size_t>(lines * per_line));
+    std::vector<bool> seen(received.size(), false);
+    for (const Wagon& wagon : received) {
+        ASSERT_FALSE(seen[static_cast<size_t>(wagon.number)]);
+        seen[static_cast<size_t>(wagon.number)] = true;
+    }
+    for (WagonType type : kWagonType) {
+        EXPECT_EQ(intake.GetAcceptedWagons(type), static_cast<size_t>(per_line));
+    }
+    EXPECT_FALSE(intake.Push(Wagon{0, WagonType::kFreight}));
+}
+
+TEST(WagonIntake, HillWaitsForExplicitCloseBeforePartialSend) {
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>());
+    SortingHill hill(1, std::move(handlers));
+
+    WagonIntake intake;
+    hill.AttachWagonSource(&intake);
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleEvent(EventType::kLocoArrived);
+
+    ASSERT_TRUE(intake.Push(Wagon{1, WagonType::kFreight}));
+    hill.HandleEvent(EventType::kWagonArrived); // забирает вагон из приёма и ставит в поезд
+
+    // Буфер пуст, но приём не закрыт - вагоны ещё будут, частичную отправку не даём
+    EXPECT_FALSE(hill.IsWagonBuffer());
+    EXPECT_TRUE(hill.HasIncomingWagons());
+    EXPECT_FALSE(hill.CheckEvent(EventType::kTrainReady));
+
+    ASSERT_TRUE(intake.Push(Wagon{2, WagonType::kPass}));
+    intake.Close();
+    EXPECT_TRUE(hill.HasIncomingWagons());
+
+    hill.HandleEvent(EventType::kWagonArrived); // вагон Л уходит на кольцо
+    EXPECT_FALSE(hill.HasIncomingWagons());
+
+    EXPECT_EQ(hill.GetIntakeWagons(WagonType::kFreight), 1u);
+    EXPECT_EQ(hill.GetIntakeWagons(WagonType::kPass), 1u);
+    EXPECT_EQ(hill.GetBufferWagonsLeft(WagonType::kPass), 0u);
+    EXPECT_EQ(hill.GetMissedWagons(WagonType::kPass), 1u);
+}
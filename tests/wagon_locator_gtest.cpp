@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "wagon_locator.h"
+#include "station_runtime.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "common.h"
+#include "test_helpers.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+static SortingHill MakeLocatorHill(size_t paths) {
+    SortingHill hill = MakeOperatorHill(paths);
+    hill.EnableWagonLocator(true);
+    return hill;
+}
+
+TEST(WagonLocator, QueuePositionsShiftAsHeadIsPopped) {
+    WagonLocator locator;
+    locator.OnBufferPush(10);
+    locator.OnBufferPush(11);
+    locator.OnRingPush(20, WagonType::kPass);
+    locator.OnRingPush(21, WagonType::kPass);
+    locator.OnRingPush(22, WagonType::kEmpty);
+
+    EXPECT_EQ(locator.Locate(11)->position, 1u);
+    locator.OnBufferPop();
+    EXPECT_EQ(locator.Locate(11)->position, 0u);
+
+    locator.OnRingPop(WagonType::kPass);
+    locator.OnTrainPlanned(1, "Л-1");
+    locator.OnTrainPush(20, 1, 0);
+    const std::optional<WagonLocation> ring = locator.Locate(21);
+    ASSERT_TRUE(ring);
+    EXPECT_EQ(ring->place, WagonPlace::kRing);
+    EXPECT_EQ(ring->ring_kind, WagonType::kPass);
+    EXPECT_EQ(ring->position, 0u);
+    EXPECT_EQ(locator.Locate(22)->position, 0u);
+
+    const std::optional<WagonLocation> train = locator.Locate(20);
+    ASSERT_TRUE(train);
+    EXPECT_EQ(train->place, WagonPlace::kTrain);
+    EXPECT_EQ(train->train_number, "Л-1");
+
+    locator.OnTrainDeparted(1, {Wagon{20, WagonType::kPass}});
+    EXPECT_EQ(locator.Locate(20)->place, WagonPlace::kDeparted);
+    EXPECT_EQ(locator.Locate(20)->train_number, "Л-1");
+
+    locator.Forget(22);
+    EXPECT_FALSE(locator.Locate(22));
+    EXPECT_FALSE(locator.Locate(99));
+}
+
+TEST(WagonLocator, FollowsWagonThroughStation) {
+    auto hill = MakeLocatorHill(1);
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.AddWagon(Wagon{2, WagonType::kFreight});
+    hill.HandleEvent(EventType::kShiftStarted);
+
+    ASSERT_TRUE(hill.LocateWagon(2));
+    EXPECT_EQ(hill.LocateWagon(2)->place, WagonPlace::kBuffer);
+    EXPECT_EQ(hill.LocateWagon(2)->position, 1u);
+
+    // Поездов нет: оба вагона уходят на кольцо.
+    hill.HandleEvent(EventType::kWagonArrived);
+    hill.HandleEvent(EventType::kWagonArrived);
+    ASSERT_TRUE(hill.LocateWagon(2));
+    EXPECT_EQ(hill.LocateWagon(2)->place, WagonPlace::kRing);
+    EXPECT_EQ(hill.LocateWagon(2)->ring_kind, WagonType::kFreight);
+    EXPECT_EQ(hill.LocateWagon(2)->position, 1u);
+
+    hill.HandleEvent(EventType::kPreparePath);
+    hill.HandleEvent(EventType::kTrainPlanned);
+    hill.HandleLocoArrived(LocoType::kElectro16);
+    const std::optional<WagonLocation> in_train = hill.LocateWagon(2);
+    ASSERT_TRUE(in_train);
+    EXPECT_EQ(in_train->place, WagonPlace::kTrain);
+    EXPECT_EQ(in_train->position, 1u);
+    EXPECT_FALSE(in_train->train_number.empty());
+
+    hill.HandleEvent(EventType::kTrainReady);
+    const std::optional<WagonLocation> departed = hill.LocateWagon(2);
+    ASSERT_TRUE(departed);
+    EXPECT_EQ(departed->place, WagonPlace::kDeparted);
+    EXPECT_EQ(departed->train_number, in_train->train_number);
+}
+
+TEST(WagonLocator, DisabledIndexAnswersNothing) {
+    auto hill = MakeLocatorHill(1);
+    hill.AddWagon(Wagon{1, WagonType::kFreight});
+    hill.EnableWagonLocator(false);
+    EXPECT_FALSE(hill.HasWagonLocator());
+    EXPECT_FALSE(hill.LocateWagon(1));
+
+    // Включение посреди смены: вагоны буфера индексируются сразу.
+    hill.EnableWagonLocator(true);
+    ASSERT_TRUE(hill.LocateWagon(1));
+    EXPECT_EQ(hill.LocateWagon(1)->place, WagonPlace::kBuffer);
+}
+
+TEST(WagonLocator, ForkDoesNotTouchIndex) {
+    WagonLocator locator;
+    StationRuntime rt;
+    rt.SetWagonLocator(&locator);
+    rt.StartShift(1);
+    OperationInfo op;
+    ASSERT_TRUE(rt.HandleWagon(Wagon{5, WagonType::kDanger}, &op));
+    ASSERT_EQ(locator.Size(), 1u);
+
+    StationRuntime copy = rt.Fork();
+    ASSERT_TRUE(copy.HandleWagon(Wagon{6, WagonType::kDanger}, &op));
+    EXPECT_EQ(locator.Size(), 1u);
+    EXPECT_FALSE(locator.Locate(6));
+}
+
+TEST(WagonLocator, BatchIndexMatchesSequentialPlacement) {
+    const std::array<WagonType, 4> types = {WagonType::kFreight, WagonType::kPass, WagonType::kDanger,
+                                            WagonType::kEmpty};
+    std::vector<Wagon> wagons;
+    for (int i = 0; i < 600; ++i) {
+        wagons.push_back(Wagon{i, types[static_cast<size_t>(i * 7 + i / 5) % types.size()]});
+    }
+
+    // Одинаковые станции с тремя поездами под локомотивами, каждая со своим индексом.
+    const auto make_runtime = [](WagonLocator* locator) {
+        StationRuntime rt;
+        rt.SetWagonLocator(locator);
+        rt.StartShift(4);
+        OperationInfo op;
+        const std::array<LocoType, 3> locos = {LocoType::kElectro16, LocoType::kDiesel24, LocoType::kDiesel64};
+        for (LocoType loco : locos) {
+            EXPECT_TRUE(rt.PreparePath(&op));
+            EXPECT_TRUE(rt.AllocateTrain(&op));
+            EXPECT_TRUE(rt.HandleLocomotive(Locomotive{loco}, &op));
+        }
+        return rt;
+    };
+    WagonLocator sequential_index;
+    WagonLocator batched_index;
+    StationRuntime sequential = make_runtime(&sequential_index);
+    StationRuntime batched = make_runtime(&batched_index);
+
+    OperationInfo op;
+    for (const Wagon& wagon : wagons) {
+        ASSERT_TRUE(sequential.HandleWagon(wagon, &op));
+    }
+    std::vector<OperationInfo> ops;
+    ASSERT_EQ(batched.HandleWagonBatch(wagons, &ops), wagons.size());
+
+    for (const Wagon& wagon : wagons) {
+        const std::optional<WagonLocation> expected = sequential_index.Locate(wagon.number);
+        const std::optional<WagonLocation> actual = batched_index.Locate(wagon.number);
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(actual);
+        EXPECT_EQ(actual->place, expected->place);
+        EXPECT_EQ(actual->position, expected->position);
+        EXPECT_EQ(actual->ring_kind, expected->ring_kind);
+        EXPECT_EQ(actual->train_number, expected->train_number);
+    }
+}
+
+TEST(WagonLocator, TrainNumberMemoryIsTrackedIncrementally) {
+    const auto number_bytes = [](const WagonLocator& locator) {
+        std::vector<MemoryEntry> report;
+        locator.CollectMemory(report);
+        return report.at(1).bytes;
+    };
+
+    WagonLocator short_numbers;
+    short_numbers.OnTrainPlanned(1, "Г-1");
+    short_numbers.OnTrainPlanned(2, "Л-2");
+
+    WagonLocator locator;
+    locator.OnTrainPlanned(1, std::string(100, 'G'));
+    locator.OnTrainPlanned(2, "Л-2");
+    EXPECT_GE(number_bytes(locator), number_bytes(short_numbers) + 100);
+
+    locator.Clear();
+    locator.OnTrainPlanned(1, "Г-1");
+    locator.OnTrainPlanned(2, "Л-2");
+    EXPECT_EQ(number_bytes(locator), number_bytes(short_numbers));
+}
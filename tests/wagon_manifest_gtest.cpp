@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "wagon_manifest.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(WagonManifest, CsvConvertsAndStreamsBack) {
+    const std::string path = ::testing::TempDir() + "wagon_manifest_csv.bin";
+
+    std::istringstream csv("номер,тип\n17,Г\n18, Л\n\n19,2\n20,П\n");
+    EXPECT_EQ(ConvertCsvToManifest(csv, path), 4u);
+
+    ManifestSource source(path);
+    EXPECT_EQ(source.GetWagonsCount(), 4u);
+
+    std::vector<Wagon> wagons;
+    EXPECT_EQ(source.Pull(wagons, 3), 3u);
+    EXPECT_FALSE(source.IsExhausted());
+    EXPECT_EQ(source.Pull(wagons, 3), 1u);
+    EXPECT_TRUE(source.IsExhausted());
+
+    ASSERT_EQ(wagons.size(), 4u);
+    EXPECT_EQ(wagons[0].number, 17);
+    EXPECT_EQ(wagons[0].wagon_type, WagonType::kFreight);
+    EXPECT_EQ(wagons[1].wagon_type, WagonType::kPass);
+    EXPECT_EQ(wagons[2].wagon_type, WagonType::kDanger);
+    EXPECT_EQ(wagons[3].wagon_type, WagonType::kEmpty);
+}
+
+TEST(WagonManifest, CsvErrorReportsLine) {
+    const std::string path = ::testing::TempDir() + "wagon_manifest_bad.bin";
+    std::istringstream csv("1,Г\n2,X\n");
+    EXPECT_THROW(ConvertCsvToManifest(csv, path), std::runtime_error);
+}
+
+TEST(WagonManifest, HillConsumesLargeManifestInChunks) {
+    const std::string path = ::testing::TempDir() + "wagon_manifest_large.bin";
+    const int count = 10000;
+    {
+        ManifestWriter writer(path);
+        for (int i = 0; i < count; ++i) {
+            writer.Add(Wagon{i, kWagonType[static_cast<size_t>(i % 4)]});
+        }
+    }
+
+    ManifestSource source(path);
+    ASSERT_EQ(source.GetWagonsCount(), static_cast<size_t>(count));
+
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>());
+    SortingHill hill(2, std::move(handlers));
+    hill.AttachWagonSource(&source);
+
+    hill.HandleEvent(EventType::kShiftStarted);
+    // Во входном буфере только первая порция, а не вся ведомость
+    EXPECT_LT(hill.GetNumberOfWagBuffer(), static_cast<size_t>(count));
+
+    size_t max_buffer = 0;
+    while (hill.HasIncomingWagons()) {
+        hill.HandleEvent(EventType::kWagonArrived);
+        max_buffer = std::max(max_buffer, hill.GetNumberOfWagBuffer());
+    }
+    hill.HandleEvent(EventType::kShiftEnded);
+
+    EXPECT_LE(max_buffer, 512u);
+    EXPECT_EQ(hill.GetProcessedWagonsCount(), static_cast<size_t>(count));
+    EXPECT_EQ(source.GetDeliveredCount(), static_cast<size_t>(count));
+    EXPECT_EQ(hill.GetRingTotal(), static_cast<size_t>(count));
+}
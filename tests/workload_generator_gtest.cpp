@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include "alias_table.h"
+#include "fast_rng.h"
+#include "random.h"
+#include "workload_generator.h"
+
+#include <array>
+#include <limits>
+#include <vector>
+
+TEST(AliasTable, FollowsWeightsAndSkipsZero) {
+    const AliasTable table({1.0, 0.0, 3.0});
+    FastRng rng(7);
+
+    std::array<size_t, 3> counts{};
+    const size_t n = 400000;
+    for (size_t i = 0; i < n; ++i) {
+        counts[table.Sample(rng.Next())]++;
+    }
+
+    EXPECT_EQ(counts[1], 0u);
+    EXPECT_NEAR(static_cast<double>(counts[0]) / n, 0.25, 0.01);
+    EXPECT_NEAR(static_cast<double>(counts[2]) / n, 0.75, 0.01);
+}
+
+TEST(WorkloadGenerator, SameSeedSameStream) {
+    WorkloadConfig config;
+    config.seed = 42;
+    config.mean_consist_length = 4.0;
+
+    WorkloadGenerator a(config);
+    WorkloadGenerator b(config);
+    const auto wa = a.GenerateWagons(1000);
+    const auto wb = b.GenerateWagons(1000);
+    for (size_t i = 0; i < wa.size(); ++i) {
+        ASSERT_EQ(wa[i].number, wb[i].number);
+        ASSERT_EQ(wa[i].wagon_type, wb[i].wagon_type);
+    }
+    EXPECT_EQ(wa.front().number, 0);
+    EXPECT_EQ(wa.back().number, 999);
+}
+
+TEST(WorkloadGenerator, WagonNumbersWrapAfterIntMax) {
+    WorkloadConfig config;
+    config.seed = 5;
+    config.first_wagon_number = std::numeric_limits<int>::max() - 1;
+    config.mean_consist_length = 3.0;
+
+    WorkloadGenerator gen(config);
+    const auto wagons = gen.GenerateWagons(4);
+    EXPECT_EQ(wagons[0].number, std::numeric_limits<int>::max() - 1);
+    EXPECT_EQ(wagons[1].number, std::numeric_limits<int>::max());
+    EXPECT_EQ(wagons[2].number, 0);
+    EXPECT_EQ(wagons[3].number, 1);
+}
+
+TEST(RandomGen, SeedMakesRunParametersReproducible) {
+    RandomGen::Seed(77);
+    std::vector<int> first;
+    for (int i = 0; i < 8; ++i) {
+        first.push_back(RandomGen::GetInRange(0, 89999999));
+    }
+    RandomGen::Seed(77);
+    for (int value : first) {
+        EXPECT_EQ(RandomGen::GetInRange(0, 89999999), value);
+    }
+}
+
+TEST(WorkloadGenerator, SkewedMixAndConsists) {
+    WorkloadConfig config;
+    config.seed = 3;
+    config.wagon_type_weights = {6.0, 2.0, 0.0, 2.0};
+    config.mean_consist_length = 8.0;
+
+    WorkloadGenerator gen(config);
+    const auto wagons = gen.GenerateWagons(200000);
+
+    std::array<size_t, 4> counts{};
+    size_t runs = 1;
+    for (size_t i = 0; i < wagons.size(); ++i) {
+        counts[static_cast<size_t>(wagons[i].wagon_type)]++;
+        if (i > 0 && wagons[i].wagon_type != wagons[i - 1].wagon_type) {
+            ++runs;
+        }
+    }
+
+    EXPECT_EQ(counts[static_cast<size_t>(WagonType::kDanger)], 0u);
+    EXPECT_NEAR(static_cast<double>(counts[0]) / wagons.size(), 0.6, 0.03);
+
+    // Группа может продолжиться тем же типом, поэтому средняя длина серии не меньше 8
+    const double mean_run = static_cast<double>(wagons.size()) / static_cast<double>(runs);
+    EXPECT_GT(mean_run, 7.0);
+}
+
+TEST(WorkloadGenerator, DiurnalScheduleModulatesWagonArrivals) {
+    WorkloadConfig config;
+    config.seed = 5;
+    config.diurnal_amplitude = 0.9;
+    config.day_length = 1000;
+
+    WorkloadGenerator gen(config);
+    const auto events = gen.GenerateEvents(100000);
+
+    // Первая половина суток - "день" (sin > 0), вторая - "ночь"
+    size_t day = 0;
+    size_t night = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i] == EventType::kWagonArrived) {
+            ((i % 1000) < 500 ? day : night)++;
+        }
+        ASSERT_NE(events[i], EventType::kShiftStarted);
+        ASSERT_NE(events[i], EventType::kShiftEnded);
+    }
+    EXPECT_GT(day, night * 3 / 2);
+}
+
+TEST(WorkloadGenerator, LocoMix) {
+    WorkloadConfig config;
+    config.loco_type_weights = {0.0, 0.0, 0.0, 1.0};
+
+    WorkloadGenerator gen(config);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(gen.NextLocoType(), LocoType::kDiesel64);
+    }
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include "stealing_queue.h"
+#include "workload_generator.h"
+#include "yard_coordinator.h"
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<Wagon> MakeWagons(size_t count, std::uint64_t seed) {
+    WorkloadConfig workload;
+    workload.seed = seed;
+    workload.first_wagon_number = 1;
+    return WorkloadGenerator(workload).GenerateWagons(count);
+}
+
+} // namespace
+
+TEST(StealingQueue, KeepsOrderAndCapacity) {
+    StealingQueue<int> queue(3);
+    EXPECT_EQ(queue.Capacity(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.TryPush(i));
+    }
+    EXPECT_FALSE(queue.TryPush(4));
+    EXPECT_EQ(queue.SizeApprox(), 4u);
+
+    int value = -1;
+    ASSERT_TRUE(queue.TryTake(value));
+    EXPECT_EQ(value, 0);
+
+    int batch[8] = {};
+    EXPECT_EQ(queue.TakeBatch(batch, 8), 3u);
+    EXPECT_EQ(batch[0], 1);
+    EXPECT_EQ(batch[2], 3);
+    EXPECT_FALSE(queue.TryTake(value));
+
+    // Место освободилось - можно писать по кругу.
+    EXPECT_TRUE(queue.TryPush(5));
+    ASSERT_TRUE(queue.TryTake(value));
+    EXPECT_EQ(value, 5);
+}
+
+TEST(StealingQueue, ConcurrentTakersGetEveryItemOnce) {
+    constexpr int kItems = 50000;
+    StealingQueue<int> queue(256);
+    std::atomic<bool> done = false;
+    std::vector<std::vector<int>> taken(3);
+
+    std::vector<std::thread> takers;
+    for (auto& out : taken) {
+        takers.emplace_back([&queue, &done, &out] {
+            int batch[4];
+            while (true) {
+                const bool finished = done.load();
+                const size_t count = queue.TakeBatch(batch, 4);
+                out.insert(out.end(), batch, batch + count);
+                if (count == 0) {
+                    if (finished) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kItems; ++i) {
+        while (!queue.TryPush(i)) {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (auto& taker : takers) {
+        taker.join();
+    }
+
+    std::vector<char> seen(kItems, 0);
+    for (const auto& out : taken) {
+        for (size_t i = 1; i < out.size(); ++i) {
+            ASSERT_LT(out[i - 1], out[i]); // каждый получает элементы в порядке поступления
+        }
+        for (int item : out) {
+            ASSERT_EQ(seen[item], 0);
+            seen[item] = 1;
+        }
+    }
+    EXPECT_EQ(std::accumulate(seen.begin(), seen.end(), 0), kItems);
+}
+
+TEST(YardCoordinator, AllWagonsLeaveTheYard) {
+    YardConfig config;
+    config.humps = 3;
+    config.paths_per_hump = 6;
+    config.adaptive_dispatcher = true;
+    const std::vector<Wagon> wagons = MakeWagons(3000, 7);
+
+    const YardReport report = YardCoordinator(config).Run(wagons);
+    ASSERT_EQ(report.humps.size(), 3u);
+
+    size_t processed = 0;
+    size_t taken = 0;
+    for (const HumpReport& hump : report.humps) {
+        processed += hump.metrics.processed_wagons;
+        taken += hump.own_wagons + hump.stolen_wagons;
+        EXPECT_GT(hump.metrics.sent_trains, 0u);
+    }
+    EXPECT_EQ(taken, wagons.size());
+    EXPECT_EQ(processed, wagons.size());
+    // На кольце к концу смены могут остаться вагоны без поезда.
+    EXPECT_LE(report.departed_wagons, wagons.size());
+    EXPECT_GT(report.departed_wagons, 0u);
+}
+
+TEST(YardCoordinator, OwnAndStolenWagonsAddUp) {
+    // Маленькая порция горки оставляет вагоны в очередях, доступными для кражи.
+    YardConfig config;
+    config.humps = 2;
+    config.paths_per_hump = 12;
+    config.hump_batch = 4;
+    config.queue_capacity = 8192;
+    const std::vector<Wagon> wagons = MakeWagons(4000, 11);
+
+    const YardReport report = YardCoordinator(config).Run(wagons);
+    size_t taken = 0;
+    for (const HumpReport& hump : report.humps) {
+        taken += hump.own_wagons + hump.stolen_wagons;
+    }
+    EXPECT_EQ(taken, wagons.size());
+    EXPECT_EQ(report.stolen_wagons, report.humps[0].stolen_wagons + report.humps[1].stolen_wagons);
+}
+
+TEST(YardCoordinator, RejectsEmptyYard) {
+    YardConfig config;
+    config.humps = 0;
+    EXPECT_THROW(YardCoordinator{config}, std::invalid_argument);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "sorting_hill.h"
+#include "workload_generator.h"
+#include "yard_network.h"
+
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+std::vector<Wagon> MakeWagons(size_t count) {
+    WorkloadConfig workload;
+    workload.seed = 3;
+    workload.first_wagon_number = 1;
+    return WorkloadGenerator(workload).GenerateWagons(count);
+}
+
+size_t PullAll(TransitSource& source, std::vector<Wagon>& out) {
+    return source.Pull(out, 1000);
+}
+
+} // namespace
+
+TEST(TransitSource, ReleasesShipmentsAfterDelay) {
+    TransitSource source(/*links=*/2, /*transit_delay=*/5);
+    std::vector<Wagon> out;
+
+    source.Ship(0, {Wagon{1, WagonType::kFreight}, Wagon{2, WagonType::kPass}});
+    EXPECT_EQ(PullAll(source, out), 0u); // получен в момент 0, прибудет в 5
+    EXPECT_EQ(source.GetReceivedWagons(), 2u);
+
+    source.SetClock(4);
+    source.Ship(1, {Wagon{3, WagonType::kEmpty}});
+    EXPECT_EQ(PullAll(source, out), 0u);
+    source.SetClock(5);
+    EXPECT_EQ(source.GetReadyWagons(), 2u);
+    EXPECT_EQ(PullAll(source, out), 2u);
+    EXPECT_EQ(out[1].number, 2);
+
+    source.Close(0);
+    source.Close(1);
+    EXPECT_FALSE(source.IsExhausted());
+    source.SetClock(9);
+    EXPECT_EQ(source.Pull(out, 1), 1u);
+    EXPECT_EQ(out.back().number, 3);
+    EXPECT_TRUE(source.IsExhausted());
+}
+
+TEST(TransitSource, OriginArrivesByInterval) {
+    TransitSource source(/*links=*/0, /*transit_delay=*/0);
+    source.AddOrigin(MakeWagons(5), /*interval=*/3);
+    std::vector<Wagon> out;
+
+    EXPECT_EQ(PullAll(source, out), 1u);
+    source.SetClock(7);
+    EXPECT_EQ(source.GetReadyWagons(), 2u);
+    EXPECT_EQ(PullAll(source, out), 2u);
+    source.SetClock(12);
+    EXPECT_EQ(PullAll(source, out), 2u);
+    EXPECT_TRUE(source.IsExhausted());
+}
+
+TEST(YardNetwork, CorridorDeliversDepartedTrainsDownstream) {
+    const std::vector<Wagon> wagons = MakeWagons(1500);
+    NetworkConfig config = MakeCorridor({6, 4, 8}, /*transit_delay=*/20, wagons, /*origin_interval=*/1);
+    config.adaptive_dispatcher = true;
+
+    const NetworkReport report = YardNetwork(std::move(config)).Run();
+    ASSERT_EQ(report.stations.size(), 3u);
+
+    // Каждая станция получает ровно то, что вывезла предыдущая.
+    for (size_t i = 1; i < report.stations.size(); ++i) {
+        EXPECT_EQ(report.stations[i].received_wagons, report.stations[i - 1].metrics.departed_wagons);
+        EXPECT_LE(report.stations[i].metrics.processed_wagons, report.stations[i].received_wagons);
+    }
+    EXPECT_EQ(report.stations[0].metrics.processed_wagons, wagons.size());
+    EXPECT_GT(report.delivered_wagons, 0u);
+    EXPECT_EQ(report.delivered_wagons, report.stations[2].metrics.departed_wagons);
+    EXPECT_LT(report.bottleneck, 3u);
+}
+
+TEST(YardNetwork, RejectsBackwardLinks) {
+    NetworkConfig config;
+    config.stations.resize(2);
+    config.stations[1].downstream = 0;
+    EXPECT_THROW(YardNetwork{config}, std::invalid_argument);
+}
+
+TEST(YardNetwork, FailingStationStopsTheNetwork) {
+    NetworkConfig config = MakeCorridor({6, 4, 8}, /*transit_delay=*/0, MakeWagons(3000), /*origin_interval=*/0);
+    config.adaptive_dispatcher = true;
+    // Линия на один состав: без остановки первая станция ждала бы места в ней вечно.
+    config.link_capacity = 1;
+    config.stations[1].configure = [](SortingHill&) {
+        throw std::runtime_error("станция не запустилась");
+    };
+
+    EXPECT_THROW(YardNetwork(std::move(config)).Run(), std::runtime_error);
+}
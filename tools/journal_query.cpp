@@ -0,0 +1,81 @@
+#include "common.h"
+#include "operation_journal.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Запросы к журналу операций OperationJournal.
+//   journal_query FILE summary         - число операций по типам
+//   journal_query FILE ring [N]        - максимум заполнения кольца в окнах по N операций
+//   journal_query FILE trains          - вагонов в каждом отправленном поезде: смена, поезд, вагонов
+namespace {
+
+void PrintUsage() {
+    std::cerr << "Использование: journal_query FILE summary | ring [N] | trains" << std::endl;
+}
+
+void PrintSummary(const JournalReader& reader) {
+    const auto all = reader.CountEvents(/*successful_only=*/false);
+    const auto ok = reader.CountEvents(/*successful_only=*/true);
+
+    std::cout << "Операций: " << reader.GetRowsCount() << '\n';
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (all[i] == 0) {
+            continue;
+        }
+        std::cout << static_cast<EventType>(i) << ": " << ok[i] << " успешно из " << all[i] << '\n';
+    }
+}
+
+void PrintRing(const JournalReader& reader, size_t bucket_rows) {
+    const auto series = reader.RingOccupancy(bucket_rows);
+    for (size_t i = 0; i < series.size(); ++i) {
+        std::cout << i * bucket_rows << '\t' << series[i] << '\n';
+    }
+}
+
+void PrintTrains(const JournalReader& reader) {
+    size_t trains = 0;
+    size_t wagons = 0;
+    for (const auto& [train, train_wagons] : reader.WagonsPerTrain()) {
+        std::cout << train.first << '\t' << train.second << '\t' << train_wagons << '\n';
+        ++trains;
+        wagons += static_cast<size_t>(train_wagons);
+    }
+    if (trains > 0) {
+        std::cout << "Поездов: " << trains << ", в среднем вагонов: "
+                  << static_cast<double>(wagons) / static_cast<double>(trains) << '\n';
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        PrintUsage();
+        return 1;
+    }
+
+    try {
+        const JournalReader reader(argv[1]);
+        const std::string query = argv[2];
+
+        if (query == "summary") {
+            PrintSummary(reader);
+        } else if (query == "ring") {
+            const size_t bucket = argc > 3 ? std::stoul(argv[3]) : 100;
+            PrintRing(reader, bucket == 0 ? 1 : bucket);
+        } else if (query == "trains") {
+            PrintTrains(reader);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    } catch (const std::exception& exc) {
+        std::cerr << "Ошибка: " << exc.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
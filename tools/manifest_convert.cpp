@@ -0,0 +1,29 @@
+#include "wagon_manifest.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// Преобразование CSV-ведомости "номер,тип" в двоичную ведомость для train_app --manifest.
+//   manifest_convert IN.csv OUT.bin
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Использование: manifest_convert IN.csv OUT.bin" << std::endl;
+        return 1;
+    }
+
+    std::ifstream csv(argv[1]);
+    if (!csv) {
+        std::cerr << "Не удалось открыть файл: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    try {
+        const size_t count = ConvertCsvToManifest(csv, argv[2]);
+        std::cout << "Записано вагонов: " << count << std::endl;
+    } catch (const std::exception& exc) {
+        std::cerr << "Ошибка: " << exc.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
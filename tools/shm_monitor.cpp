@@ -0,0 +1,55 @@
+#include "shared_metrics.h"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Просмотр метрик работающей станции (train_app --shm=NAME) из другого процесса.
+//   shm_monitor NAME [INTERVAL_MS=500] [COUNT=0]
+// COUNT = 0 - до завершения смены.
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        std::cerr << "Использование: shm_monitor NAME [INTERVAL_MS=500] [COUNT=0]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const std::chrono::milliseconds interval(argc > 2 ? std::stoul(argv[2]) : 500);
+        const size_t count = argc > 3 ? std::stoul(argv[3]) : 0;
+
+        const SharedMetricsReader reader(argv[1]);
+        bool seen_active = false;
+        for (size_t i = 0; count == 0 || i < count; ++i) {
+            if (i > 0) {
+                std::this_thread::sleep_for(interval);
+            }
+
+            SharedHillState state;
+            if (!reader.TryRead(state)) {
+                std::cerr << "Не удалось получить согласованный снимок" << std::endl;
+                continue;
+            }
+            std::cout << "поездов: " << state.sent_trains
+                      << " открыто: " << state.open_trains
+                      << " путей занято: " << state.busy_paths
+                      << " кольцо: " << state.ring_total << " (макс " << state.ring_max << ")"
+                      << " пропущено Г/Л/О/П: " << state.missed_wagons[0] << '/' << state.missed_wagons[1]
+                      << '/' << state.missed_wagons[2] << '/' << state.missed_wagons[3]
+                      << " вагонов: " << state.processed_wagons
+                      << " в буфере: " << state.buffer_wagons
+                      << " команд: " << state.handled_events
+                      << (state.shift_active ? "" : " [смена не идёт]") << std::endl;
+
+            seen_active = seen_active || state.shift_active;
+            if (count == 0 && seen_active && !state.shift_active) {
+                break;
+            }
+        }
+    } catch (const std::exception& exc) {
+        std::cerr << "Ошибка: " << exc.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
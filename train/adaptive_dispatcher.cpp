@@ -0,0 +1,31 @@
+#include "adaptive_dispatcher.h"
+#include "sorting_hill.h"
+
+std::optional<EventType> AdaptiveDispatcher::NextEvent(const SortingHill& sorting_hill, EventMask allowed) {
+    const auto can = [&](EventType event) {
+        return (allowed & EventBit(event)) != 0 && sorting_hill.CheckEvent(event);
+    };
+
+    // Полный поезд (или частичный, когда вагонов больше не будет) сразу освобождает путь.
+    if (can(EventType::kTrainReady)) {
+        return EventType::kTrainReady;
+    }
+    // Поезд без локомотива не принимает вагоны - вагоны его вида уходят на кольцо.
+    if (can(EventType::kLocoArrived)) {
+        return EventType::kLocoArrived;
+    }
+
+    // Пути готовятся и занимаются поездами заранее, пока есть вагоны для них.
+    const bool has_demand = sorting_hill.HasIncomingWagons() || sorting_hill.GetRingTotal() > 0;
+    if (has_demand && can(EventType::kTrainPlanned)) {
+        return EventType::kTrainPlanned;
+    }
+    if (has_demand && can(EventType::kPreparePath)) {
+        return EventType::kPreparePath;
+    }
+
+    if (can(EventType::kWagonArrived)) {
+        return EventType::kWagonArrived;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "dispatcher.h"
+
+// Дежурный, отдающий команды по состоянию станции, а не случайно:
+// отправляет поезд, как только это возможно, требует локомотив для поезда без него,
+// держит пути подготовленными и занятыми поездами, пока есть вагоны, и только затем
+// подаёт следующий вагон на горку. Служит верхней оценкой пропускной способности
+// для сравнения правил оператора.
+class AdaptiveDispatcher : public Dispatcher {
+public:
+    using Dispatcher::NextEvent;
+    std::optional<EventType> NextEvent(const SortingHill& sorting_hill, EventMask allowed) override;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Таблица псевдонимов Уолкера: выбор индекса с заданными весами за O(1)
+// по одному 64-битному случайному числу. Построение - O(n).
+class AliasTable {
+public:
+    AliasTable() = default;
+
+    explicit AliasTable(const std::vector<double>& weights) {
+        Build(weights);
+    }
+
+    // Веса неотрицательные; нулевой вес - индекс никогда не выбирается.
+    // Если все веса нулевые, таблица пуста (Empty() == true).
+    void Build(const std::vector<double>& weights) {
+        const size_t n = weights.size();
+        threshold_.assign(n, 0);
+        alias_.assign(n, 0);
+
+        double total = 0.0;
+        for (double w : weights) {
+            if (w < 0.0) {
+                throw std::invalid_argument("Вес не может быть отрицательным");
+            }
+            total += w;
+        }
+        empty_ = (n == 0 || total <= 0.0);
+        if (empty_) {
+            return;
+        }
+
+        std::vector<double> scaled(n);
+        std::vector<std::uint32_t> small;
+        std::vector<std::uint32_t> large;
+        for (size_t i = 0; i < n; ++i) {
+            scaled[i] = weights[i] * static_cast<double>(n) / total;
+            alias_[i] = static_cast<std::uint32_t>(i);
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+        }
+
+        while (!small.empty() && !large.empty()) {
+            const std::uint32_t s = small.back();
+            small.pop_back();
+            const std::uint32_t l = large.back();
+
+            threshold_[s] = ToThreshold_(scaled[s]);
+            alias_[s] = l;
+
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Остатки из-за погрешности округления - вероятность 1 (кроме нулевых весов).
+        std::uint32_t positive = 0;
+        while (weights[positive] <= 0.0) {
+            ++positive;
+        }
+        for (std::uint32_t i : large) {
+            threshold_[i] = kAlways;
+        }
+        for (std::uint32_t i : small) {
+            if (weights[i] > 0.0) {
+                threshold_[i] = kAlways;
+            } else {
+                threshold_[i] = 0;
+                alias_[i] = positive;
+            }
+        }
+    }
+
+    bool Empty() const {
+        return empty_;
+    }
+
+    size_t Size() const {
+        return threshold_.size();
+    }
+
+    // r - равномерное 64-битное число: старшие 32 бита выбирают столбец, младшие - монетку.
+    size_t Sample(std::uint64_t r) const {
+        const auto column = static_cast<size_t>(((r >> 32) * threshold_.size()) >> 32);
+        const auto coin = static_cast<std::uint32_t>(r);
+        return coin < threshold_[column] || threshold_[column] == kAlways ? column : alias_[column];
+    }
+
+private:
+    static constexpr std::uint32_t kAlways = 0xFFFFFFFFu;
+
+    static std::uint32_t ToThreshold_(double p) {
+        if (p >= 1.0) {
+            return kAlways;
+        }
+        return static_cast<std::uint32_t>(p * 4294967296.0);
+    }
+
+private:
+    std::vector<std::uint32_t> threshold_;
+    std::vector<std::uint32_t> alias_;
+    bool empty_ = true;
+};
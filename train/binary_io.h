@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Запись и чтение двоичных форматов станции.
+// Числа хранятся в little-endian независимо от платформы.
+class BinaryWriter {
+public:
+    void WriteU8(std::uint8_t v) {
+        data_.push_back(static_cast<char>(v));
+    }
+
+    void WriteU16(std::uint16_t v) {
+        WriteLe_(v, 2);
+    }
+
+    void WriteU32(std::uint32_t v) {
+        WriteLe_(v, 4);
+    }
+
+    void WriteU64(std::uint64_t v) {
+        WriteLe_(v, 8);
+    }
+
+    void WriteI32(std::int32_t v) {
+        WriteU32(static_cast<std::uint32_t>(v));
+    }
+
+    void WriteI64(std::int64_t v) {
+        WriteU64(static_cast<std::uint64_t>(v));
+    }
+
+    void WriteF64(double v) {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(bits));
+        WriteU64(bits);
+    }
+
+    void WriteBytes(const void* data, size_t size) {
+        data_.append(static_cast<const char*>(data), size);
+    }
+
+    void WriteString(const std::string& s) {
+        WriteU32(static_cast<std::uint32_t>(s.size()));
+        data_.append(s);
+    }
+
+    const std::string& Data() const {
+        return data_;
+    }
+
+    size_t Size() const {
+        return data_.size();
+    }
+
+    void Clear() {
+        data_.clear();
+    }
+
+private:
+    void WriteLe_(std::uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            data_.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+    }
+
+private:
+    std::string data_;
+};
+
+// Чтение из непрерывного буфера. При выходе за границу бросает std::runtime_error.
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size)
+        : data_(data), size_(size) {
+    }
+
+    explicit BinaryReader(const std::string& data)
+        : BinaryReader(data.data(), data.size()) {
+    }
+
+    std::uint8_t ReadU8() {
+        Require_(1);
+        return static_cast<std::uint8_t>(data_[pos_++]);
+    }
+
+    std::uint16_t ReadU16() {
+        return static_cast<std::uint16_t>(ReadLe_(2));
+    }
+
+    std::uint32_t ReadU32() {
+        return static_cast<std::uint32_t>(ReadLe_(4));
+    }
+
+    std::uint64_t ReadU64() {
+        return ReadLe_(8);
+    }
+
+    std::int32_t ReadI32() {
+        return static_cast<std::int32_t>(ReadU32());
+    }
+
+    std::int64_t ReadI64() {
+        return static_cast<std::int64_t>(ReadU64());
+    }
+
+    double ReadF64() {
+        const std::uint64_t bits = ReadU64();
+        double v = 0.0;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    void ReadBytes(void* out, size_t size) {
+        Require_(size);
+        std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+    }
+
+    std::string ReadString() {
+        const size_t size = ReadU32();
+        Require_(size);
+        std::string s(data_ + pos_, size);
+        pos_ += size;
+        return s;
+    }
+
+    bool AtEnd() const {
+        return pos_ == size_;
+    }
+
+    size_t Position() const {
+        return pos_;
+    }
+
+    size_t Remaining() const {
+        return size_ - pos_;
+    }
+
+    // Проверка прочитанного числа элементов, каждый из которых занимает не меньше min_size байт:
+    // повреждённый счётчик отвергается до выделения памяти под элементы.
+    size_t CheckCount(std::uint64_t count, size_t min_size) const {
+        using namespace std::literals;
+        if (min_size > 0 && count > Remaining() / min_size) {
+            throw std::runtime_error("Число элементов больше оставшихся двоичных данных"s);
+        }
+        return static_cast<size_t>(count);
+    }
+
+private:
+    void Require_(size_t bytes) const {
+        using namespace std::literals;
+        if (size_ - pos_ < bytes) {
+            throw std::runtime_error("Неожиданный конец двоичных данных"s);
+        }
+    }
+
+    std::uint64_t ReadLe_(int bytes) {
+        Require_(static_cast<size_t>(bytes));
+        std::uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) {
+            v |= static_cast<std::uint64_t>(static_cast<unsigned char>(data_[pos_++])) << (8 * i);
+        }
+        return v;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
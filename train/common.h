@@ -1,6 +1,8 @@
 #pragma once
 
 #include "enums.h"
+#include "log2_histogram.h"
+#include "memory_usage.h"
 
 #include <array>
 #include <iostream>
@@ -17,11 +19,9 @@ struct Locomotive {
     LocoType loco_type;
 };
 
-// Информация о выполненной операции.
-// Заполняется оператором и затем используется:
-//  SortingHill: обновление состояния и метрик
-//  SortingReporterImpl: печать отчёта
-struct OperationInfo {
+// Информация о выполненной операции без тяжёлых полей: номера, флаги и счётчики.
+// Её и только её ObserverPipeline копирует в очередь для наблюдателей в своём потоке.
+struct OperationSummary {
     EventType event_type = EventType::kShiftStarted;
     bool success = false;
 
@@ -47,10 +47,120 @@ struct OperationInfo {
 
     // Отправка поезда
     bool train_sent = false;
+    bool early_dispatch = false; // неполный поезд отправлен досрочно (DispatchPolicy)
+
+    // Первая (или единственная) операция команды дежурного. false у принудительных отправок
+    // в конце смены и у второго и следующих вагонов пакета.
+    bool dispatcher_command = false;
+};
+
+// Информация о выполненной операции.
+// Заполняется оператором и затем используется:
+//  SortingHill: обновление состояния и метрик
+//  SortingReporterImpl: печать отчёта
+struct OperationInfo : OperationSummary {
+    std::vector<Wagon> departed_wagons; // состав отправленного поезда (для следующей станции)
 
     std::string message; // для отладки/логов
 };
 
+// Вместимость кольцевого пути. 0 - без ограничения.
+struct RingLimits {
+    size_t total = 0;
+    std::array<size_t, 4> per_kind{}; // по видам Г, Л, О, П
+};
+
+// Окно перестановки на горке: вместо головы входного буфера через горку идёт первый из window
+// ближайших вагонов, для которого есть поезд его вида с локомотивом и местом, - он уходит
+// сразу в поезд, а не на кольцо. Голову буфера можно обойти не больше max_bypass раз подряд,
+// затем она идёт вне зависимости от поездов. window 0 и 1 - строго по очереди.
+struct HumpReordering {
+    size_t window = 0;
+    size_t max_bypass = 16;
+};
+
+// Досрочная отправка неполного поезда с локомотивом и хотя бы одним вагоном. Условия
+// независимы, 0 / false - условие выключено:
+//  min_fill      - поезд заполнен не меньше чем на эту долю вместимости;
+//  max_age       - с планирования поезда прошло столько времени (команд или секунд модели);
+//  path_pressure - свободных путей нет, а на кольце копятся вагоны вида, который не собирает
+//                  ни один поезд станции: без отправки им некуда уйти.
+struct DispatchPolicy {
+    double min_fill = 0.0;
+    double max_age = 0.0;
+    bool path_pressure = false;
+};
+
+// Состояние пути для учёта загрузки.
+enum class PathState {
+    kFree,         // не подготовлен
+    kPreparedIdle, // подготовлен, поезда нет
+    kWaitingLoco,  // поезд ждёт локомотив
+    kFilling,      // поезд с локомотивом набирает вагоны
+    kFullWaiting,  // поезд полон и ждёт отправления
+};
+
+inline constexpr size_t kPathStateCount = 5;
+
+// Загрузка путей и локомотивов за смену (SortingHill::GetUtilization).
+// Время - в командах дежурного или, если станция получает модельное время
+// (SortingHill::SetModelTime), в секундах модели.
+struct UtilizationReport {
+    bool model_time = false;
+    double elapsed = 0.0;
+
+    // Время каждого пути в каждом состоянии (индекс - PathState)
+    std::vector<std::array<double, kPathStateCount>> paths;
+
+    // По типам локомотивов в порядке ЭВЛ-16, ЭВЛ-32, ДЛ-24, ТДЛ-64: время в резерве и в поездах
+    // (сумма по локомотивам), отправлено поездов и сумма их заполнения (вагонов / вместимость).
+    std::array<double, 4> loco_reserve_time{};
+    std::array<double, 4> loco_attached_time{};
+    std::array<size_t, 4> departures{};
+    std::array<double, 4> departure_fill_sum{};
+};
+
+// Сколько вагоны провели на станции (от поступления до отъезда в поезде) и на кольцевом пути
+// (от постановки до выгрузки в поезд), по типам Г, Л, О, П (SortingHill::GetDwell).
+// Время - как в UtilizationReport.
+struct DwellReport {
+    bool model_time = false;
+    std::array<Log2Histogram, 4> station;
+    std::array<Log2Histogram, 4> ring;
+};
+
+// Снимок метрик станции (SortingHill) после применения операции.
+// Используется наблюдателями, которым нельзя читать живое состояние станции из своего потока.
+struct HillMetrics {
+    size_t prepared_paths = 0;
+    size_t planned_trains = 0;
+    size_t arrived_locos = 0;
+    size_t processed_wagons = 0;
+    size_t sent_trains = 0;
+    size_t handled_events = 0;  // выполнено команд дежурного (без начала и окончания смены)
+    size_t departed_wagons = 0; // вагонов уехало в отправленных поездах
+    size_t throttled_events = 0; // команд, после которых подача вагонов стояла (кольцо заполнено)
+    size_t ring_entries = 0;     // вагонов поставлено на кольцевой путь
+    size_t reordered_wagons = 0; // вагонов прошло горку в обход головы буфера (HumpReordering)
+    size_t early_departures = 0; // неполных поездов отправлено досрочно (DispatchPolicy)
+
+    size_t open_trains = 0;   // запланированных и ещё не отправленных поездов
+    size_t busy_paths = 0;    // путей подготовлено или занято поездом
+    size_t buffer_wagons = 0; // вагонов во входном буфере
+    size_t ring_total = 0;
+    size_t ring_max = 0;
+
+    // Пропущенные вагоны по типам в порядке Г, Л, О, П (см. SortingHill::GetMissedWagons)
+    std::array<size_t, 4> missed_wagons{};
+
+    // Учёт памяти по структурам. Заполняется только в отчёте об окончании смены.
+    std::vector<MemoryEntry> memory;
+    // Загрузка путей и локомотивов. Заполняется только в отчёте об окончании смены.
+    UtilizationReport utilization;
+    // Время вагонов на станции и на кольце. Заполняется только в отчёте об окончании смены.
+    DwellReport dwell;
+};
+
 inline constexpr std::array<EventType, 17> kEventsBalanced = {
     EventType::kWagonArrived, EventType::kWagonArrived, EventType::kWagonArrived, EventType::kWagonArrived,
     EventType::kWagonArrived, EventType::kWagonArrived, EventType::kWagonArrived, EventType::kWagonArrived,
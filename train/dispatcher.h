@@ -0,0 +1,32 @@
+#pragma once
+
+#include "enums.h"
+
+#include <cstdint>
+#include <optional>
+
+class SortingHill;
+
+// Набор команд: бит static_cast<int>(EventType).
+using EventMask = std::uint32_t;
+
+inline constexpr EventMask kAllEvents = ~EventMask{0};
+
+inline constexpr EventMask EventBit(EventType event) {
+    return EventMask{1} << static_cast<int>(event);
+}
+
+// Источник команд дежурного для цикла смены.
+class Dispatcher {
+public:
+    virtual ~Dispatcher() = default;
+
+    // Следующая команда из allowed, допустимая для станции (CheckEvent); nullopt - сейчас
+    // ни одна такая команда невозможна. allowed сужает выбор, например, когда исполнитель
+    // команды занят (см. ShiftSimulator).
+    virtual std::optional<EventType> NextEvent(const SortingHill& sorting_hill, EventMask allowed) = 0;
+
+    std::optional<EventType> NextEvent(const SortingHill& sorting_hill) {
+        return NextEvent(sorting_hill, kAllEvents);
+    }
+};
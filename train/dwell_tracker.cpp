@@ -0,0 +1,70 @@
+#include "dwell_tracker.h"
+
+#include <algorithm>
+
+void DwellTracker::Reset(bool model_time) {
+    report_ = DwellReport{};
+    report_.model_time = model_time;
+    intake_time_.clear();
+    for (auto& queue : ring_since_) {
+        queue.clear();
+    }
+}
+
+void DwellTracker::Restart(double now, bool model_time) {
+    report_ = DwellReport{};
+    report_.model_time = model_time;
+    for (auto& [number, time] : intake_time_) {
+        (void)number;
+        time = now;
+    }
+    for (auto& queue : ring_since_) {
+        std::fill(queue.begin(), queue.end(), now);
+    }
+}
+
+void DwellTracker::OnIntake(int wagon_number, double now) {
+    intake_time_.emplace(wagon_number, now);
+}
+
+void DwellTracker::OnRingPush(WagonType type, double now) {
+    ring_since_[static_cast<size_t>(type)].push_back(now);
+}
+
+void DwellTracker::OnRingDrain(WagonType type, size_t count, double now) {
+    const auto k = static_cast<size_t>(type);
+    auto& queue = ring_since_[k];
+    for (size_t i = 0; i < count && !queue.empty(); ++i) {
+        report_.ring[k].Add(now - queue.front());
+        queue.pop_front();
+    }
+}
+
+void DwellTracker::OnDeparted(const std::vector<Wagon>& wagons, double now) {
+    for (const Wagon& wagon : wagons) {
+        // Вагоны поездов из снимка поступили до восстановления - их время неизвестно.
+        const auto [first, last] = intake_time_.equal_range(wagon.number);
+        if (first == last) {
+            continue;
+        }
+        const auto it = std::min_element(first, last, [](const auto& lhs, const auto& rhs) {
+            return lhs.second < rhs.second;
+        });
+        report_.station[static_cast<size_t>(wagon.wagon_type)].Add(now - it->second);
+        intake_time_.erase(it);
+    }
+}
+
+const DwellReport& DwellTracker::GetReport() const {
+    return report_;
+}
+
+void DwellTracker::CollectMemory(std::vector<MemoryEntry>& out) const {
+    MemoryEntry intake{"Время поступления", intake_time_.size(), memory::HashMapBytes(intake_time_)};
+    MemoryEntry ring{"Время на кольце"};
+    for (const auto& queue : ring_since_) {
+        ring.elements += queue.size();
+        ring.bytes += memory::DequeBytes<double>(queue.size());
+    }
+    out.insert(out.end(), {intake, ring});
+}
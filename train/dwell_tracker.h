@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// Время вагонов на станции и на кольцевом пути. Ведётся станцией (SortingHill):
+// поступление запоминается по номеру вагона (номера могут повторяться: после INT_MAX они идут
+// с нуля, в ведомостях бывают повторы - тогда уезжающему вагону достаётся самая ранняя отметка),
+// постановка на кольцо - в очереди своего типа
+// (кольцо выгружается с головы, поэтому выгруженным n вагонам соответствуют n первых отметок).
+// Вагон попадает в гистограмму станции при отъезде в поезде, в гистограмму кольца - при выгрузке.
+class DwellTracker {
+public:
+    // Новая смена: гистограммы и отметки пусты.
+    void Reset(bool model_time);
+    // Счёт времени заново в другой единице: отметки ждущих вагонов переносятся на now,
+    // гистограммы очищаются.
+    void Restart(double now, bool model_time);
+
+    void OnIntake(int wagon_number, double now);
+    void OnRingPush(WagonType type, double now);
+    void OnRingDrain(WagonType type, size_t count, double now);
+    void OnDeparted(const std::vector<Wagon>& wagons, double now);
+
+    const DwellReport& GetReport() const;
+
+    void CollectMemory(std::vector<MemoryEntry>& out) const;
+
+private:
+    DwellReport report_;
+    std::unordered_multimap<int, double> intake_time_;
+    std::array<std::deque<double>, 4> ring_since_;
+};
@@ -0,0 +1,81 @@
+#include "event_scheduler.h"
+#include "common.h"
+#include "sorting_hill.h"
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+EventScheduler::EventScheduler(std::uint64_t seed)
+    : EventScheduler(seed, WorkloadConfig::DefaultEventWeights()) {
+}
+
+EventScheduler::EventScheduler(std::uint64_t seed, const std::array<double, 7>& weights)
+    : phases_(1),
+      rng_(seed) {
+    BuildTables_(weights, phases_[0]);
+}
+
+EventScheduler::EventScheduler(std::uint64_t seed, const WorkloadConfig& workload)
+    : EventScheduler(seed, workload.event_weights) {
+    const double amplitude = std::clamp(workload.diurnal_amplitude, 0.0, 1.0);
+    if (amplitude == 0.0 || workload.day_length == 0) {
+        return;
+    }
+
+    // Вес kWagonArrived в фазе - как в WorkloadGenerator::GenerateEvents.
+    day_length_ = workload.day_length;
+    phases_.resize(kDayPhases);
+    const double pi = std::acos(-1.0);
+    for (size_t phase = 0; phase < kDayPhases; ++phase) {
+        auto weights = workload.event_weights;
+        const double angle = 2.0 * pi * (static_cast<double>(phase) + 0.5) / kDayPhases;
+        weights[static_cast<size_t>(EventType::kWagonArrived)] *= 1.0 + amplitude * std::sin(angle);
+        BuildTables_(weights, phases_[phase]);
+    }
+}
+
+void EventScheduler::BuildTables_(const std::array<double, 7>& weights, MaskTables& tables) {
+    std::vector<double> masked(kEvents.size());
+    for (size_t mask = 0; mask < kMasks; ++mask) {
+        for (size_t i = 0; i < kEvents.size(); ++i) {
+            masked[i] = (mask >> i) & 1 ? weights[static_cast<size_t>(kEvents[i])] : 0.0;
+        }
+        tables[mask].Build(masked);
+    }
+}
+
+std::optional<EventType> EventScheduler::Next(const SortingHill& sorting_hill) {
+    return Next(GetEnabledMask(sorting_hill), sorting_hill.GetHandledEventsCount());
+}
+
+std::optional<EventType> EventScheduler::NextEvent(const SortingHill& sorting_hill, EventMask allowed) {
+    return Next(GetEnabledMask(sorting_hill, allowed), sorting_hill.GetHandledEventsCount());
+}
+
+std::optional<EventType> EventScheduler::Next(std::uint32_t enabled_mask, size_t command) {
+    const size_t phase = phases_.size() == 1 ? 0 : (command % day_length_) * kDayPhases / day_length_;
+    const AliasTable& table = phases_[phase][enabled_mask & (kMasks - 1)];
+    if (table.Empty()) {
+        return std::nullopt;
+    }
+    return kEvents[table.Sample(rng_.Next())];
+}
+
+std::uint32_t EventScheduler::GetEnabledMask(const SortingHill& sorting_hill, EventMask allowed) {
+    std::uint32_t mask = 0;
+    for (size_t i = 0; i < kEvents.size(); ++i) {
+        if ((allowed & EventBit(kEvents[i])) != 0 && sorting_hill.CheckEvent(kEvents[i])) {
+            mask |= std::uint32_t{1} << i;
+        }
+    }
+    return mask;
+}
+
+const std::array<std::uint64_t, 4>& EventScheduler::GetRngState() const {
+    return rng_.GetState();
+}
+
+void EventScheduler::SetRngState(const std::array<std::uint64_t, 4>& state) {
+    rng_.SetState(state);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "alias_table.h"
+#include "dispatcher.h"
+#include "enums.h"
+#include "fast_rng.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+class SortingHill;
+
+struct WorkloadConfig;
+
+// Выбор следующей команды дежурного только среди допустимых сейчас (CheckEvent) событий.
+// Распределение совпадает с выбором по весам с отбрасыванием недопустимых, но без пустых
+// итераций: для каждого из 2^5 наборов допустимых команд заранее построена таблица псевдонимов.
+// С суточной неравномерностью (WorkloadConfig::diurnal_amplitude) таблицы строятся для каждой
+// фазы суток, фаза - по номеру команды станции (GetHandledEventsCount).
+class EventScheduler : public Dispatcher {
+public:
+    // Команды, из которых выбирает планировщик (начало и окончание смены - не случайные).
+    static constexpr std::array<EventType, 5> kEvents = {
+        EventType::kPreparePath, EventType::kTrainPlanned, EventType::kLocoArrived,
+        EventType::kWagonArrived, EventType::kTrainReady
+    };
+
+    // weights - веса по индексу EventType (как WorkloadConfig::event_weights).
+    explicit EventScheduler(std::uint64_t seed);
+    EventScheduler(std::uint64_t seed, const std::array<double, 7>& weights);
+    // Веса команд и суточная неравномерность - из workload (его seed не используется).
+    EventScheduler(std::uint64_t seed, const WorkloadConfig& workload);
+
+    // Следующая команда; nullopt - сейчас ни одна команда невозможна.
+    std::optional<EventType> Next(const SortingHill& sorting_hill);
+    // То же по готовой маске допустимых команд (бит i - kEvents[i]);
+    // command - номер команды, по нему выбирается фаза суток.
+    std::optional<EventType> Next(std::uint32_t enabled_mask, size_t command = 0);
+
+    using Dispatcher::NextEvent;
+    std::optional<EventType> NextEvent(const SortingHill& sorting_hill, EventMask allowed) override;
+
+    static std::uint32_t GetEnabledMask(const SortingHill& sorting_hill, EventMask allowed = kAllEvents);
+
+    // Состояние FastRng для снимка станции.
+    const std::array<std::uint64_t, 4>& GetRngState() const;
+    void SetRngState(const std::array<std::uint64_t, 4>& state);
+
+private:
+    static constexpr size_t kMasks = size_t{1} << kEvents.size();
+    // Число фаз суток, как у WorkloadGenerator.
+    static constexpr size_t kDayPhases = 24;
+
+    using MaskTables = std::array<AliasTable, kMasks>;
+
+    static void BuildTables_(const std::array<double, 7>& weights, MaskTables& tables);
+
+    // Одна фаза без суточной неравномерности, иначе kDayPhases.
+    std::vector<MaskTables> phases_;
+    size_t day_length_ = 1;
+    FastRng rng_;
+};
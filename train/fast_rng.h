@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Быстрый генератор xoshiro256** (Blackman, Vigna) для массовой генерации нагрузки.
+// В отличие от RandomGen не глобальный: у каждого потока и генератора свой экземпляр.
+class FastRng {
+public:
+    explicit FastRng(std::uint64_t seed = 1) {
+        Seed(seed);
+    }
+
+    void Seed(std::uint64_t seed) {
+        // Состояние заполняется через splitmix64, чтобы близкие seed давали разные потоки.
+        for (auto& s : state_) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t Next() {
+        const std::uint64_t result = Rotl_(state_[1] * 5, 7) * 9;
+        const std::uint64_t t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl_(state_[3], 45);
+
+        return result;
+    }
+
+    // Равномерно в [0, n) без деления (метод Лемира, с пренебрежимо малым смещением).
+    std::uint32_t NextBelow(std::uint32_t n) {
+        return static_cast<std::uint32_t>(((Next() >> 32) * n) >> 32);
+    }
+
+    // Равномерно в [0, 1)
+    double NextDouble() {
+        return static_cast<double>(Next() >> 11) * 0x1.0p-53;
+    }
+
+    const std::array<std::uint64_t, 4>& GetState() const {
+        return state_;
+    }
+
+    void SetState(const std::array<std::uint64_t, 4>& state) {
+        state_ = state;
+    }
+
+private:
+    static std::uint64_t Rotl_(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+private:
+    std::array<std::uint64_t, 4> state_{};
+};
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "binary_io.h"
 #include "common.h"
 
+#include <vector>
+
 class SortingHill;
+class WagonLocator;
 
 class SortingHandler {
 public:
@@ -26,6 +30,47 @@ public:
     /* Обработчик поступающих вагонов. */
     virtual void HandleWagon(SortingHill& sorting_hill, const Wagon& wagon_info, OperationInfo& operation_info) = 0;
 
+    /* Пакет вагонов с начала входного буфера (SortingHill::HandleWagonBatch).
+       Первый обработчик получает пустой operation_infos и оставляет в нём по записи на каждый
+       принятый вагон (до первого вагона, которому нет места); следующие видят эти записи.
+       По умолчанию - HandleWagon по очереди. */
+    virtual void HandleWagonBatch(SortingHill& sorting_hill, const std::vector<Wagon>& wagons,
+                                  std::vector<OperationInfo>& operation_infos) {
+        const bool first = operation_infos.empty();
+        if (first) {
+            operation_infos.resize(wagons.size());
+        }
+        for (size_t i = 0; i < operation_infos.size(); ++i) {
+            HandleWagon(sorting_hill, wagons[i], operation_infos[i]);
+            if (first && !operation_infos[i].success) {
+                operation_infos.resize(i);
+                break;
+            }
+        }
+    }
+
     /* Запрос на отправку готового поезда. */
     virtual void SendTrain(SortingHill& sorting_hill, OperationInfo& operation_info) = 0;
+
+    /* Сохранение внутреннего состояния в снимок станции. По умолчанию состояния нет. */
+    virtual void SaveState(BinaryWriter&) const {
+    }
+
+    /* Восстановление из снимка станции в два шага: PrepareState читает и проверяет блок
+       состояния, ничего не меняя (ошибка - исключение), CommitState применяет прочитанное.
+       CommitState вызывается, только когда подготовлены все обработчики и вся станция. */
+    virtual void PrepareState(BinaryReader&) {
+    }
+
+    virtual void CommitState() {
+    }
+
+    /* Индекс вагонов станции (nullptr - не вести). Обработчик, перемещающий вагоны,
+       отмечает в нём их новые места. */
+    virtual void AttachWagonLocator(WagonLocator*) {
+    }
+
+    /* Учёт памяти внутренних структур (записи добавляются в конец out). */
+    virtual void CollectMemory(std::vector<MemoryEntry>&) const {
+    }
 };
@@ -0,0 +1,89 @@
+#include "lane_pool.h"
+
+LanePool::LanePool(size_t workers) {
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back([this] { WorkerLoop_(); });
+    }
+}
+
+LanePool::~LanePool() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t LanePool::GetWorkers() const {
+    return threads_.size();
+}
+
+void LanePool::Run(size_t count, const std::function<void(size_t)>& task) {
+    std::lock_guard run_lock(run_mutex_);
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        next_task_ = 0;
+        busy_workers_ = threads_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    RunTasks_();
+
+    std::unique_lock lock(mutex_);
+    done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void LanePool::WorkerLoop_() {
+    std::uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            start_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        RunTasks_();
+
+        std::lock_guard lock(mutex_);
+        if (--busy_workers_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void LanePool::RunTasks_() {
+    // Задач мало (по одной на вид поезда), поэтому номер следующей берётся под мьютексом.
+    while (true) {
+        size_t index = 0;
+        {
+            std::lock_guard lock(mutex_);
+            if (next_task_ >= count_) {
+                return;
+            }
+            index = next_task_++;
+        }
+        try {
+            (*task_)(index);
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
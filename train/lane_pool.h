@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для дорожек сортировки в режиме fork-join: Run раздаёт задачи 0..count-1
+// вызывающему потоку и рабочим и возвращается, когда выполнены все.
+// Рабочие живут всё время жизни пула, поэтому пакет не платит за создание потоков.
+class LanePool {
+public:
+    // workers - рабочие потоки помимо вызывающего.
+    explicit LanePool(size_t workers);
+    ~LanePool();
+
+    LanePool(const LanePool&) = delete;
+    LanePool& operator=(const LanePool&) = delete;
+
+    size_t GetWorkers() const;
+
+    // Вызовы из разных потоков выполняются по очереди. Первое исключение задачи
+    // пробрасывается после завершения остальных.
+    void Run(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop_();
+    void RunTasks_();
+
+private:
+    std::mutex run_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t count_ = 0;
+    size_t next_task_ = 0;
+    size_t busy_workers_ = 0;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+
+    std::vector<std::thread> threads_;
+};
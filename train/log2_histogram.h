@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Гистограмма неотрицательных величин с корзинами по степеням двойки:
+// корзина 0 - [0, 1), корзина i - [2^(i-1), 2^i), последняя собирает всё большее.
+// Добавление за O(1), размер не зависит от числа значений.
+class Log2Histogram {
+public:
+    static constexpr size_t kBuckets = 32;
+
+    void Add(double value) {
+        value = std::max(value, 0.0);
+        ++buckets_[BucketOf(value)];
+        ++count_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+    }
+
+    static size_t BucketOf(double value) {
+        if (value < 1.0) {
+            return 0;
+        }
+        const auto bucket = static_cast<size_t>(std::floor(std::log2(value))) + 1;
+        return std::min(bucket, kBuckets - 1);
+    }
+
+    // Нижняя граница корзины (верхняя - нижняя граница следующей).
+    static double BucketLow(size_t bucket) {
+        return bucket == 0 ? 0.0 : std::ldexp(1.0, static_cast<int>(bucket) - 1);
+    }
+
+    size_t GetCount() const {
+        return count_;
+    }
+
+    size_t GetBucket(size_t bucket) const {
+        return buckets_[bucket];
+    }
+
+    double GetMean() const {
+        return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0;
+    }
+
+    double GetMax() const {
+        return max_;
+    }
+
+    // Оценка сверху: верхняя граница корзины, в которую попадает доля q значений, но не больше максимума.
+    double GetPercentile(double q) const {
+        if (count_ == 0) {
+            return 0.0;
+        }
+        const auto rank = static_cast<size_t>(std::ceil(q * static_cast<double>(count_)));
+        size_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i];
+            if (seen >= std::max<size_t>(rank, 1)) {
+                return i + 1 < kBuckets ? std::min(BucketLow(i + 1), max_) : max_;
+            }
+        }
+        return max_;
+    }
+
+private:
+    std::array<size_t, kBuckets> buckets_{};
+    size_t count_ = 0;
+    double sum_ = 0.0;
+    double max_ = 0.0;
+};
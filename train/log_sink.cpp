@@ -0,0 +1,100 @@
+#include "log_sink.h"
+
+#include <chrono>
+
+LogSink::LogSink(std::ostream& out, size_t capacity, OverflowPolicy policy)
+    : out_(out),
+      policy_(policy),
+      queue_(capacity) {
+    writer_ = std::thread([this] { WriterLoop_(); });
+}
+
+LogSink::~LogSink() {
+    stop_.store(true);
+    WakeWriter_();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+bool LogSink::Write(std::string line) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    while (!queue_.TryPush(std::move(line))) {
+        if (policy_ == OverflowPolicy::kDrop) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        WakeWriter_();
+        std::this_thread::yield();
+    }
+    ++pushed_;
+
+    // Пара к проверке очереди писателем после установки writer_sleeping_.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_sleeping_.load()) {
+        WakeWriter_();
+    }
+    return true;
+}
+
+void LogSink::Flush() {
+    size_t target = 0;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        target = pushed_;
+    }
+    while (flushed_.load(std::memory_order_acquire) < target) {
+        WakeWriter_();
+        std::this_thread::yield();
+    }
+}
+
+size_t LogSink::GetDroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void LogSink::WakeWriter_() {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+}
+
+void LogSink::WriterLoop_() {
+    using namespace std::chrono_literals;
+
+    std::string line;
+    size_t written = 0;
+
+    while (true) {
+        bool any = false;
+        while (queue_.TryPop(line)) {
+            out_ << line << '\n';
+            ++written;
+            any = true;
+        }
+
+        if (any) {
+            out_.flush();
+            flushed_.store(written, std::memory_order_release);
+            continue;
+        }
+
+        if (stop_.load()) {
+            // Производитель мог успеть положить строку до установки stop_.
+            if (queue_.EmptyApprox()) {
+                break;
+            }
+            continue;
+        }
+
+        // Очередь пуста: засыпаем. Перепроверяем очередь после установки флага,
+        // чтобы не пропустить строку, записанную между проверкой и ожиданием.
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        writer_sleeping_.store(true);
+        if (queue_.EmptyApprox() && !stop_.load()) {
+            wake_cv_.wait_for(lock, 10ms);
+        }
+        writer_sleeping_.store(false);
+    }
+
+    out_.flush();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Асинхронный журнал вывода.
+// Строки складываются в ограниченную очередь SpscRing, фоновый поток пишет их в поток вывода
+// и сбрасывает его только когда очередь опустела. Поток симуляции не ждёт медленный терминал.
+// Писать можно из нескольких потоков (поток станции, поток наблюдателей): производители
+// ставят строки в очередь по одному, под мьютексом, поэтому строки не перемешиваются.
+class LogSink {
+public:
+    explicit LogSink(std::ostream& out,
+                     size_t capacity = 4096,
+                     OverflowPolicy policy = OverflowPolicy::kBlock);
+    ~LogSink();
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    // Ставит строку в очередь (перевод строки добавляет писатель).
+    // Возвращает false, если строка отброшена по политике kDrop.
+    bool Write(std::string line);
+
+    // Ждёт, пока все записанные строки будут выведены и поток вывода сброшен.
+    void Flush();
+
+    size_t GetDroppedCount() const;
+
+    // Строка журнала: собирается через operator<< и уходит в очередь в деструкторе.
+    //   log.Log() << "Очередь вагонов: "s << n;
+    class Line {
+    public:
+        explicit Line(LogSink& sink) : sink_(sink) {
+        }
+
+        Line(const Line&) = delete;
+        Line& operator=(const Line&) = delete;
+
+        ~Line() {
+            sink_.Write(out_.str());
+        }
+
+        template <class T>
+        Line& operator<<(const T& value) {
+            out_ << value;
+            return *this;
+        }
+
+    private:
+        LogSink& sink_;
+        std::ostringstream out_;
+    };
+
+    Line Log() {
+        return Line(*this);
+    }
+
+private:
+    std::ostream& out_;
+    const OverflowPolicy policy_;
+    SpscRing<std::string> queue_;
+
+    std::mutex write_mutex_; // единственный производитель SpscRing в каждый момент
+    size_t pushed_ = 0;      // под write_mutex_
+    std::atomic<size_t> flushed_{0};
+    std::atomic<size_t> dropped_{0};
+
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> writer_sleeping_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    std::thread writer_;
+
+private:
+    void WakeWriter_();
+    void WriterLoop_();
+};
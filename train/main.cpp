@@ -1,48 +1,713 @@
 #include "sorting_hill.h"
+#include "adaptive_dispatcher.h"
 #include "enums.h"
 #include "random.h"
+#include "observer_pipeline.h"
+#include "operation_journal.h"
 #include "sorting_operator.h"
+#include "shift_recorder.h"
+#include "shift_simulator.h"
+#ifndef _WIN32
+#include "shared_metrics.h"
+#endif
 #include "sorting_reporter.h"
+#include "station_snapshot.h"
 #include "common.h"
+#include "event_scheduler.h"
+#include "log_sink.h"
+#include "wagon_intake.h"
+#include "wagon_manifest.h"
+#include "workload_generator.h"
+#include "yard_coordinator.h"
+#include "yard_network.h"
 
+#include <array>
 #include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
-int main() {
+namespace {
+
+struct AppOptions {
+    // Репортёр работает наблюдателем в отдельном потоке (ObserverPipeline)
+    bool async_observers = false;
+    // Число входящих линий, подающих вагоны во время смены (0 - весь состав до начала смены)
+    int feed_lines = 0;
+    // Запись входных данных смены в файл
+    std::string record_path;
+    // Воспроизведение записанной смены на полной скорости
+    std::string replay_path;
+    // Столбцовый журнал применённых операций
+    std::string journal_path;
+    // Двоичная ведомость вагонов вместо случайного состава
+    std::string manifest_path;
+    // Периодический снимок состояния станции и продолжение смены со снимка
+    std::string checkpoint_path;
+    std::string resume_path;
+    // Окно входного буфера для выбора вида нового поезда (0 - только кольцо и ротация)
+    size_t plan_window = 0;
+    // Выбор локомотива: fifo (по порядку) или capacity (под ожидаемое заполнение поезда)
+    LocoAssignment loco_assignment = LocoAssignment::kFifo;
+    // Дежурный: scheduler - случайные команды с весами, adaptive - по состоянию станции
+    bool adaptive_dispatcher = false;
+    // Дискретно-событийная модель вместо пауз: длительности операций и модельное время
+    bool simulate = false;
+    double sim_hours = 0.0;
+    // Интервал прибытия вагонов в модели, с (0 - весь состав на станции к началу смены)
+    double inbound_interval = 0.0;
+    // Вместимость кольцевого пути: всего и по видам (0 - без ограничения)
+    RingLimits ring_limits;
+    // Имя сегмента разделяемой памяти для метрик станции (shm_monitor)
+    std::string shm_name;
+    // Сколько вагонов подряд пропускает одна команда kWagonArrived (0 и 1 - по одному)
+    size_t wagon_batch = 0;
+    // Раскладка пакета вагонов по видам поездов на отдельных потоках
+    bool parallel_lanes = false;
+    // Окно перестановки на горке
+    HumpReordering hump_reordering;
+    // Досрочная отправка неполных поездов
+    DispatchPolicy dispatch_policy;
+    // Индекс вагонов по номеру (отключается для замеров производительности)
+    bool wagon_locator = true;
+    // Номер вагона, место которого печатается после каждой команды
+    std::optional<int> locate_wagon;
+    // Время вагонов на станции и на кольце в отчёте смены (отключается для замеров производительности)
+    bool dwell_tracking = true;
+    // Число горок парка, каждая в своём потоке (0 - одна станция в основном потоке)
+    size_t humps = 0;
+    // Линия из network станций, каждая в своём потоке: поезда уходят на следующую станцию
+    size_t network = 0;
+    // Время в пути между станциями линии и интервал прибытия вагонов на первую, в командах
+    size_t transit = 0;
+    size_t origin_interval = 0;
+
+    // Генерация состава: число вагонов (0 - случайно 1024..4095), распределения типов
+    size_t wagons = 0;
+    bool seed_set = false;
+    WorkloadConfig workload;
+};
+
+bool ParseValue(const std::string& arg, const std::string& name, std::string& value) {
+    if (arg.rfind(name, 0) != 0) {
+        return false;
+    }
+    value = arg.substr(name.size());
+    return true;
+}
+
+// "a,b,c,d" -> четыре неотрицательных веса
+std::array<double, 4> ParseWeights(const std::string& value) {
+    using namespace std::literals;
+
+    std::array<double, 4> weights{};
+    std::istringstream in(value);
+    std::string field;
+    size_t i = 0;
+    while (std::getline(in, field, ',')) {
+        if (i == weights.size()) {
+            throw std::invalid_argument("Ожидается четыре веса через запятую: "s + value);
+        }
+        weights[i++] = std::stod(field);
+    }
+    if (i != weights.size()) {
+        throw std::invalid_argument("Ожидается четыре веса через запятую: "s + value);
+    }
+    return weights;
+}
+
+// Четыре неотрицательных целых через запятую (по видам Г, Л, О, П).
+std::array<size_t, 4> ParseCounts(const std::string& value) {
+    using namespace std::literals;
+
+    std::array<size_t, 4> counts{};
+    std::istringstream in(value);
+    std::string field;
+    size_t i = 0;
+    while (std::getline(in, field, ',')) {
+        if (i == counts.size() || field.empty() || field.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::invalid_argument("Ожидается четыре неотрицательных целых через запятую: "s + value);
+        }
+        counts[i++] = std::stoul(field);
+    }
+    if (i != counts.size()) {
+        throw std::invalid_argument("Ожидается четыре неотрицательных целых через запятую: "s + value);
+    }
+    return counts;
+}
+
+AppOptions ParseOptions(int argc, char* argv[]) {
+    using namespace std::literals;
+
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        std::string value;
+        if (arg == "--async-observers"s) {
+            options.async_observers = true;
+        } else if (ParseValue(arg, "--feed-lines="s, value)) {
+            options.feed_lines = std::stoi(value);
+            if (options.feed_lines < 0) {
+                throw std::invalid_argument("Число линий не может быть отрицательным"s);
+            }
+        } else if (ParseValue(arg, "--record="s, value)) {
+            options.record_path = value;
+        } else if (ParseValue(arg, "--replay="s, value)) {
+            options.replay_path = value;
+        } else if (ParseValue(arg, "--journal="s, value)) {
+            options.journal_path = value;
+        } else if (ParseValue(arg, "--manifest="s, value)) {
+            options.manifest_path = value;
+        } else if (ParseValue(arg, "--checkpoint="s, value)) {
+            options.checkpoint_path = value;
+        } else if (ParseValue(arg, "--resume="s, value)) {
+            options.resume_path = value;
+        } else if (ParseValue(arg, "--plan-window="s, value)) {
+            options.plan_window = std::stoul(value);
+        } else if (ParseValue(arg, "--loco-assignment="s, value)) {
+            if (value == "fifo"s) {
+                options.loco_assignment = LocoAssignment::kFifo;
+            } else if (value == "capacity"s) {
+                options.loco_assignment = LocoAssignment::kCapacityAware;
+            } else {
+                throw std::invalid_argument("Неизвестное правило выбора локомотива: "s + value);
+            }
+        } else if (ParseValue(arg, "--dispatcher="s, value)) {
+            if (value == "scheduler"s) {
+                options.adaptive_dispatcher = false;
+            } else if (value == "adaptive"s) {
+                options.adaptive_dispatcher = true;
+            } else {
+                throw std::invalid_argument("Неизвестный дежурный: "s + value);
+            }
+        } else if (arg == "--simulate"s) {
+            options.simulate = true;
+        } else if (ParseValue(arg, "--sim-hours="s, value)) {
+            options.sim_hours = std::stod(value);
+        } else if (ParseValue(arg, "--inbound-interval="s, value)) {
+            options.inbound_interval = std::stod(value);
+        } else if (ParseValue(arg, "--ring-limit="s, value)) {
+            options.ring_limits.total = std::stoul(value);
+        } else if (ParseValue(arg, "--ring-limit-kind="s, value)) {
+            options.ring_limits.per_kind = ParseCounts(value);
+        } else if (ParseValue(arg, "--wagon-batch="s, value)) {
+            options.wagon_batch = std::stoul(value);
+        } else if (arg == "--parallel-lanes"s) {
+            options.parallel_lanes = true;
+        } else if (ParseValue(arg, "--hump-window="s, value)) {
+            options.hump_reordering.window = std::stoul(value);
+        } else if (ParseValue(arg, "--max-bypass="s, value)) {
+            options.hump_reordering.max_bypass = std::stoul(value);
+        } else if (ParseValue(arg, "--dispatch-fill="s, value)) {
+            options.dispatch_policy.min_fill = std::stod(value);
+        } else if (ParseValue(arg, "--dispatch-age="s, value)) {
+            options.dispatch_policy.max_age = std::stod(value);
+        } else if (arg == "--dispatch-pressure"s) {
+            options.dispatch_policy.path_pressure = true;
+        } else if (arg == "--no-dwell"s) {
+            options.dwell_tracking = false;
+        } else if (arg == "--no-wagon-locator"s) {
+            options.wagon_locator = false;
+        } else if (ParseValue(arg, "--locate="s, value)) {
+            options.locate_wagon = std::stoi(value);
+        } else if (ParseValue(arg, "--network="s, value)) {
+            options.network = std::stoul(value);
+        } else if (ParseValue(arg, "--transit="s, value)) {
+            options.transit = std::stoul(value);
+        } else if (ParseValue(arg, "--origin-interval="s, value)) {
+            options.origin_interval = std::stoul(value);
+        } else if (ParseValue(arg, "--humps="s, value)) {
+            options.humps = std::stoul(value);
+        } else if (ParseValue(arg, "--shm="s, value)) {
+            options.shm_name = value;
+        } else if (ParseValue(arg, "--wagons="s, value)) {
+            options.wagons = std::stoul(value);
+        } else if (ParseValue(arg, "--seed="s, value)) {
+            options.workload.seed = std::stoull(value);
+            options.seed_set = true;
+        } else if (ParseValue(arg, "--type-mix="s, value)) {
+            options.workload.wagon_type_weights = ParseWeights(value);
+        } else if (ParseValue(arg, "--loco-mix="s, value)) {
+            options.workload.loco_type_weights = ParseWeights(value);
+        } else if (ParseValue(arg, "--consist="s, value)) {
+            options.workload.mean_consist_length = std::stod(value);
+        } else if (ParseValue(arg, "--diurnal="s, value)) {
+            options.workload.diurnal_amplitude = std::stod(value);
+            if (options.workload.diurnal_amplitude < 0.0 || options.workload.diurnal_amplitude > 1.0) {
+                throw std::invalid_argument("--diurnal: амплитуда от 0 до 1"s);
+            }
+        } else {
+            throw std::invalid_argument("Неизвестный параметр: "s + arg);
+        }
+    }
+    if (!options.manifest_path.empty() && options.feed_lines > 0) {
+        throw std::invalid_argument("--manifest и --feed-lines нельзя использовать вместе"s);
+    }
+    if (options.simulate && options.feed_lines > 0) {
+        throw std::invalid_argument("--simulate и --feed-lines нельзя использовать вместе"s);
+    }
+    if (!options.resume_path.empty()
+        && (options.feed_lines > 0 || !options.manifest_path.empty() || !options.record_path.empty())) {
+        // Источники вагонов и запись смены в снимок не входят.
+        throw std::invalid_argument("--resume нельзя использовать с --feed-lines, --manifest и --record"s);
+    }
+    if (options.hump_reordering.window > 1 && options.wagon_batch > 1) {
+        // Пакет вагонов идёт через горку строго по очереди.
+        throw std::invalid_argument("--hump-window и --wagon-batch нельзя использовать вместе"s);
+    }
+    if (options.locate_wagon && options.async_observers) {
+        // Место вагона печатает поток станции, а команды - поток наблюдателей: строки разошлись бы.
+        throw std::invalid_argument("--locate и --async-observers нельзя использовать вместе"s);
+    }
+    if (options.humps > 0 && options.network > 0) {
+        throw std::invalid_argument("--humps и --network нельзя использовать вместе"s);
+    }
+    if ((options.humps > 0 || options.network > 0)
+        && (options.feed_lines > 0 || !options.manifest_path.empty() || !options.record_path.empty()
+            || !options.resume_path.empty() || !options.checkpoint_path.empty() || options.simulate)) {
+        throw std::invalid_argument(
+            "--humps и --network нельзя использовать с --feed-lines, --manifest, --record, --resume, --checkpoint и --simulate"s);
+    }
+    return options;
+}
+
+// Как часто (в выполненных командах) обновляется снимок станции.
+constexpr size_t kCheckpointInterval = 100;
+
+void PrintSimulationReport(const SimulationReport& report, LogSink& log) {
+    using namespace std::literals;
+
+    log.Log() << "===== МОДЕЛЬ СМЕНЫ ====="s;
+    log.Log() << std::fixed << std::setprecision(2)
+              << "Модельное время, ч:                    "s << report.elapsed_seconds / 3600.0;
+    log.Log() << "Выполнено команд:                      "s << report.commands;
+    log.Log() << "Отменено команд:                       "s << report.rejected_commands;
+    log.Log() << "Вывезено вагонов:                      "s << report.departed_wagons;
+    log.Log() << std::fixed << std::setprecision(2)
+              << "Вагонов в час:                         "s << report.wagons_per_hour;
+    log.Log() << std::fixed << std::setprecision(1)
+              << "Загрузка путей, %:                     "s << report.path_utilization * 100.0;
+    log.Log() << std::fixed << std::setprecision(2)
+              << "Среднее время вагона на станции, ч:    "s << report.mean_dwell_seconds / 3600.0;
+    log.Log() << std::fixed << std::setprecision(2)
+              << "Подача стояла (кольцо заполнено), ч:   "s << report.throttled_seconds / 3600.0;
+    log.Log() << "========================"s;
+}
+
+void PrintYardReport(const YardReport& report, LogSink& log) {
+    using namespace std::literals;
+
+    log.Log() << "===== ПАРК ГОРОК ====="s;
+    for (size_t i = 0; i < report.humps.size(); ++i) {
+        const HumpReport& hump = report.humps[i];
+        log.Log() << "Горка "s << i + 1 << ": команд "s << hump.metrics.handled_events
+                  << ", поездов "s << hump.metrics.sent_trains
+                  << ", вывезено вагонов "s << hump.metrics.departed_wagons
+                  << ", своих вагонов "s << hump.own_wagons
+                  << ", забрано у других "s << hump.stolen_wagons
+                  << ", макс. кольцо "s << hump.metrics.ring_max;
+    }
+    log.Log() << "Выполнено команд:                      "s << report.handled_events;
+    log.Log() << "Отправлено поездов:                    "s << report.sent_trains;
+    log.Log() << "Вывезено вагонов:                      "s << report.departed_wagons;
+    log.Log() << "Забрано вагонов у других горок:        "s << report.stolen_wagons;
+    log.Log() << std::fixed << std::setprecision(3)
+              << "Время прогона, с:                      "s << report.elapsed_seconds;
+    log.Log() << "======================"s;
+}
+
+void PrintNetworkReport(const NetworkReport& report, LogSink& log) {
+    using namespace std::literals;
+
+    log.Log() << "===== ЛИНИЯ СТАНЦИЙ ====="s;
+    for (size_t i = 0; i < report.stations.size(); ++i) {
+        const StationReport& station = report.stations[i];
+        log.Log() << std::fixed << std::setprecision(1)
+                  << "Станция "s << i + 1 << ": получено вагонов "s << station.received_wagons
+                  << ", пропущено "s << station.metrics.processed_wagons
+                  << ", вывезено "s << station.metrics.departed_wagons
+                  << ", поездов "s << station.metrics.sent_trains
+                  << ", очередь перед горкой до "s << station.peak_backlog
+                  << ", загрузка "s << station.utilization * 100.0 << "%"s;
+    }
+    log.Log() << "Узкое место:                           станция "s << report.bottleneck + 1;
+    log.Log() << "Вывезено с линии вагонов:              "s << report.delivered_wagons;
+    log.Log() << std::fixed << std::setprecision(3)
+              << "Время прогона, с:                      "s << report.elapsed_seconds;
+    log.Log() << "========================="s;
+}
+
+// Где вагон: по индексу станции.
+void LogWagonLocation(const SortingHill& sorting_hill, int wagon_number, LogSink& log) {
     using namespace std::literals;
+    static const std::array<const char*, 4> kRingKindNames = {"Г", "Л", "О", "П"};
+
+    const std::optional<WagonLocation> location = sorting_hill.LocateWagon(wagon_number);
+    auto line = log.Log();
+    line << "Вагон "s << wagon_number << ": "s;
+    if (!location) {
+        line << "не на станции"s;
+        return;
+    }
+    switch (location->place) {
+        case WagonPlace::kBuffer:
+            line << "во входном буфере, позиция "s << location->position;
+            break;
+        case WagonPlace::kRing:
+            line << "на кольцевом пути, очередь "s << kRingKindNames[static_cast<size_t>(location->ring_kind)]
+                 << ", позиция "s << location->position;
+            break;
+        case WagonPlace::kTrain:
+            line << "в поезде "s << location->train_number << ", позиция "s << location->position;
+            break;
+        case WagonPlace::kDeparted:
+            line << "уехал в поезде "s << location->train_number;
+            break;
+    }
+}
 
-    size_t number_of_paths = RandomGen::GetInRange(2, 15);
+// Станция с оператором и репортёром (обработчиком или наблюдателем в своём потоке).
+SortingHill MakeSortingHill(size_t number_of_paths, const AppOptions& options, LogSink& log) {
     std::vector<std::unique_ptr<SortingHandler>> handlers;
-    handlers.push_back(std::make_unique<SortingOperatorImpl>());
-    handlers.push_back(std::make_unique<SortingReporterImpl>());
+    auto sorting_operator = std::make_unique<SortingOperatorImpl>(options.plan_window, options.loco_assignment);
+    if (options.parallel_lanes) {
+        // Четыре вида поездов: вызывающий поток и три рабочих.
+        sorting_operator->SetLanePool(std::make_shared<LanePool>(3));
+    }
+    handlers.push_back(std::move(sorting_operator));
+    if (!options.async_observers) {
+        handlers.push_back(std::make_unique<SortingReporterImpl>(log));
+    }
 
     SortingHill sorting_hill(number_of_paths, std::move(handlers));
+    sorting_hill.SetRingLimits(options.ring_limits);
+    sorting_hill.SetHumpReordering(options.hump_reordering);
+    sorting_hill.SetDispatchPolicy(options.dispatch_policy);
+    sorting_hill.EnableWagonLocator(options.wagon_locator);
+    sorting_hill.EnableDwellTracking(options.dwell_tracking);
 
-    int wagon_left = RandomGen::GetInRange(1024, 4095);
-    for (int i = 0; i < wagon_left; ++i) {
-        int wagon_num = RandomGen::GetInRange(0, 99999999);
-        WagonType wagon_type = RandomGen::GetRandomElem<WagonType>(kWagonType);
-        sorting_hill.AddWagon({wagon_num, wagon_type});
+    std::vector<std::unique_ptr<SortingObserver>> observers;
+    if (options.async_observers) {
+        // Команды печатает сам репортёр: в журнал пишет только поток наблюдателей.
+        observers.push_back(std::make_unique<SortingReporterImpl>(log));
+    }
+    if (!options.journal_path.empty()) {
+        observers.push_back(std::make_unique<OperationJournal>(options.journal_path));
     }
 
-    sorting_hill.HandleEvent(EventType::kShiftStarted);
+    if (options.async_observers) {
+        sorting_hill.AddObserver(std::make_unique<ObserverPipeline>(std::move(observers)));
+    } else {
+        for (auto& observer : observers) {
+            sorting_hill.AddObserver(std::move(observer));
+        }
+    }
+    if (!options.shm_name.empty()) {
+#ifndef _WIN32
+        // Публикация - несколько атомарных записей, поэтому прямо в потоке станции, без очереди.
+        sorting_hill.AddObserver(std::make_unique<SharedMetricsPublisher>(options.shm_name));
+#else
+        throw std::invalid_argument("--shm поддерживается только в POSIX-системах"s);
+#endif
+    }
+    return sorting_hill;
+}
+
+// Воспроизведение записанной смены: без случайного выбора команд и без пауз.
+int RunReplay(const AppOptions& options, LogSink& log) {
+    using namespace std::literals;
+
+    const ShiftReplay replay = ShiftReplay::Load(options.replay_path);
+    // Настройки станции - из записи, а не из командной строки: иначе смена пойдёт по-другому.
+    const RecordedStation& station = replay.GetStation();
+    AppOptions replay_options = options;
+    replay_options.ring_limits = station.ring_limits;
+    replay_options.hump_reordering = station.hump_reordering;
+    replay_options.dispatch_policy = station.dispatch_policy;
+    replay_options.plan_window = station.planning_window;
+    replay_options.loco_assignment = station.loco_assignment;
+    SortingHill sorting_hill = MakeSortingHill(station.number_of_paths, replay_options, log);
 
-    while (sorting_hill.IsWagonBuffer()) {
+    const auto start = std::chrono::steady_clock::now();
+    replay.Run(sorting_hill);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Итог - после команд и отчёта смены, которые может ещё печатать поток наблюдателей.
+    sorting_hill.FlushObservers();
+    log.Log() << "Воспроизведено событий: "s << replay.GetEventsCount() << " за "s
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << " мкс"s;
+    return 0;
+}
+
+// Парк из нескольких горок на полной скорости, без пауз и без журнала команд.
+int RunYard(const AppOptions& options, LogSink& log) {
+    using namespace std::literals;
+
+    WorkloadConfig workload = options.workload;
+    if (!options.seed_set) {
+        workload.seed = std::random_device{}();
+    }
+    workload.first_wagon_number = RandomGen::GetInRange(0, 89999999);
+    WorkloadGenerator generator(workload);
+    const size_t wagon_count = options.wagons > 0 ? options.wagons
+                                                  : static_cast<size_t>(RandomGen::GetInRange(1024, 4095));
+
+    YardConfig config;
+    config.humps = options.humps;
+    config.paths_per_hump = static_cast<size_t>(RandomGen::GetInRange(2, 15));
+    config.planning_window = options.plan_window;
+    config.loco_assignment = options.loco_assignment;
+    config.ring_limits = options.ring_limits;
+    config.adaptive_dispatcher = options.adaptive_dispatcher;
+    config.workload = workload;
+
+    log.Log() << "Горок: "s << config.humps << ", путей на горке: "s << config.paths_per_hump
+              << ", вагонов: "s << wagon_count;
+    YardCoordinator coordinator(config);
+    PrintYardReport(coordinator.Run(generator.GenerateWagons(wagon_count)), log);
+    return 0;
+}
+
+// Линия станций на полной скорости: у каждой своё случайное число путей.
+int RunNetwork(const AppOptions& options, LogSink& log) {
+    using namespace std::literals;
+
+    WorkloadConfig workload = options.workload;
+    if (!options.seed_set) {
+        workload.seed = std::random_device{}();
+    }
+    workload.first_wagon_number = RandomGen::GetInRange(0, 89999999);
+    WorkloadGenerator generator(workload);
+    const size_t wagon_count = options.wagons > 0 ? options.wagons
+                                                  : static_cast<size_t>(RandomGen::GetInRange(1024, 4095));
+
+    std::vector<size_t> paths;
+    for (size_t i = 0; i < options.network; ++i) {
+        paths.push_back(static_cast<size_t>(RandomGen::GetInRange(2, 15)));
+    }
+    NetworkConfig config = MakeCorridor(paths, options.transit, generator.GenerateWagons(wagon_count),
+                                        options.origin_interval);
+    config.planning_window = options.plan_window;
+    config.loco_assignment = options.loco_assignment;
+    config.ring_limits = options.ring_limits;
+    config.adaptive_dispatcher = options.adaptive_dispatcher;
+    config.workload = workload;
+
+    std::ostringstream layout;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        layout << (i > 0 ? " -> "s : ""s) << paths[i];
+    }
+    log.Log() << "Станций: "s << paths.size() << ", путей: "s << layout.str() << ", вагонов: "s << wagon_count;
+    PrintNetworkReport(YardNetwork(std::move(config)).Run(), log);
+    return 0;
+}
+
+// Смена со случайными командами дежурного.
+int RunShift(const AppOptions& options, LogSink& log) {
+    using namespace std::literals;
+
+    std::string resume_data;
+    if (!options.resume_path.empty()) {
+        resume_data = ReadSnapshotFile(options.resume_path);
+    }
+    const bool resume = !resume_data.empty();
+
+    size_t number_of_paths = resume ? GetSnapshotNumberOfPaths(resume_data)
+                                    : static_cast<size_t>(RandomGen::GetInRange(2, 15));
+    SortingHill sorting_hill = MakeSortingHill(number_of_paths, options, log);
+
+    std::unique_ptr<ShiftRecorder> recorder;
+    if (!options.record_path.empty()) {
+        RecordedStation station;
+        station.number_of_paths = number_of_paths;
+        station.ring_limits = options.ring_limits;
+        station.hump_reordering = options.hump_reordering;
+        station.dispatch_policy = options.dispatch_policy;
+        station.planning_window = options.plan_window;
+        station.loco_assignment = options.loco_assignment;
+        recorder = std::make_unique<ShiftRecorder>(options.record_path, station);
+        sorting_hill.SetRecorder(recorder.get());
+    }
+
+    // Ведомость подаётся в станцию порциями по ходу смены.
+    std::unique_ptr<ManifestSource> manifest;
+    if (!options.manifest_path.empty()) {
+        manifest = std::make_unique<ManifestSource>(options.manifest_path);
+        sorting_hill.AttachWagonSource(manifest.get());
+    }
+
+    // Вагоны разыгрываются заранее: генераторы не рассчитаны на вызовы из нескольких потоков.
+    const size_t lines = static_cast<size_t>(options.feed_lines);
+    std::vector<std::vector<Wagon>> line_wagons(lines);
+
+    WorkloadConfig workload = options.workload;
+    if (!options.seed_set) {
+        workload.seed = std::random_device{}();
+    }
+    workload.first_wagon_number = RandomGen::GetInRange(0, 89999999);
+    WorkloadGenerator generator(workload);
+
+    const size_t wagon_left = manifest || resume ? 0
+                              : options.wagons > 0 ? options.wagons
+                                                   : static_cast<size_t>(RandomGen::GetInRange(1024, 4095));
+    SimulationConfig simulation;
+    simulation.horizon = options.sim_hours * 3600.0;
+    simulation.inbound_interval = options.inbound_interval;
+
+    const std::vector<Wagon> wagons = generator.GenerateWagons(wagon_left);
+    if (options.locate_wagon && !wagons.empty()) {
+        // Номера вагонов случайные: подсказка, какие номера есть в этой смене.
+        log.Log() << "Номера вагонов смены: "s << wagons.front().number << " - "s << wagons.back().number;
+    }
+    for (size_t i = 0; i < wagons.size(); ++i) {
+        if (options.simulate && options.inbound_interval > 0.0) {
+            simulation.inbound_wagons.push_back(wagons[i]);
+        } else if (lines == 0) {
+            sorting_hill.AddWagon(wagons[i]);
+        } else {
+            line_wagons[i % lines].push_back(wagons[i]);
+        }
+    }
+
+    WagonIntake intake;
+    std::vector<std::thread> feeders;
+    if (lines > 0) {
+        sorting_hill.AttachWagonSource(&intake);
+    }
+
+    // Команды выбираются только среди допустимых: каждая итерация выполняет команду.
+    std::unique_ptr<Dispatcher> dispatcher;
+    SnapshotRngs snapshot_rngs;
+    snapshot_rngs.workload = &generator;
+    if (options.adaptive_dispatcher) {
+        dispatcher = std::make_unique<AdaptiveDispatcher>();
+    } else {
+        auto scheduler = std::make_unique<EventScheduler>(workload.seed + 1, workload);
+        snapshot_rngs.scheduler = scheduler.get();
+        dispatcher = std::move(scheduler);
+    }
+
+    if (resume) {
+        // Смена продолжается со снимка: вагоны, состояние путей и генераторы уже в нём.
+        RestoreSnapshot(sorting_hill, resume_data, snapshot_rngs);
+        log.Log() << "Смена продолжена со снимка "s << options.resume_path;
+    } else {
+        sorting_hill.HandleEvent(EventType::kShiftStarted);
+    }
+
+    for (const auto& wagons : line_wagons) {
+        feeders.emplace_back([&intake, &wagons] {
+            for (const Wagon& wagon : wagons) {
+                intake.Push(wagon);
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        });
+    }
+    std::thread closer;
+    if (lines > 0) {
+        closer = std::thread([&intake, &feeders] {
+            for (auto& feeder : feeders) {
+                feeder.join();
+            }
+            intake.Close();
+        });
+    }
+
+    if (options.simulate) {
+        ShiftSimulator simulator(sorting_hill, *dispatcher, generator, std::move(simulation));
+        const SimulationReport report = simulator.Run();
+        // Команды смены ещё печатает поток наблюдателей: отчёт - после них.
+        sorting_hill.FlushObservers();
+        PrintSimulationReport(report, log);
+        if (!options.checkpoint_path.empty()) {
+            WriteSnapshotFile(sorting_hill, options.checkpoint_path, snapshot_rngs);
+        }
+        sorting_hill.HandleEvent(EventType::kShiftEnded);
+        return 0;
+    }
+    size_t handled_commands = 0;
+    while (sorting_hill.HasIncomingWagons()) {
         try {
-            auto next_event = RandomGen::GetRandomElem<EventType>(kEventsBalanced);
-            if (sorting_hill.CheckEvent(next_event)) {
-                std::cout << "Команда дежурного: "s << next_event << std::endl;
-                sorting_hill.HandleEvent(next_event);
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            const std::optional<EventType> next_event = dispatcher->NextEvent(sorting_hill);
+            if (!next_event) {
+                // Ни одна команда сейчас невозможна - ждём вагоны входящих линий.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (!options.async_observers) {
+                log.Log() << "Команда дежурного: "s << *next_event;
+            }
+            if (*next_event == EventType::kLocoArrived) {
+                sorting_hill.HandleLocoArrived(generator.NextLocoType());
+            } else if (*next_event == EventType::kWagonArrived && options.wagon_batch > 1) {
+                sorting_hill.HandleWagonBatch(options.wagon_batch);
+            } else {
+                sorting_hill.HandleEvent(*next_event);
+            }
+            if (options.locate_wagon) {
+                LogWagonLocation(sorting_hill, *options.locate_wagon, log);
+            }
+            if (!options.checkpoint_path.empty() && ++handled_commands % kCheckpointInterval == 0) {
+                WriteSnapshotFile(sorting_hill, options.checkpoint_path, snapshot_rngs);
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
         } catch (const std::out_of_range& error_message) {
             std::cerr << "Произошла ошибка обработки: "s << error_message.what() << std::endl;
         } catch (const std::exception& exc) {
             std::cerr << "Общая ошибка: "s << exc.what() << std::endl;
         }
     }
+    if (closer.joinable()) {
+        closer.join();
+    }
+    if (!options.checkpoint_path.empty()) {
+        WriteSnapshotFile(sorting_hill, options.checkpoint_path, snapshot_rngs);
+    }
     sorting_hill.HandleEvent(EventType::kShiftEnded);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    using namespace std::literals;
+
+    AppOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& exc) {
+        std::cerr << exc.what() << std::endl;
+        return 1;
+    }
+
+    // Без --seed число путей, вагонов и их номера случайны от запуска к запуску.
+    if (options.seed_set) {
+        RandomGen::Seed(options.workload.seed);
+    }
+
+    // Журнал создаётся первым: репортёр пишет в него до разрушения станции.
+    LogSink log(std::cout);
+
+    try {
+        if (!options.replay_path.empty()) {
+            return RunReplay(options, log);
+        }
+        if (options.humps > 0) {
+            return RunYard(options, log);
+        }
+        if (options.network > 0) {
+            return RunNetwork(options, log);
+        }
+        return RunShift(options, log);
+    } catch (const std::exception& exc) {
+        std::cerr << "Ошибка: "s << exc.what() << std::endl;
+        return 1;
+    }
 }
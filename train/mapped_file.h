@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Файл, отображённый в память только для чтения.
+// Бросает std::runtime_error, если файл не удалось открыть или отобразить.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* Data() const {
+        return data_;
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+    // Подсказка ОС: диапазон [0, end) прочитан и больше не нужен, страницы можно вытеснить.
+    // Данные остаются доступны (будут перечитаны с диска при обращении).
+    void ReleasePrefix(size_t end);
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t released_ = 0;
+
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Память, занятая одной структурой станции. Оценка по ёмкости контейнеров и размеру узлов,
+// без накладных расходов распределителя памяти.
+struct MemoryEntry {
+    const char* name = "";
+    size_t elements = 0;
+    size_t bytes = 0;
+    size_t peak_bytes = 0; // максимум за смену
+};
+
+namespace memory {
+
+// Блок std::deque: в libstdc++ - 512 байт (или один элемент, если он больше).
+inline constexpr size_t kDequeBlockBytes = 512;
+
+template <class T>
+size_t DequeBytes(size_t size) {
+    const size_t per_block = sizeof(T) < kDequeBlockBytes ? kDequeBlockBytes / sizeof(T) : 1;
+    const size_t blocks = size / per_block + 1;
+    return blocks * per_block * sizeof(T) + (blocks + 2) * sizeof(void*);
+}
+
+template <class T>
+size_t VectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Строка вне буфера малых строк занимает память в куче.
+inline size_t StringHeapBytes(const std::string& s) {
+    static const size_t kInlineCapacity = std::string().capacity();
+    return s.capacity() > kInlineCapacity ? s.capacity() + 1 : 0;
+}
+
+// Корзины + узлы (значение, указатель на следующий, сохранённый хеш).
+template <class K, class V>
+size_t HashMapBytes(const std::unordered_map<K, V>& map) {
+    return map.bucket_count() * sizeof(void*)
+        + map.size() * (sizeof(typename std::unordered_map<K, V>::value_type) + 2 * sizeof(void*));
+}
+
+template <class K, class V>
+size_t HashMapBytes(const std::unordered_multimap<K, V>& map) {
+    return map.bucket_count() * sizeof(void*)
+        + map.size() * (sizeof(typename std::unordered_multimap<K, V>::value_type) + 2 * sizeof(void*));
+}
+
+// Обновить максимумы peaks по текущим значениям entries (одинаковый порядок записей).
+inline void UpdatePeaks(const std::vector<MemoryEntry>& entries, std::vector<MemoryEntry>& peaks) {
+    if (peaks.size() != entries.size()) {
+        peaks = entries;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].bytes > peaks[i].peak_bytes) {
+            peaks[i].peak_bytes = entries[i].bytes;
+        }
+    }
+}
+
+} // namespace memory
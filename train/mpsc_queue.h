@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Ограниченная очередь "много писателей - один читатель" без блокировок
+// (ячейки с порядковыми номерами по схеме Д. Вьюкова).
+// TryPush можно вызывать из любых потоков, TryPop и Empty - только из потока-потребителя.
+// Ёмкость округляется вверх до степени двойки.
+template <class T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity)
+        : capacity_(RoundUpPow2_(capacity)),
+          mask_(capacity_ - 1),
+          cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    bool TryPush(const T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // очередь заполнена
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out) {
+        Cell& cell = cells_[dequeue_pos_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            return false;
+        }
+        out = std::move(cell.value);
+        cell.sequence.store(dequeue_pos_ + capacity_, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    // Нет опубликованных элементов. Запись, начатая, но не завершённая писателем, не видна.
+    bool Empty() const {
+        const Cell& cell = cells_[dequeue_pos_ & mask_];
+        return cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t RoundUpPow2_(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) size_t dequeue_pos_ = 0;
+};
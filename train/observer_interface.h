@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common.h"
+
+// Наблюдатель за станцией: только читает применённые операции и метрики.
+// В отличие от SortingHandler не получает доступа к SortingHill и поэтому
+// может работать в отдельном потоке (см. ObserverPipeline).
+class SortingObserver {
+public:
+    virtual ~SortingObserver() = default;
+
+    /* Начало смены. */
+    virtual void OnShiftStarted(const HillMetrics& metrics) = 0;
+
+    /* Операция применена к станции; metrics - состояние после неё. */
+    virtual void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) = 0;
+
+    /* Окончание смены. */
+    virtual void OnShiftEnded(const HillMetrics& metrics) = 0;
+
+    /* Нужны ли состав отправленного поезда и текст операции (OperationInfo сверх OperationSummary).
+       В отдельный поток (ObserverPipeline) они передаются только тем, кому нужны. */
+    virtual bool NeedsOperationDetails() const {
+        return false;
+    }
+
+    /* Ждёт, пока всё полученное обработано. Синхронному наблюдателю ждать нечего. */
+    virtual void Flush() {
+    }
+};
@@ -0,0 +1,137 @@
+#include "observer_pipeline.h"
+
+#include <chrono>
+#include <utility>
+
+ObserverPipeline::ObserverPipeline(std::vector<std::unique_ptr<SortingObserver>> observers,
+                                   size_t capacity,
+                                   OverflowPolicy policy)
+    : observers_(std::move(observers)),
+      policy_(policy),
+      queue_(capacity) {
+    for (const auto& observer : observers_) {
+        needs_details_ = needs_details_ || observer->NeedsOperationDetails();
+    }
+    consumer_ = std::thread([this] { ConsumerLoop_(); });
+}
+
+ObserverPipeline::~ObserverPipeline() {
+    stop_.store(true);
+    WakeConsumer_();
+    if (consumer_.joinable()) {
+        consumer_.join();
+    }
+}
+
+void ObserverPipeline::OnShiftStarted(const HillMetrics& metrics) {
+    ObservedEvent event;
+    event.kind = ObservedEvent::Kind::kShiftStarted;
+    event.metrics = metrics;
+    Publish_(std::move(event), /*may_drop=*/false);
+}
+
+void ObserverPipeline::OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) {
+    ObservedEvent event;
+    event.kind = ObservedEvent::Kind::kOperation;
+    static_cast<OperationSummary&>(event.operation) = operation_info;
+    if (needs_details_) {
+        event.operation.departed_wagons = operation_info.departed_wagons;
+        event.operation.message = operation_info.message;
+    }
+    event.metrics = metrics;
+    Publish_(std::move(event), /*may_drop=*/true);
+}
+
+void ObserverPipeline::OnShiftEnded(const HillMetrics& metrics) {
+    ObservedEvent event;
+    event.kind = ObservedEvent::Kind::kShiftEnded;
+    event.metrics = metrics;
+    Publish_(std::move(event), /*may_drop=*/false);
+}
+
+bool ObserverPipeline::NeedsOperationDetails() const {
+    return needs_details_;
+}
+
+void ObserverPipeline::Drain() {
+    const size_t target = published_;
+    while (consumed_.load(std::memory_order_acquire) < target) {
+        WakeConsumer_();
+        std::this_thread::yield();
+    }
+}
+
+void ObserverPipeline::Flush() {
+    Drain();
+}
+
+size_t ObserverPipeline::GetDroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void ObserverPipeline::Publish_(ObservedEvent&& event, bool may_drop) {
+    while (!queue_.TryPush(std::move(event))) {
+        if (may_drop && policy_ == OverflowPolicy::kDrop) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        WakeConsumer_();
+        std::this_thread::yield();
+    }
+    ++published_;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_sleeping_.load()) {
+        WakeConsumer_();
+    }
+}
+
+void ObserverPipeline::Dispatch_(const ObservedEvent& event) {
+    for (const auto& observer : observers_) {
+        switch (event.kind) {
+            case ObservedEvent::Kind::kShiftStarted:
+                observer->OnShiftStarted(event.metrics);
+                break;
+            case ObservedEvent::Kind::kOperation:
+                observer->OnOperation(event.operation, event.metrics);
+                break;
+            case ObservedEvent::Kind::kShiftEnded:
+                observer->OnShiftEnded(event.metrics);
+                break;
+        }
+    }
+}
+
+void ObserverPipeline::WakeConsumer_() {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+}
+
+void ObserverPipeline::ConsumerLoop_() {
+    using namespace std::chrono_literals;
+
+    ObservedEvent event;
+    size_t consumed = 0;
+
+    while (true) {
+        if (queue_.TryPop(event)) {
+            Dispatch_(event);
+            consumed_.store(++consumed, std::memory_order_release);
+            continue;
+        }
+
+        if (stop_.load()) {
+            if (queue_.EmptyApprox()) {
+                break;
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        consumer_sleeping_.store(true);
+        if (queue_.EmptyApprox() && !stop_.load()) {
+            wake_cv_.wait_for(lock, 10ms);
+        }
+        consumer_sleeping_.store(false);
+    }
+}
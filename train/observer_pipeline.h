@@ -0,0 +1,73 @@
+#pragma once
+
+#include "observer_interface.h"
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Наблюдатели вне критического пути.
+// Станция публикует каждую применённую операцию вместе с метриками в ограниченную
+// очередь SpscRing, а отдельный поток раздаёт их подключённым наблюдателям по порядку.
+// В очередь копируется только OperationSummary; состав поезда и текст - если они нужны
+// кому-то из наблюдателей (SortingObserver::NeedsOperationDetails).
+// Публиковать можно только из одного потока (потока симуляции).
+class ObserverPipeline : public SortingObserver {
+public:
+    explicit ObserverPipeline(std::vector<std::unique_ptr<SortingObserver>> observers,
+                              size_t capacity = 1024,
+                              OverflowPolicy policy = OverflowPolicy::kBlock);
+    ~ObserverPipeline() override;
+
+    ObserverPipeline(const ObserverPipeline&) = delete;
+    ObserverPipeline& operator=(const ObserverPipeline&) = delete;
+
+    void OnShiftStarted(const HillMetrics& metrics) override;
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override;
+    void OnShiftEnded(const HillMetrics& metrics) override;
+    bool NeedsOperationDetails() const override;
+
+    // Ждёт, пока наблюдатели обработают всё опубликованное.
+    void Drain();
+    void Flush() override;
+
+    // Операции, отброшенные по политике kDrop. События начала и конца смены не теряются.
+    size_t GetDroppedCount() const;
+
+private:
+    struct ObservedEvent {
+        enum class Kind { kShiftStarted, kOperation, kShiftEnded };
+
+        Kind kind = Kind::kOperation;
+        OperationInfo operation;
+        HillMetrics metrics;
+    };
+
+private:
+    std::vector<std::unique_ptr<SortingObserver>> observers_;
+    bool needs_details_ = false;
+    const OverflowPolicy policy_;
+    SpscRing<ObservedEvent> queue_;
+
+    size_t published_ = 0; // только поток-производитель
+    std::atomic<size_t> consumed_{0};
+    std::atomic<size_t> dropped_{0};
+
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> consumer_sleeping_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+
+    std::thread consumer_;
+
+private:
+    void Publish_(ObservedEvent&& event, bool may_drop);
+    void Dispatch_(const ObservedEvent& event);
+    void WakeConsumer_();
+    void ConsumerLoop_();
+};
@@ -0,0 +1,276 @@
+#include "operation_journal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+// Номер поезда "0001Г" -> 1
+std::int32_t ParseTrainId(const std::string& train_number) {
+    std::int32_t id = 0;
+    bool any = false;
+    for (char c : train_number) {
+        if (c < '0' || c > '9') {
+            break;
+        }
+        id = id * 10 + (c - '0');
+        any = true;
+    }
+    return any ? id : -1;
+}
+
+std::uint32_t LoadU32(const char* column, size_t row) {
+    const auto* p = reinterpret_cast<const unsigned char*>(column + 4 * row);
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+           static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+} // namespace
+
+OperationJournal::OperationJournal(const std::string& path, std::uint32_t block_rows)
+    : out_(path, std::ios::binary | std::ios::trunc),
+      block_rows_(block_rows == 0 ? journal::kDefaultBlockRows : block_rows) {
+    if (!out_) {
+        throw std::runtime_error("Не удалось открыть файл журнала: "s + path);
+    }
+
+    BinaryWriter header;
+    header.WriteBytes(journal::kMagic, sizeof(journal::kMagic));
+    header.WriteU16(journal::kVersion);
+    header.WriteU16(0);
+    header.WriteU32(block_rows_);
+    header.WriteU32(0);
+    out_.write(header.Data().data(), static_cast<std::streamsize>(header.Size()));
+
+    event_type_.reserve(block_rows_);
+    success_.reserve(block_rows_);
+    path_id_.reserve(block_rows_);
+    train_id_.reserve(block_rows_);
+    wagon_.reserve(block_rows_);
+    ring_total_.reserve(block_rows_);
+    train_wagons_.reserve(block_rows_);
+}
+
+OperationJournal::~OperationJournal() {
+    try {
+        FlushBlock_();
+        out_.flush();
+    } catch (...) {
+    }
+}
+
+void OperationJournal::OnShiftStarted(const HillMetrics& metrics) {
+    OperationInfo marker;
+    marker.event_type = EventType::kShiftStarted;
+    marker.success = true;
+    OnOperation(marker, metrics);
+}
+
+void OperationJournal::OnOperation(const OperationInfo& op, const HillMetrics& metrics) {
+    event_type_.push_back(static_cast<std::uint8_t>(op.event_type));
+    success_.push_back(op.success ? 1 : 0);
+    path_id_.push_back(op.path_id ? *op.path_id : -1);
+    train_id_.push_back(op.train_number ? ParseTrainId(*op.train_number) : -1);
+    wagon_.push_back(op.wagon ? op.wagon->number : -1);
+    ring_total_.push_back(static_cast<std::uint32_t>(metrics.ring_total));
+    train_wagons_.push_back(op.train_wagons ? static_cast<std::int32_t>(*op.train_wagons) : -1);
+
+    if (event_type_.size() >= block_rows_) {
+        FlushBlock_();
+    }
+}
+
+void OperationJournal::OnShiftEnded(const HillMetrics&) {
+    FlushBlock_();
+    out_.flush();
+}
+
+size_t OperationJournal::GetRowsWritten() const {
+    return rows_written_;
+}
+
+void OperationJournal::FlushBlock_() {
+    const size_t rows = event_type_.size();
+    if (rows == 0) {
+        return;
+    }
+
+    block_.Clear();
+    block_.WriteU32(static_cast<std::uint32_t>(rows));
+    block_.WriteU32(0);
+
+    const size_t pad = journal::PaddedBytes(rows) - rows;
+    const char zeros[4] = {0, 0, 0, 0};
+    block_.WriteBytes(event_type_.data(), rows);
+    block_.WriteBytes(zeros, pad);
+    block_.WriteBytes(success_.data(), rows);
+    block_.WriteBytes(zeros, pad);
+    for (std::int32_t v : path_id_) block_.WriteI32(v);
+    for (std::int32_t v : train_id_) block_.WriteI32(v);
+    for (std::int32_t v : wagon_) block_.WriteI32(v);
+    for (std::uint32_t v : ring_total_) block_.WriteU32(v);
+    for (std::int32_t v : train_wagons_) block_.WriteI32(v);
+
+    out_.write(block_.Data().data(), static_cast<std::streamsize>(block_.Size()));
+    if (!out_) {
+        throw std::runtime_error("Ошибка записи журнала операций"s);
+    }
+    rows_written_ += rows;
+
+    event_type_.clear();
+    success_.clear();
+    path_id_.clear();
+    train_id_.clear();
+    wagon_.clear();
+    ring_total_.clear();
+    train_wagons_.clear();
+}
+
+EventType JournalReader::Block::GetEventType(size_t row) const {
+    return static_cast<EventType>(static_cast<unsigned char>(event_type_[row]));
+}
+
+bool JournalReader::Block::GetSuccess(size_t row) const {
+    return success_[row] != 0;
+}
+
+std::int32_t JournalReader::Block::GetPathId(size_t row) const {
+    return static_cast<std::int32_t>(LoadU32(path_id_, row));
+}
+
+std::int32_t JournalReader::Block::GetTrainId(size_t row) const {
+    return static_cast<std::int32_t>(LoadU32(train_id_, row));
+}
+
+std::int32_t JournalReader::Block::GetWagon(size_t row) const {
+    return static_cast<std::int32_t>(LoadU32(wagon_, row));
+}
+
+std::uint32_t JournalReader::Block::GetRingTotal(size_t row) const {
+    return LoadU32(ring_total_, row);
+}
+
+std::int32_t JournalReader::Block::GetTrainWagons(size_t row) const {
+    return static_cast<std::int32_t>(LoadU32(train_wagons_, row));
+}
+
+JournalReader::JournalReader(const std::string& path)
+    : file_(path) {
+    BinaryReader header(file_.Data(), file_.Size());
+    char magic[sizeof(journal::kMagic)];
+    header.ReadBytes(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(journal::kMagic))) {
+        throw std::runtime_error("Файл не является журналом операций: "s + path);
+    }
+    if (header.ReadU16() != journal::kVersion) {
+        throw std::runtime_error("Неподдерживаемая версия журнала операций"s);
+    }
+
+    size_t pos = journal::kHeaderSize;
+    while (pos < file_.Size()) {
+        BinaryReader block_header(file_.Data() + pos, file_.Size() - pos);
+        const size_t rows = block_header.ReadU32();
+        const size_t size = journal::BlockSize(rows);
+        if (rows == 0 || file_.Size() - pos < size) {
+            throw std::runtime_error("Повреждённый блок журнала операций"s);
+        }
+
+        Block block;
+        block.rows_ = rows;
+        const char* p = file_.Data() + pos + journal::kBlockHeaderSize;
+        block.event_type_ = p;
+        p += journal::PaddedBytes(rows);
+        block.success_ = p;
+        p += journal::PaddedBytes(rows);
+        block.path_id_ = p;
+        p += 4 * rows;
+        block.train_id_ = p;
+        p += 4 * rows;
+        block.wagon_ = p;
+        p += 4 * rows;
+        block.ring_total_ = p;
+        p += 4 * rows;
+        block.train_wagons_ = p;
+
+        blocks_.push_back(block);
+        rows_ += rows;
+        pos += size;
+    }
+}
+
+size_t JournalReader::GetRowsCount() const {
+    return rows_;
+}
+
+const std::vector<JournalReader::Block>& JournalReader::GetBlocks() const {
+    return blocks_;
+}
+
+std::array<size_t, 7> JournalReader::CountEvents(bool successful_only) const {
+    std::array<size_t, 7> counts{};
+    for (const Block& block : blocks_) {
+        for (size_t row = 0; row < block.Rows(); ++row) {
+            if (successful_only && !block.GetSuccess(row)) {
+                continue;
+            }
+            const auto type = static_cast<size_t>(block.GetEventType(row));
+            if (type < counts.size()) {
+                counts[type]++;
+            }
+        }
+    }
+    return counts;
+}
+
+std::vector<std::uint32_t> JournalReader::RingOccupancy(size_t bucket_rows) const {
+    std::vector<std::uint32_t> series;
+    if (bucket_rows == 0) {
+        return series;
+    }
+
+    size_t in_bucket = 0;
+    std::uint32_t bucket_max = 0;
+    for (const Block& block : blocks_) {
+        for (size_t row = 0; row < block.Rows(); ++row) {
+            bucket_max = std::max(bucket_max, block.GetRingTotal(row));
+            if (++in_bucket == bucket_rows) {
+                series.push_back(bucket_max);
+                in_bucket = 0;
+                bucket_max = 0;
+            }
+        }
+    }
+    if (in_bucket > 0) {
+        series.push_back(bucket_max);
+    }
+    return series;
+}
+
+std::map<JournalReader::TrainKey, std::int32_t> JournalReader::WagonsPerTrain() const {
+    std::map<TrainKey, std::int32_t> trains;
+    // Строки до первой отметки (журнал без отметок смен) относятся к смене 0.
+    std::uint32_t shift = 0;
+    bool shift_seen = false;
+    for (const Block& block : blocks_) {
+        for (size_t row = 0; row < block.Rows(); ++row) {
+            if (block.GetEventType(row) == EventType::kShiftStarted) {
+                if (shift_seen) {
+                    ++shift;
+                }
+                shift_seen = true;
+                continue;
+            }
+            if (block.GetEventType(row) != EventType::kTrainReady || !block.GetSuccess(row)) {
+                continue;
+            }
+            const std::int32_t train_id = block.GetTrainId(row);
+            if (train_id >= 0) {
+                trains[{shift, train_id}] = std::max<std::int32_t>(0, block.GetTrainWagons(row));
+            }
+        }
+    }
+    return trains;
+}
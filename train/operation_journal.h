@@ -0,0 +1,137 @@
+#pragma once
+
+#include "binary_io.h"
+#include "mapped_file.h"
+#include "observer_interface.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Столбцовый журнал применённых операций.
+//
+// Формат: заголовок "OPJR", версия (u16), резерв (u16), строк в полном блоке (u32), резерв (u32),
+// затем блоки. Блок: число строк n (u32), резерв (u32) и столбцы подряд:
+//   event_type    u8[n]   EventType
+//   success       u8[n]
+//   path_id       i32[n]  -1 - нет
+//   train_id      i32[n]  номер поезда без буквы, -1 - нет
+//   wagon         i32[n]  номер вагона, -1 - нет
+//   ring_total    u32[n]  заполнение кольца после операции
+//   train_wagons  i32[n]  вагонов в поезде после операции (при отправке - в ушедшем), -1 - нет
+// Столбцы u8 дополнены нулями до кратности 4, все числа в little-endian.
+// Каждая смена начинается строкой kShiftStarted без поезда и вагона: номера поездов
+// повторяются от смены к смене, и читатель отличает их по этим отметкам.
+namespace journal {
+
+inline constexpr char kMagic[4] = {'O', 'P', 'J', 'R'};
+inline constexpr std::uint16_t kVersion = 1;
+inline constexpr size_t kHeaderSize = 16;
+inline constexpr size_t kBlockHeaderSize = 8;
+inline constexpr std::uint32_t kDefaultBlockRows = 4096;
+
+// Размер столбца u8 с выравниванием на 4 байта.
+inline size_t PaddedBytes(size_t n) {
+    return (n + 3) / 4 * 4;
+}
+
+inline size_t BlockSize(size_t rows) {
+    return kBlockHeaderSize + 2 * PaddedBytes(rows) + 5 * 4 * rows;
+}
+
+} // namespace journal
+
+// Наблюдатель, дописывающий каждую операцию в журнал. Блоки пишутся по заполнении
+// и в конце смены; файл закрывается в деструкторе.
+class OperationJournal : public SortingObserver {
+public:
+    explicit OperationJournal(const std::string& path,
+                              std::uint32_t block_rows = journal::kDefaultBlockRows);
+    ~OperationJournal() override;
+
+    OperationJournal(const OperationJournal&) = delete;
+    OperationJournal& operator=(const OperationJournal&) = delete;
+
+    void OnShiftStarted(const HillMetrics& metrics) override;
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override;
+    void OnShiftEnded(const HillMetrics& metrics) override;
+
+    size_t GetRowsWritten() const;
+
+private:
+    std::ofstream out_;
+    const std::uint32_t block_rows_;
+    size_t rows_written_ = 0;
+
+    std::vector<std::uint8_t> event_type_;
+    std::vector<std::uint8_t> success_;
+    std::vector<std::int32_t> path_id_;
+    std::vector<std::int32_t> train_id_;
+    std::vector<std::int32_t> wagon_;
+    std::vector<std::uint32_t> ring_total_;
+    std::vector<std::int32_t> train_wagons_;
+
+    BinaryWriter block_;
+
+private:
+    void FlushBlock_();
+};
+
+// Чтение журнала через отображение файла в память, без разбора текста.
+class JournalReader {
+public:
+    // Один блок журнала: указатели на столбцы внутри отображённого файла.
+    class Block {
+    public:
+        size_t Rows() const {
+            return rows_;
+        }
+
+        EventType GetEventType(size_t row) const;
+        bool GetSuccess(size_t row) const;
+        std::int32_t GetPathId(size_t row) const;
+        std::int32_t GetTrainId(size_t row) const;
+        std::int32_t GetWagon(size_t row) const;
+        std::uint32_t GetRingTotal(size_t row) const;
+        std::int32_t GetTrainWagons(size_t row) const;
+
+    private:
+        friend class JournalReader;
+
+        size_t rows_ = 0;
+        const char* event_type_ = nullptr;
+        const char* success_ = nullptr;
+        const char* path_id_ = nullptr;
+        const char* train_id_ = nullptr;
+        const char* wagon_ = nullptr;
+        const char* ring_total_ = nullptr;
+        const char* train_wagons_ = nullptr;
+    };
+
+    explicit JournalReader(const std::string& path);
+
+    size_t GetRowsCount() const;
+    const std::vector<Block>& GetBlocks() const;
+
+    // Число операций каждого типа (индекс - EventType).
+    std::array<size_t, 7> CountEvents(bool successful_only) const;
+
+    // Заполнение кольца во времени: максимум ring_total в каждом окне из bucket_rows операций.
+    std::vector<std::uint32_t> RingOccupancy(size_t bucket_rows) const;
+
+    // Поезд журнала: порядковый номер смены (с нуля) и номер поезда в ней.
+    using TrainKey = std::pair<std::uint32_t, std::int32_t>;
+
+    // Вагонов в каждом отправленном поезде: (смена, номер поезда) -> вагонов при отправке.
+    std::map<TrainKey, std::int32_t> WagonsPerTrain() const;
+
+private:
+    MappedFile file_;
+    std::vector<Block> blocks_;
+    size_t rows_ = 0;
+};
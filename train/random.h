@@ -3,7 +3,12 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 class RandomGen {
 public:
@@ -28,6 +33,38 @@ public:
         return dist(Generator());
     }
 
+    // Воспроизводимый прогон (--seed): все случайные параметры смены - от одного числа.
+    static void Seed(std::uint64_t seed) {
+        std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+        Generator().seed(seq);
+    }
+
+    // Состояние генератора для снимка станции (текстовое представление std::mt19937).
+    static std::string SaveState() {
+        std::ostringstream out;
+        out << Generator();
+        return out.str();
+    }
+
+    // Разбор состояния без применения: снимок проверяется целиком до того, как что-то меняется.
+    static std::mt19937 ParseState(const std::string& state) {
+        std::istringstream in(state);
+        std::mt19937 restored;
+        in >> restored;
+        if (in.fail()) {
+            throw std::runtime_error("Повреждённое состояние генератора случайных чисел");
+        }
+        return restored;
+    }
+
+    static void SetState(const std::mt19937& state) {
+        Generator() = state;
+    }
+
+    static void LoadState(const std::string& state) {
+        SetState(ParseState(state));
+    }
+
 private:
     static std::mt19937& Generator() {
         static std::mt19937 random_gen(std::random_device{}());
@@ -0,0 +1,162 @@
+#include "shared_metrics.h"
+
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace shared_metrics {
+
+std::string NormalizeName(const std::string& name) {
+    if (name.empty()) {
+        throw std::invalid_argument("Пустое имя сегмента разделяемой памяти"s);
+    }
+    return name.front() == '/' ? name : "/"s + name;
+}
+
+} // namespace shared_metrics
+
+namespace {
+
+using Values = std::array<std::uint64_t, shared_metrics::kValues>;
+
+Values ToValues(const HillMetrics& metrics, bool shift_active) {
+    return {
+        shift_active ? 1u : 0u,
+        metrics.sent_trains,
+        metrics.ring_total,
+        metrics.ring_max,
+        metrics.missed_wagons[0],
+        metrics.missed_wagons[1],
+        metrics.missed_wagons[2],
+        metrics.missed_wagons[3],
+        metrics.open_trains,
+        metrics.busy_paths,
+        metrics.processed_wagons,
+        metrics.buffer_wagons,
+        metrics.handled_events,
+        0, // резерв
+    };
+}
+
+SharedHillState FromValues(const Values& values, std::uint64_t sequence) {
+    SharedHillState state;
+    state.publications = sequence / 2;
+    state.shift_active = values[0] != 0;
+    state.sent_trains = values[1];
+    state.ring_total = values[2];
+    state.ring_max = values[3];
+    for (size_t i = 0; i < state.missed_wagons.size(); ++i) {
+        state.missed_wagons[i] = values[4 + i];
+    }
+    state.open_trains = values[8];
+    state.busy_paths = values[9];
+    state.processed_wagons = values[10];
+    state.buffer_wagons = values[11];
+    state.handled_events = values[12];
+    return state;
+}
+
+} // namespace
+
+SharedMetricsPublisher::SharedMetricsPublisher(const std::string& name)
+    : name_(shared_metrics::NormalizeName(name)) {
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Не удалось создать сегмент разделяемой памяти: "s + name_);
+    }
+    if (ftruncate(fd, sizeof(shared_metrics::Segment)) != 0) {
+        close(fd);
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Не удалось задать размер сегмента: "s + name_);
+    }
+    void* data = mmap(nullptr, sizeof(shared_metrics::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Не удалось отобразить сегмент: "s + name_);
+    }
+
+    segment_ = new (data) shared_metrics::Segment{};
+    segment_->magic = shared_metrics::kMagic;
+    segment_->version = shared_metrics::kVersion;
+    Publish(HillMetrics{}, false);
+}
+
+SharedMetricsPublisher::~SharedMetricsPublisher() {
+    munmap(segment_, sizeof(shared_metrics::Segment));
+    shm_unlink(name_.c_str());
+}
+
+void SharedMetricsPublisher::OnShiftStarted(const HillMetrics& metrics) {
+    Publish(metrics, true);
+}
+
+void SharedMetricsPublisher::OnOperation(const OperationInfo&, const HillMetrics& metrics) {
+    Publish(metrics, true);
+}
+
+void SharedMetricsPublisher::OnShiftEnded(const HillMetrics& metrics) {
+    Publish(metrics, false);
+}
+
+void SharedMetricsPublisher::Publish(const HillMetrics& metrics, bool shift_active) {
+    const Values values = ToValues(metrics, shift_active);
+
+    // Писатель один: нечётный счётчик - запись идёт, читатели повторяют попытку.
+    const std::uint64_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+    segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < values.size(); ++i) {
+        segment_->values[i].store(values[i], std::memory_order_relaxed);
+    }
+    segment_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+SharedMetricsReader::SharedMetricsReader(const std::string& name) {
+    const std::string shm_name = shared_metrics::NormalizeName(name);
+    const int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Сегмент разделяемой памяти не найден: "s + shm_name);
+    }
+    void* data = mmap(nullptr, sizeof(shared_metrics::Segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Не удалось отобразить сегмент: "s + shm_name);
+    }
+
+    segment_ = static_cast<const shared_metrics::Segment*>(data);
+    if (segment_->magic != shared_metrics::kMagic || segment_->version != shared_metrics::kVersion) {
+        munmap(data, sizeof(shared_metrics::Segment));
+        throw std::runtime_error("Сегмент не содержит метрик станции: "s + shm_name);
+    }
+}
+
+SharedMetricsReader::~SharedMetricsReader() {
+    munmap(const_cast<shared_metrics::Segment*>(segment_), sizeof(shared_metrics::Segment));
+}
+
+bool SharedMetricsReader::TryRead(SharedHillState& out, size_t max_attempts) const {
+    Values values{};
+    for (size_t attempt = 0; attempt < max_attempts; ++attempt) {
+        const std::uint64_t before = segment_->sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = segment_->values[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment_->sequence.load(std::memory_order_relaxed) == before) {
+            out = FromValues(values, before);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// Публикация метрик станции в разделяемую память POSIX (shm_open) под seqlock.
+// Только для POSIX-систем.
+
+#include "observer_interface.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Согласованное состояние станции, прочитанное из разделяемой памяти.
+struct SharedHillState {
+    std::uint64_t publications = 0; // сколько раз состояние публиковалось
+    bool shift_active = false;
+
+    std::uint64_t sent_trains = 0;
+    std::uint64_t ring_total = 0;
+    std::uint64_t ring_max = 0;
+    std::array<std::uint64_t, 4> missed_wagons{}; // Г, Л, О, П
+    std::uint64_t open_trains = 0;
+    std::uint64_t busy_paths = 0;
+    std::uint64_t processed_wagons = 0;
+    std::uint64_t buffer_wagons = 0;
+    std::uint64_t handled_events = 0;
+};
+
+namespace shared_metrics {
+
+inline constexpr std::uint32_t kMagic = 0x4C4C4948; // "HILL"
+inline constexpr std::uint32_t kVersion = 1;
+inline constexpr size_t kValues = 14;
+
+// Раскладка сегмента. Значения - атомики без блокировок, поэтому читатель в другом процессе
+// не вносит гонок данных; согласованность набора обеспечивает счётчик sequence
+// (нечётный - идёт запись).
+struct Segment {
+    std::uint32_t magic;
+    std::uint32_t version;
+    alignas(64) std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> values[kValues];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Для разделяемой памяти нужны атомики без блокировок");
+
+// "/name": имя сегмента POSIX начинается с '/'.
+std::string NormalizeName(const std::string& name);
+
+} // namespace shared_metrics
+
+// Наблюдатель, публикующий метрики после каждой операции. Запись - два десятка атомарных
+// сохранений без блокировок и системных вызовов; читатели поток станции не тормозят.
+// Сегмент создаётся в конструкторе и удаляется (shm_unlink) в деструкторе.
+class SharedMetricsPublisher : public SortingObserver {
+public:
+    explicit SharedMetricsPublisher(const std::string& name);
+    ~SharedMetricsPublisher() override;
+
+    SharedMetricsPublisher(const SharedMetricsPublisher&) = delete;
+    SharedMetricsPublisher& operator=(const SharedMetricsPublisher&) = delete;
+
+    void OnShiftStarted(const HillMetrics& metrics) override;
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override;
+    void OnShiftEnded(const HillMetrics& metrics) override;
+
+    void Publish(const HillMetrics& metrics, bool shift_active);
+
+private:
+    std::string name_;
+    shared_metrics::Segment* segment_ = nullptr;
+};
+
+// Читатель сегмента (только чтение, без блокировок).
+class SharedMetricsReader {
+public:
+    explicit SharedMetricsReader(const std::string& name);
+    ~SharedMetricsReader();
+
+    SharedMetricsReader(const SharedMetricsReader&) = delete;
+    SharedMetricsReader& operator=(const SharedMetricsReader&) = delete;
+
+    // Согласованный набор значений; false - за max_attempts попыток писатель
+    // каждый раз был посреди записи.
+    bool TryRead(SharedHillState& out, size_t max_attempts = 1000) const;
+
+private:
+    const shared_metrics::Segment* segment_ = nullptr;
+};
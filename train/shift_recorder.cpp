@@ -0,0 +1,193 @@
+#include "shift_recorder.h"
+#include "sorting_hill.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'H', 'R', 'C'};
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+} // namespace
+
+ShiftRecorder::ShiftRecorder(const std::string& path, const RecordedStation& station)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+        throw std::runtime_error("Не удалось открыть файл записи смены: "s + path);
+    }
+    buffer_.WriteBytes(kMagic, sizeof(kMagic));
+    buffer_.WriteU16(kVersion);
+    buffer_.WriteU32(static_cast<std::uint32_t>(station.number_of_paths));
+    buffer_.WriteU64(station.ring_limits.total);
+    for (size_t limit : station.ring_limits.per_kind) {
+        buffer_.WriteU64(limit);
+    }
+    buffer_.WriteU64(station.hump_reordering.window);
+    buffer_.WriteU64(station.hump_reordering.max_bypass);
+    buffer_.WriteF64(station.dispatch_policy.min_fill);
+    buffer_.WriteF64(station.dispatch_policy.max_age);
+    buffer_.WriteU8(station.dispatch_policy.path_pressure ? 1 : 0);
+    buffer_.WriteU64(station.planning_window);
+    buffer_.WriteU8(static_cast<std::uint8_t>(station.loco_assignment));
+}
+
+ShiftRecorder::~ShiftRecorder() {
+    try {
+        Finish();
+    } catch (...) {
+    }
+}
+
+void ShiftRecorder::RecordWagon(const Wagon& wagon) {
+    buffer_.WriteU8(kTagWagon);
+    buffer_.WriteI32(wagon.number);
+    buffer_.WriteU8(static_cast<std::uint8_t>(wagon.wagon_type));
+    FlushIfFull_();
+}
+
+void ShiftRecorder::RecordEvent(EventType event) {
+    buffer_.WriteU8(static_cast<std::uint8_t>(event));
+    FlushIfFull_();
+}
+
+void ShiftRecorder::RecordLoco(LocoType loco_type) {
+    buffer_.WriteU8(static_cast<std::uint8_t>(EventType::kLocoArrived));
+    buffer_.WriteU8(static_cast<std::uint8_t>(loco_type));
+    FlushIfFull_();
+}
+
+void ShiftRecorder::RecordModelTime(double seconds) {
+    buffer_.WriteU8(kTagTime);
+    buffer_.WriteF64(seconds);
+    FlushIfFull_();
+}
+
+void ShiftRecorder::Finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    buffer_.WriteU8(kTagEnd);
+    out_.write(buffer_.Data().data(), static_cast<std::streamsize>(buffer_.Size()));
+    buffer_.Clear();
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("Ошибка записи файла смены"s);
+    }
+}
+
+void ShiftRecorder::FlushIfFull_() {
+    if (buffer_.Size() < kFlushThreshold) {
+        return;
+    }
+    out_.write(buffer_.Data().data(), static_cast<std::streamsize>(buffer_.Size()));
+    buffer_.Clear();
+}
+
+ShiftReplay ShiftReplay::Load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Не удалось открыть запись смены: "s + path);
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    BinaryReader reader(data);
+    char magic[sizeof(kMagic)];
+    reader.ReadBytes(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(kMagic))) {
+        throw std::runtime_error("Файл не является записью смены: "s + path);
+    }
+    if (reader.ReadU16() != ShiftRecorder::kVersion) {
+        throw std::runtime_error("Неподдерживаемая версия записи смены"s);
+    }
+
+    ShiftReplay replay;
+    RecordedStation& station = replay.station_;
+    station.number_of_paths = reader.ReadU32();
+    station.ring_limits.total = static_cast<size_t>(reader.ReadU64());
+    for (size_t& limit : station.ring_limits.per_kind) {
+        limit = static_cast<size_t>(reader.ReadU64());
+    }
+    station.hump_reordering.window = static_cast<size_t>(reader.ReadU64());
+    station.hump_reordering.max_bypass = static_cast<size_t>(reader.ReadU64());
+    station.dispatch_policy.min_fill = reader.ReadF64();
+    station.dispatch_policy.max_age = reader.ReadF64();
+    station.dispatch_policy.path_pressure = reader.ReadU8() != 0;
+    station.planning_window = static_cast<size_t>(reader.ReadU64());
+    const std::uint8_t loco_assignment = reader.ReadU8();
+    if (loco_assignment > static_cast<std::uint8_t>(LocoAssignment::kCapacityAware)) {
+        throw std::runtime_error("Неизвестное правило выбора локомотива в записи смены"s);
+    }
+    station.loco_assignment = static_cast<LocoAssignment>(loco_assignment);
+
+    while (true) {
+        Record record;
+        record.tag = reader.ReadU8();
+        if (record.tag == ShiftRecorder::kTagEnd) {
+            break;
+        }
+
+        if (record.tag == ShiftRecorder::kTagWagon) {
+            record.wagon.number = reader.ReadI32();
+            const std::uint8_t type = reader.ReadU8();
+            if (type >= kWagonType.size()) {
+                throw std::runtime_error("Неизвестный тип вагона в записи смены"s);
+            }
+            record.wagon.wagon_type = static_cast<WagonType>(type);
+        } else if (record.tag == ShiftRecorder::kTagTime) {
+            record.model_time = reader.ReadF64();
+        } else if (record.tag <= static_cast<std::uint8_t>(EventType::kShiftEnded)) {
+            if (record.tag == static_cast<std::uint8_t>(EventType::kLocoArrived)) {
+                const std::uint8_t type = reader.ReadU8();
+                if (type >= kLocoType.size()) {
+                    throw std::runtime_error("Неизвестный тип локомотива в записи смены"s);
+                }
+                record.loco_type = static_cast<LocoType>(type);
+            }
+            replay.events_count_++;
+        } else {
+            throw std::runtime_error("Повреждённая запись смены"s);
+        }
+
+        replay.records_.push_back(record);
+    }
+
+    return replay;
+}
+
+size_t ShiftReplay::GetNumberOfPaths() const {
+    return station_.number_of_paths;
+}
+
+const RecordedStation& ShiftReplay::GetStation() const {
+    return station_;
+}
+
+size_t ShiftReplay::GetEventsCount() const {
+    return events_count_;
+}
+
+void ShiftReplay::Run(SortingHill& sorting_hill) const {
+    for (const Record& record : records_) {
+        if (record.tag == ShiftRecorder::kTagWagon) {
+            sorting_hill.AddWagon(record.wagon);
+            continue;
+        }
+        if (record.tag == ShiftRecorder::kTagTime) {
+            sorting_hill.SetModelTime(record.model_time);
+            continue;
+        }
+
+        const auto event = static_cast<EventType>(record.tag);
+        if (event == EventType::kLocoArrived) {
+            sorting_hill.HandleLocoArrived(record.loco_type);
+        } else {
+            sorting_hill.HandleEvent(event);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "binary_io.h"
+#include "common.h"
+#include "station_runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class SortingHill;
+
+// Настройки станции, от которых зависит ход смены: с другими настройками воспроизведение
+// разошлось бы с записью (другой вагон через горку, другая отправка, другой локомотив).
+struct RecordedStation {
+    size_t number_of_paths = 0;
+    RingLimits ring_limits;
+    HumpReordering hump_reordering;
+    DispatchPolicy dispatch_policy;
+    size_t planning_window = 0;
+    LocoAssignment loco_assignment = LocoAssignment::kFifo;
+};
+
+// Двоичная запись смены: настройки станции и всё недетерминированное, что она получила.
+//
+// Формат: заголовок "SHRC", версия (u16), настройки станции: число путей (u32), предел кольца
+// общий и по видам (5 x u64), окно горки и max_bypass (2 x u64), политика отправки
+// (min_fill f64, max_age f64, path_pressure u8), окно планирования (u64), выбор локомотива (u8);
+// затем поток записей. Запись начинается с тега (u8):
+//   0..6       - EventType, обработанное событие; для kLocoArrived следом тип локомотива (u8);
+//   kTagWagon  - вагон добавлен во входной буфер: номер (i32), тип (u8);
+//   kTagTime   - модельное время станции (f64);
+//   kTagEnd    - конец записи.
+// Вагоны, добавленные до kShiftStarted, образуют исходную ведомость смены.
+class ShiftRecorder {
+public:
+    static constexpr std::uint16_t kVersion = 2;
+    static constexpr std::uint8_t kTagWagon = 0x80;
+    static constexpr std::uint8_t kTagTime = 0x81;
+    static constexpr std::uint8_t kTagEnd = 0xFF;
+
+    ShiftRecorder(const std::string& path, const RecordedStation& station);
+    ~ShiftRecorder();
+
+    ShiftRecorder(const ShiftRecorder&) = delete;
+    ShiftRecorder& operator=(const ShiftRecorder&) = delete;
+
+    void RecordWagon(const Wagon& wagon);
+    void RecordEvent(EventType event);
+    void RecordLoco(LocoType loco_type);
+    void RecordModelTime(double seconds);
+
+    // Дописывает маркер конца и сбрасывает файл. Вызывается автоматически в деструкторе.
+    void Finish();
+
+private:
+    std::ofstream out_;
+    BinaryWriter buffer_;
+    bool finished_ = false;
+
+private:
+    void FlushIfFull_();
+};
+
+// Воспроизведение записи ShiftRecorder на полной скорости, без CheckEvent.
+class ShiftReplay {
+public:
+    static ShiftReplay Load(const std::string& path);
+
+    size_t GetNumberOfPaths() const;
+    // Станцию для воспроизведения нужно создать с этими настройками.
+    const RecordedStation& GetStation() const;
+    size_t GetEventsCount() const;
+
+    // Подаёт в станцию записанные вагоны, события, локомотивы и модельное время в исходном порядке.
+    void Run(SortingHill& sorting_hill) const;
+
+private:
+    struct Record {
+        std::uint8_t tag = 0;
+        Wagon wagon{};
+        LocoType loco_type = LocoType::kElectro16;
+        double model_time = 0.0;
+    };
+
+private:
+    RecordedStation station_;
+    size_t events_count_ = 0;
+    std::vector<Record> records_;
+};
@@ -0,0 +1,159 @@
+#include "shift_simulator.h"
+#include "sorting_hill.h"
+#include "workload_generator.h"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std::literals;
+
+ShiftSimulator::ShiftSimulator(SortingHill& sorting_hill, Dispatcher& dispatcher, WorkloadGenerator& generator,
+                               SimulationConfig config)
+    : sorting_hill_(sorting_hill),
+      dispatcher_(dispatcher),
+      generator_(generator),
+      config_(std::move(config)) {
+    if (config_.inbound_interval < 0.0 || config_.horizon < 0.0) {
+        throw std::invalid_argument("Время модели не может быть отрицательным"s);
+    }
+}
+
+double ShiftSimulator::GetClock() const {
+    return clock_;
+}
+
+SimulationReport ShiftSimulator::Run() {
+    if (!config_.inbound_wagons.empty()) {
+        Schedule_(clock_, /*inbound=*/true, EventType::kWagonArrived);
+    }
+
+    IssueCommands_();
+    while (!calendar_.empty()) {
+        const CalendarEvent event = calendar_.top();
+        calendar_.pop();
+        AdvanceClock_(event.time);
+        Complete_(event);
+        IssueCommands_();
+    }
+
+    report_.elapsed_seconds = clock_;
+    report_.departed_wagons = sorting_hill_.GetDepartedWagonsCount();
+    if (clock_ > 0.0) {
+        report_.wagons_per_hour = report_.departed_wagons * 3600.0 / clock_;
+        report_.path_utilization = sorting_hill_.GetNumberOfPaths() > 0
+            ? busy_path_seconds_ / (clock_ * sorting_hill_.GetNumberOfPaths())
+            : 0.0;
+    }
+    if (report_.departed_wagons > 0) {
+        report_.mean_dwell_seconds = wagon_seconds_ / report_.departed_wagons;
+    }
+    return report_;
+}
+
+void ShiftSimulator::Schedule_(double time, bool inbound, EventType event) {
+    calendar_.push(CalendarEvent{time, next_sequence_++, inbound, event});
+}
+
+// Выдаём команды всем свободным исполнителям, пока дежурному есть что поручить.
+void ShiftSimulator::IssueCommands_() {
+    if (config_.horizon > 0.0 && clock_ >= config_.horizon) {
+        return;
+    }
+    while (true) {
+        EventMask allowed = IdleChannels_();
+        if (!sorting_hill_.HasIncomingWagons()) {
+            allowed &= ~EventBit(EventType::kWagonArrived);
+        }
+        if (allowed == 0) {
+            return;
+        }
+        const std::optional<EventType> event = dispatcher_.NextEvent(sorting_hill_, allowed);
+        if (!event) {
+            return;
+        }
+        busy_[static_cast<size_t>(ChannelOf_(*event))] = true;
+        Schedule_(clock_ + Duration_(*event), /*inbound=*/false, *event);
+    }
+}
+
+void ShiftSimulator::Complete_(const CalendarEvent& event) {
+    if (event.inbound) {
+        sorting_hill_.AddWagon(config_.inbound_wagons[next_inbound_++]);
+        const bool past_horizon = config_.horizon > 0.0 && clock_ >= config_.horizon;
+        if (next_inbound_ < config_.inbound_wagons.size() && !past_horizon) {
+            Schedule_(clock_ + config_.inbound_interval, /*inbound=*/true, EventType::kWagonArrived);
+        }
+        return;
+    }
+
+    busy_[static_cast<size_t>(ChannelOf_(event.event))] = false;
+    // Пока команда выполнялась, состояние станции могло измениться.
+    if (event.event != EventType::kLocoArrived && !sorting_hill_.CheckEvent(event.event)) {
+        ++report_.rejected_commands;
+        return;
+    }
+
+    const size_t handled_before = sorting_hill_.GetHandledEventsCount();
+    if (event.event == EventType::kLocoArrived) {
+        sorting_hill_.HandleLocoArrived(generator_.NextLocoType());
+    } else {
+        sorting_hill_.HandleEvent(event.event);
+    }
+    report_.commands += sorting_hill_.GetHandledEventsCount() - handled_before;
+}
+
+void ShiftSimulator::AdvanceClock_(double time) {
+    const double dt = time - clock_;
+    if (dt > 0.0) {
+        busy_path_seconds_ += dt * static_cast<double>(sorting_hill_.GetBusyPathsCount());
+        if (sorting_hill_.IsInputThrottled()) {
+            report_.throttled_seconds += dt;
+        }
+
+        // На станции (в буфере, на кольце и в поездах) - поступившие минус уехавшие.
+        size_t intake = 0;
+        for (WagonType type : kWagonType) {
+            intake += sorting_hill_.GetIntakeWagons(type);
+        }
+        const size_t departed = sorting_hill_.GetDepartedWagonsCount();
+        wagon_seconds_ += dt * static_cast<double>(intake > departed ? intake - departed : 0);
+    }
+    clock_ = time;
+    sorting_hill_.SetModelTime(clock_);
+}
+
+EventMask ShiftSimulator::IdleChannels_() const {
+    EventMask mask = 0;
+    for (EventType event : {EventType::kWagonArrived, EventType::kPreparePath, EventType::kTrainPlanned,
+                            EventType::kLocoArrived, EventType::kTrainReady}) {
+        if (!busy_[static_cast<size_t>(ChannelOf_(event))]) {
+            mask |= EventBit(event);
+        }
+    }
+    return mask;
+}
+
+double ShiftSimulator::Duration_(EventType event) const {
+    const OperationDurations& d = config_.durations;
+    switch (event) {
+        case EventType::kWagonArrived: return d.hump_passage;
+        case EventType::kPreparePath:  return d.path_preparation;
+        case EventType::kTrainPlanned: return d.train_planning;
+        case EventType::kLocoArrived:  return d.loco_arrival;
+        case EventType::kTrainReady:   return d.departure;
+        default:
+            throw std::out_of_range("Команда не выполняется исполнителем"s);
+    }
+}
+
+ShiftSimulator::Channel ShiftSimulator::ChannelOf_(EventType event) {
+    switch (event) {
+        case EventType::kWagonArrived: return Channel::kHump;
+        case EventType::kPreparePath:  return Channel::kPaths;
+        case EventType::kTrainPlanned: return Channel::kPlanning;
+        case EventType::kLocoArrived:  return Channel::kDepot;
+        case EventType::kTrainReady:   return Channel::kDeparture;
+        default:
+            throw std::out_of_range("Команда не выполняется исполнителем"s);
+    }
+}
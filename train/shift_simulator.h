@@ -0,0 +1,103 @@
+#pragma once
+
+#include "common.h"
+#include "dispatcher.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+class SortingHill;
+class WorkloadGenerator;
+
+// Длительность операций в секундах модельного времени.
+struct OperationDurations {
+    double hump_passage = 45.0;      // проход вагона через горку
+    double path_preparation = 600.0; // подготовка пути
+    double train_planning = 300.0;   // формирование состава на пути
+    double loco_arrival = 1200.0;    // подача локомотива по запросу
+    double departure = 600.0;        // отправление поезда
+};
+
+struct SimulationConfig {
+    OperationDurations durations;
+    // Вагоны прибывают на станцию по одному через inbound_interval секунд.
+    std::vector<Wagon> inbound_wagons;
+    double inbound_interval = 60.0;
+    // Модельное время, после которого новые команды не выдаются и вагоны не прибывают
+    // (0 - без ограничения). Начатые команды завершаются.
+    double horizon = 0.0;
+};
+
+// Показатели прогона.
+struct SimulationReport {
+    double elapsed_seconds = 0.0;
+    size_t commands = 0;         // выполнено команд
+    size_t rejected_commands = 0; // к моменту завершения команда стала недопустимой
+    size_t departed_wagons = 0;
+    double wagons_per_hour = 0.0;
+    double path_utilization = 0.0; // средняя доля путей в работе
+    // Среднее время вагона на станции (закон Литтла: интеграл числа вагонов на станции
+    // по времени, делённый на число уехавших вагонов).
+    double mean_dwell_seconds = 0.0;
+    // Сколько времени подача вагонов стояла из-за заполненного кольцевого пути.
+    double throttled_seconds = 0.0;
+};
+
+// Дискретно-событийная модель смены. Каждая команда дежурного выполняется своим
+// исполнителем (горка, бригада путей, формирование, депо, отправление) заданное время;
+// исполнитель за раз выполняет одну команду, а её результат применяется к станции в момент
+// завершения. Календарь событий - очередь с приоритетом по времени, часы перескакивают
+// к ближайшему событию, поэтому неделя модельного времени считается за секунды.
+class ShiftSimulator {
+public:
+    ShiftSimulator(SortingHill& sorting_hill, Dispatcher& dispatcher, WorkloadGenerator& generator,
+                   SimulationConfig config);
+
+    // Прогон по начатой смене. Смену не завершает: kShiftEnded отправляет оставшиеся поезда
+    // мгновенно, поэтому в показатели не входит.
+    SimulationReport Run();
+
+    double GetClock() const;
+
+private:
+    enum class Channel { kHump, kPaths, kPlanning, kDepot, kDeparture, kCount };
+
+    struct CalendarEvent {
+        double time = 0.0;
+        std::uint64_t sequence = 0; // при равном времени - в порядке постановки
+        bool inbound = false;       // прибытие вагона, иначе завершение команды
+        EventType event = EventType::kWagonArrived;
+
+        bool operator>(const CalendarEvent& other) const {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+
+    SortingHill& sorting_hill_;
+    Dispatcher& dispatcher_;
+    WorkloadGenerator& generator_;
+    const SimulationConfig config_;
+
+    std::priority_queue<CalendarEvent, std::vector<CalendarEvent>, std::greater<CalendarEvent>> calendar_;
+    std::array<bool, static_cast<size_t>(Channel::kCount)> busy_{};
+    std::uint64_t next_sequence_ = 0;
+    size_t next_inbound_ = 0;
+    double clock_ = 0.0;
+
+    SimulationReport report_;
+    double busy_path_seconds_ = 0.0;
+    double wagon_seconds_ = 0.0;
+
+private:
+    void Schedule_(double time, bool inbound, EventType event);
+    void IssueCommands_();
+    void Complete_(const CalendarEvent& event);
+    void AdvanceClock_(double time);
+
+    EventMask IdleChannels_() const;
+    double Duration_(EventType event) const;
+    static Channel ChannelOf_(EventType event);
+};
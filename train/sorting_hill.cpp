@@ -1,9 +1,22 @@
 #include "sorting_hill.h"
 #include "random.h"
+#include "shift_recorder.h"
+#include "station_snapshot.h"
 
 #include <algorithm>
 #include <stdexcept>
 
+namespace {
+
+// Сколько вагонов станция забирает из источника за один раз.
+constexpr size_t kSourceChunk = 256;
+
+// Раз во сколько применённых операций обновляются максимумы памяти: полный обход структур
+// после каждой операции стоил бы больше самой операции.
+constexpr size_t kMemorySampleInterval = 64;
+
+} // namespace
+
 SortingHill::SortingHill(size_t number_of_paths, std::vector<std::unique_ptr<SortingHandler>> handlers)
     : handlers_(std::move(handlers)),
       number_of_paths_(number_of_paths),
@@ -18,18 +31,154 @@ size_t SortingHill::GetNumberOfWagBuffer() const {
     return wagon_buffer_.size();
 }
 
+void SortingHill::AddObserver(std::unique_ptr<SortingObserver> observer) {
+    observers_.push_back(std::move(observer));
+}
+
+void SortingHill::FlushObservers() {
+    for (const auto& observer : observers_) {
+        observer->Flush();
+    }
+}
+
+void SortingHill::SetRecorder(ShiftRecorder* recorder) {
+    recorder_ = recorder;
+}
+
 void SortingHill::AddWagon(const Wagon& wagon) {
-    wagon_buffer_.push(wagon);
+    if (recorder_ != nullptr) {
+        recorder_->RecordWagon(wagon);
+    }
+    wagon_buffer_.push_back(wagon);
+    if (locator_) {
+        locator_->OnBufferPush(wagon.number);
+    }
+    if (dwell_) {
+        dwell_->OnIntake(wagon.number, UtilizationNow_());
+    }
+
+    const int idx = WagonTypeIndex_(wagon.wagon_type);
+    if (idx >= 0) {
+        wagon_buffer_by_type_[static_cast<size_t>(idx)]++;
+        intake_by_type_[static_cast<size_t>(idx)]++;
+    }
 }
 
 void SortingHill::PopWagon() {
-    wagon_buffer_.pop();
+    const int idx = WagonTypeIndex_(wagon_buffer_.front().wagon_type);
+    if (idx >= 0) {
+        wagon_buffer_by_type_[static_cast<size_t>(idx)]--;
+    }
+    wagon_buffer_.pop_front();
+    if (locator_) {
+        locator_->OnBufferPop();
+    }
+    head_bypassed_ = 0;
+}
+
+size_t SortingHill::SelectWagon_() const {
+    const size_t window = std::min(hump_reordering_.window, wagon_buffer_.size());
+    if (window <= 1 || head_bypassed_ >= hump_reordering_.max_bypass) {
+        return 0;
+    }
+
+    std::array<bool, 4> open{};
+    for (const auto& [train_number, train_meta] : trains_) {
+        (void)train_number;
+        if (train_meta.has_loco && train_meta.capacity > 0 && train_meta.wagons < train_meta.capacity) {
+            open[static_cast<size_t>(WagonTypeIndex_(train_meta.type))] = true;
+        }
+    }
+    for (size_t i = 0; i < window; ++i) {
+        if (open[static_cast<size_t>(WagonTypeIndex_(wagon_buffer_[i].wagon_type))]) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void SortingHill::TakeWagon_(size_t index) {
+    if (index == 0) {
+        PopWagon();
+        return;
+    }
+
+    // Выбранный вагон встаёт в голову, обойдённые сдвигаются на место к хвосту.
+    if (locator_) {
+        for (size_t i = 0; i < index; ++i) {
+            locator_->OnBufferShift(wagon_buffer_[i].number);
+        }
+    }
+    const auto first = wagon_buffer_.begin();
+    std::rotate(first, first + static_cast<std::ptrdiff_t>(index), first + static_cast<std::ptrdiff_t>(index) + 1);
+
+    const size_t bypassed = head_bypassed_ + 1;
+    PopWagon();
+    head_bypassed_ = bypassed;
+    reordered_wagons_count_++;
+}
+
+void SortingHill::EnableWagonLocator(bool enabled) {
+    if (enabled == HasWagonLocator()) {
+        return;
+    }
+    if (enabled) {
+        locator_ = std::make_unique<WagonLocator>();
+        ResetLocator_();
+    }
+    for (const auto& handler : handlers_) {
+        handler->AttachWagonLocator(enabled ? locator_.get() : nullptr);
+    }
+    if (!enabled) {
+        locator_.reset();
+    }
+}
+
+bool SortingHill::HasWagonLocator() const {
+    return locator_ != nullptr;
+}
+
+std::optional<WagonLocation> SortingHill::LocateWagon(int wagon_number) const {
+    if (!locator_) {
+        return std::nullopt;
+    }
+    return locator_->Locate(wagon_number);
+}
+
+void SortingHill::ResetLocator_() {
+    if (!locator_) {
+        return;
+    }
+    locator_->Clear();
+    for (const Wagon& wagon : wagon_buffer_) {
+        locator_->OnBufferPush(wagon.number);
+    }
 }
 
 bool SortingHill::IsWagonBuffer() const {
     return !wagon_buffer_.empty();
 }
 
+void SortingHill::AttachWagonSource(WagonSource* source) {
+    wagon_source_ = source;
+}
+
+bool SortingHill::HasIncomingWagons() const {
+    return IsWagonBuffer() || (wagon_source_ != nullptr && !wagon_source_->IsExhausted());
+}
+
+void SortingHill::RefillFromSource_() {
+    if (wagon_source_ == nullptr || wagon_buffer_.size() >= kSourceChunk) {
+        return;
+    }
+
+    source_chunk_.clear();
+    wagon_source_->Pull(source_chunk_, kSourceChunk);
+    for (const Wagon& wagon : source_chunk_) {
+        AddWagon(wagon);
+    }
+}
+
 bool SortingHill::IsShiftEnding() const {
     return shift_ending_;
 }
@@ -54,10 +203,146 @@ size_t SortingHill::GetSentTrainsCount() const {
     return sent_trains_count_;
 }
 
+size_t SortingHill::GetHandledEventsCount() const {
+    return handled_events_count_;
+}
+
+size_t SortingHill::GetDepartedWagonsCount() const {
+    return departed_wagons_count_;
+}
+
+size_t SortingHill::GetThrottledEventsCount() const {
+    return throttled_events_count_;
+}
+
+size_t SortingHill::GetRingEntriesCount() const {
+    return ring_entries_count_;
+}
+
+size_t SortingHill::GetReorderedWagonsCount() const {
+    return reordered_wagons_count_;
+}
+
+size_t SortingHill::GetEarlyDeparturesCount() const {
+    return early_departures_count_;
+}
+
+void SortingHill::SetRingLimits(const RingLimits& limits) {
+    ring_limits_ = limits;
+}
+
+const RingLimits& SortingHill::GetRingLimits() const {
+    return ring_limits_;
+}
+
+void SortingHill::SetHumpReordering(const HumpReordering& reordering) {
+    hump_reordering_ = reordering;
+}
+
+const HumpReordering& SortingHill::GetHumpReordering() const {
+    return hump_reordering_;
+}
+
+void SortingHill::SetDispatchPolicy(const DispatchPolicy& policy) {
+    using namespace std::literals;
+    if (policy.min_fill < 0.0 || policy.min_fill > 1.0) {
+        throw std::invalid_argument("Доля заполнения для досрочной отправки - от 0 до 1"s);
+    }
+    if (policy.max_age < 0.0) {
+        throw std::invalid_argument("Возраст поезда для досрочной отправки не может быть отрицательным"s);
+    }
+    dispatch_policy_ = policy;
+}
+
+const DispatchPolicy& SortingHill::GetDispatchPolicy() const {
+    return dispatch_policy_;
+}
+
+bool SortingHill::IsEarlyDispatchDue(const std::string& train_number) const {
+    const auto it = trains_.find(train_number);
+    return it != trains_.end() && IsEarlyDispatchDue_(it->second);
+}
+
+bool SortingHill::IsEarlyDispatchDue_(const TrainMeta& meta) const {
+    if (!meta.has_loco || meta.capacity <= 0 || meta.wagons <= 0) {
+        return false;
+    }
+    const DispatchPolicy& policy = dispatch_policy_;
+    if (policy.min_fill > 0.0 && meta.wagons >= policy.min_fill * meta.capacity) {
+        return true;
+    }
+    if (policy.max_age > 0.0 && UtilizationNow_() - meta.planned_at >= policy.max_age) {
+        return true;
+    }
+    return policy.path_pressure && IsUnderPathPressure_();
+}
+
+bool SortingHill::IsUnderPathPressure_() const {
+    for (const PathMeta& path : paths_) {
+        if (!path.occupied) {
+            return false;
+        }
+    }
+
+    std::array<bool, 4> collected{};
+    for (const auto& [train_number, train_meta] : trains_) {
+        (void)train_number;
+        collected[static_cast<size_t>(WagonTypeIndex_(train_meta.type))] = true;
+    }
+    for (size_t i = 0; i < ring_by_type_.size(); ++i) {
+        if (ring_by_type_[i] > 0 && !collected[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SortingHill::IsInputThrottled() const {
+    return !wagon_buffer_.empty() && GoesToFullRing_(wagon_buffer_[SelectWagon_()]);
+}
+
+bool SortingHill::IsThrottleReleaseDue() const {
+    if (!IsInputThrottled()) {
+        return false;
+    }
+    // Есть свободный или подготовленный путь - нужен новый поезд, а не отправка.
+    for (const auto& path : paths_) {
+        if (!path.occupied) {
+            return false;
+        }
+    }
+    const WagonType blocked = wagon_buffer_[SelectWagon_()].wagon_type;
+    for (const auto& [train_number, train_meta] : trains_) {
+        (void)train_number;
+        if (train_meta.type == blocked && !train_meta.has_loco) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SortingHill::GoesToFullRing_(const Wagon& wagon) const {
+    for (const auto& [train_number, train_meta] : trains_) {
+        (void)train_number;
+        if (train_meta.type == wagon.wagon_type && train_meta.has_loco && train_meta.capacity > 0
+            && train_meta.wagons < train_meta.capacity) {
+            return false;
+        }
+    }
+
+    const auto idx = static_cast<size_t>(WagonTypeIndex_(wagon.wagon_type));
+    return (ring_limits_.total > 0 && ring_total_ >= ring_limits_.total)
+        || (ring_limits_.per_kind[idx] > 0 && ring_by_type_[idx] >= ring_limits_.per_kind[idx]);
+}
+
 size_t SortingHill::GetRingTotal() const {
     return ring_total_;
 }
 
+size_t SortingHill::GetBusyPathsCount() const {
+    return busy_paths_count_;
+}
+
 size_t SortingHill::GetRingMax() const {
     return ring_max_;
 }
@@ -113,17 +398,289 @@ size_t SortingHill::GetBufferWagonsLeft(WagonType type) const {
     if (idx < 0) {
         return 0;
     }
+    return wagon_buffer_by_type_[static_cast<size_t>(idx)];
+}
 
-    const size_t i = static_cast<size_t>(idx);
-    return wagon_buffer_initial_by_type_[i] - wagon_buffer_processed_by_type_[i];
+size_t SortingHill::GetIntakeWagons(WagonType type) const {
+    const int idx = WagonTypeIndex_(type);
+    if (idx < 0) {
+        return 0;
+    }
+    return intake_by_type_[static_cast<size_t>(idx)];
+}
+
+std::array<size_t, 4> SortingHill::GetUpcomingWagons(size_t window) const {
+    std::array<size_t, 4> upcoming{};
+    const size_t count = std::min(window, wagon_buffer_.size());
+    for (size_t i = 0; i < count; ++i) {
+        ++upcoming[static_cast<size_t>(WagonTypeIndex_(wagon_buffer_[i].wagon_type))];
+    }
+    return upcoming;
 }
 
 size_t SortingHill::GetMissedWagons(WagonType type) const {
     return GetRingWagons(type) + GetBufferWagonsLeft(type);
 }
 
+HillMetrics SortingHill::GetMetrics() const {
+    HillMetrics metrics;
+    metrics.prepared_paths = prepared_paths_count_;
+    metrics.planned_trains = planned_trains_count_;
+    metrics.arrived_locos = arrived_locos_count_;
+    metrics.processed_wagons = processed_wagons_count_;
+    metrics.sent_trains = sent_trains_count_;
+    metrics.handled_events = handled_events_count_;
+    metrics.departed_wagons = departed_wagons_count_;
+    metrics.throttled_events = throttled_events_count_;
+    metrics.ring_entries = ring_entries_count_;
+    metrics.reordered_wagons = reordered_wagons_count_;
+    metrics.early_departures = early_departures_count_;
+    metrics.open_trains = trains_.size();
+    metrics.busy_paths = GetBusyPathsCount();
+    metrics.buffer_wagons = wagon_buffer_.size();
+    metrics.ring_total = ring_total_;
+    metrics.ring_max = ring_max_;
+    for (WagonType type : kWagonType) {
+        metrics.missed_wagons[static_cast<size_t>(WagonTypeIndex_(type))] = GetMissedWagons(type);
+    }
+    return metrics;
+}
+
+void SortingHill::SaveState(BinaryWriter& out) const {
+    out.WriteU64(wagon_buffer_.size());
+    for (const Wagon& wagon : wagon_buffer_) {
+        snapshot::WriteWagon(out, wagon);
+    }
+
+    for (const PathMeta& path : paths_) {
+        out.WriteU8(path.prepared ? 1 : 0);
+        out.WriteU8(path.occupied ? 1 : 0);
+        out.WriteString(path.train_number);
+    }
+
+    // Порядок обхода unordered_map не воспроизводим: пишем поезда по номеру.
+    std::vector<const std::pair<const std::string, TrainMeta>*> trains;
+    trains.reserve(trains_.size());
+    for (const auto& train : trains_) {
+        trains.push_back(&train);
+    }
+    std::sort(trains.begin(), trains.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->first < rhs->first;
+    });
+    out.WriteU32(static_cast<std::uint32_t>(trains.size()));
+    for (const auto* train : trains) {
+        out.WriteString(train->first);
+        out.WriteU8(train->second.has_loco ? 1 : 0);
+        out.WriteI32(train->second.capacity);
+        out.WriteI32(train->second.wagons);
+        out.WriteI32(train->second.path_id);
+    }
+
+    out.WriteU8(shift_ending_ ? 1 : 0);
+    out.WriteU64(ring_total_);
+    out.WriteU64(ring_max_);
+    for (size_t i = 0; i < ring_by_type_.size(); ++i) {
+        out.WriteU64(ring_by_type_[i]);
+        out.WriteU64(intake_by_type_[i]);
+    }
+
+    out.WriteU64(prepared_paths_count_);
+    out.WriteU64(planned_trains_count_);
+    out.WriteU64(arrived_locos_count_);
+    out.WriteU64(processed_wagons_count_);
+    out.WriteU64(sent_trains_count_);
+    out.WriteU64(handled_events_count_);
+    out.WriteU64(departed_wagons_count_);
+    out.WriteU64(throttled_events_count_);
+    out.WriteU64(ring_entries_count_);
+    out.WriteU64(reordered_wagons_count_);
+    out.WriteU64(early_departures_count_);
+    out.WriteU64(head_bypassed_);
+
+    // Состояние каждого обработчика - отдельный блок с длиной.
+    out.WriteU32(static_cast<std::uint32_t>(handlers_.size()));
+    BinaryWriter handler_state;
+    for (const auto& handler : handlers_) {
+        handler_state.Clear();
+        handler->SaveState(handler_state);
+        out.WriteString(handler_state.Data());
+    }
+}
+
+void SortingHill::PrepareState(BinaryReader& in) {
+    auto state = std::make_unique<LoadedState>();
+    state->wagon_buffer.resize(in.CheckCount(in.ReadU64(), 5));
+    for (Wagon& wagon : state->wagon_buffer) {
+        wagon = snapshot::ReadWagon(in);
+        ++state->wagon_buffer_by_type[static_cast<size_t>(WagonTypeIndex_(wagon.wagon_type))];
+    }
+
+    state->paths.resize(number_of_paths_);
+    for (PathMeta& path : state->paths) {
+        path.prepared = in.ReadU8() != 0;
+        path.occupied = in.ReadU8() != 0;
+        path.train_number = in.ReadString();
+    }
+
+    const size_t trains_count = in.CheckCount(in.ReadU32(), 17);
+    for (size_t i = 0; i < trains_count; ++i) {
+        std::string train_number = in.ReadString();
+        TrainMeta meta;
+        meta.type = TrainNumberToWagonType_(train_number);
+        meta.has_loco = in.ReadU8() != 0;
+        meta.capacity = in.ReadI32();
+        meta.wagons = in.ReadI32();
+        meta.path_id = in.ReadI32();
+        if (meta.path_id < -1 || meta.path_id >= static_cast<int>(number_of_paths_)) {
+            throw std::runtime_error("Поезд в снимке стоит на несуществующем пути");
+        }
+        if (!state->trains.emplace(std::move(train_number), meta).second) {
+            throw std::runtime_error("Повторный номер поезда в снимке");
+        }
+    }
+    for (const PathMeta& path : state->paths) {
+        if (!path.train_number.empty() && state->trains.count(path.train_number) == 0) {
+            throw std::runtime_error("Путь в снимке занят несуществующим поездом");
+        }
+    }
+
+    state->shift_ending = in.ReadU8() != 0;
+    state->ring_total = static_cast<size_t>(in.ReadU64());
+    state->ring_max = static_cast<size_t>(in.ReadU64());
+    for (size_t i = 0; i < state->ring_by_type.size(); ++i) {
+        state->ring_by_type[i] = static_cast<size_t>(in.ReadU64());
+        state->intake_by_type[i] = static_cast<size_t>(in.ReadU64());
+    }
+    for (size_t& counter : state->counters) {
+        counter = static_cast<size_t>(in.ReadU64());
+    }
+
+    if (in.ReadU32() != handlers_.size()) {
+        throw std::runtime_error("Снимок снят со станции с другим набором обработчиков");
+    }
+    for (const auto& handler : handlers_) {
+        const std::string handler_state = in.ReadString();
+        BinaryReader handler_in(handler_state);
+        handler->PrepareState(handler_in);
+        if (!handler_in.AtEnd()) {
+            throw std::runtime_error("Лишние данные в состоянии обработчика");
+        }
+    }
+
+    loaded_state_ = std::move(state);
+}
+
+void SortingHill::CommitState() {
+    if (!loaded_state_) {
+        throw std::logic_error("CommitState без PrepareState");
+    }
+    LoadedState& state = *loaded_state_;
+    wagon_buffer_ = std::move(state.wagon_buffer);
+    wagon_buffer_by_type_ = state.wagon_buffer_by_type;
+    paths_ = std::move(state.paths);
+    busy_paths_count_ = static_cast<size_t>(std::count_if(paths_.begin(), paths_.end(), [](const PathMeta& path) {
+        return path.prepared || path.occupied;
+    }));
+    trains_ = std::move(state.trains);
+    shift_ending_ = state.shift_ending;
+    ring_total_ = state.ring_total;
+    ring_max_ = state.ring_max;
+    ring_by_type_ = state.ring_by_type;
+    intake_by_type_ = state.intake_by_type;
+    prepared_paths_count_ = state.counters[0];
+    planned_trains_count_ = state.counters[1];
+    arrived_locos_count_ = state.counters[2];
+    processed_wagons_count_ = state.counters[3];
+    sent_trains_count_ = state.counters[4];
+    handled_events_count_ = state.counters[5];
+    departed_wagons_count_ = state.counters[6];
+    throttled_events_count_ = state.counters[7];
+    ring_entries_count_ = state.counters[8];
+    reordered_wagons_count_ = state.counters[9];
+    early_departures_count_ = state.counters[10];
+    head_bypassed_ = state.counters[11];
+    loaded_state_.reset();
+
+    // Загрузка и возраст поездов считаются с момента восстановления.
+    utilization_.Reset(number_of_paths_, UtilizationNow_(), model_time_.has_value());
+    for (auto& [train_number, train_meta] : trains_) {
+        (void)train_number;
+        train_meta.planned_at = UtilizationNow_();
+    }
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        UpdatePathState_(static_cast<int>(i));
+    }
+    ResetDwell_();
+
+    // Кольцо и поезда обработчики отметят в индексе при применении своего состояния.
+    ResetLocator_();
+    for (const auto& handler : handlers_) {
+        handler->CommitState();
+    }
+}
+
+void SortingHill::LoadState(BinaryReader& in) {
+    PrepareState(in);
+    CommitState();
+}
+
+std::vector<MemoryEntry> SortingHill::GetMemoryReport() const {
+    std::vector<MemoryEntry> report;
+    CollectMemory_(report);
+    for (size_t i = 0; i < report.size(); ++i) {
+        const size_t peak = i < memory_peaks_.size() ? memory_peaks_[i].peak_bytes : 0;
+        report[i].peak_bytes = std::max(peak, report[i].bytes);
+    }
+    return report;
+}
+
+void SortingHill::CollectMemory_(std::vector<MemoryEntry>& out) const {
+    out.clear();
+    out.push_back({"Входной буфер", wagon_buffer_.size(), memory::DequeBytes<Wagon>(wagon_buffer_.size())});
+    out.push_back({"Порция источника", source_chunk_.size(), memory::VectorBytes(source_chunk_)});
+    out.push_back({"Пакет горки", wagon_batch_.size(),
+                   memory::VectorBytes(wagon_batch_) + memory::VectorBytes(batch_infos_)});
+
+    MemoryEntry paths{"Пути станции", paths_.size(), memory::VectorBytes(paths_)};
+    for (const PathMeta& path : paths_) {
+        paths.bytes += memory::StringHeapBytes(path.train_number);
+    }
+    out.push_back(paths);
+
+    MemoryEntry trains{"Поезда станции", trains_.size(), memory::HashMapBytes(trains_)};
+    for (const auto& [train_number, train_meta] : trains_) {
+        (void)train_meta;
+        trains.bytes += memory::StringHeapBytes(train_number);
+    }
+    out.push_back(trains);
+    if (locator_) {
+        locator_->CollectMemory(out);
+    }
+    if (dwell_) {
+        dwell_->CollectMemory(out);
+    }
+
+    for (const auto& handler : handlers_) {
+        handler->CollectMemory(out);
+    }
+
+    // Итог - отдельной записью, чтобы максимум считался по сумме, а не по частям.
+    MemoryEntry total{"Всего"};
+    for (const MemoryEntry& entry : out) {
+        total.bytes += entry.bytes;
+    }
+    out.push_back(total);
+}
+
+void SortingHill::UpdateMemoryPeaks_() {
+    ops_since_memory_sample_ = 0;
+    CollectMemory_(memory_scratch_);
+    memory::UpdatePeaks(memory_scratch_, memory_peaks_);
+}
+
 void SortingHill::ResetShiftState_() {
     paths_.assign(number_of_paths_, PathMeta{});
+    busy_paths_count_ = 0;
     trains_.clear();
 
     shift_ending_ = false;
@@ -132,29 +689,111 @@ void SortingHill::ResetShiftState_() {
     ring_max_ = 0;
     ring_by_type_.fill(0);
 
-    wagon_buffer_initial_by_type_.fill(0);
-    wagon_buffer_processed_by_type_.fill(0);
-
-    {
-        auto copy = wagon_buffer_;
-        while (!copy.empty()) {
-            const Wagon& w = copy.front();
-            const int idx = WagonTypeIndex_(w.wagon_type);
-            if (idx >= 0) {
-                wagon_buffer_initial_by_type_[static_cast<size_t>(idx)]++;
-            }
-            copy.pop();
-        }
-    }
+    // Вагоны, лежащие в буфере на начало смены, считаются поступившими в эту смену.
+    intake_by_type_ = wagon_buffer_by_type_;
 
     prepared_paths_count_ = 0;
     planned_trains_count_ = 0;
     arrived_locos_count_ = 0;
     processed_wagons_count_ = 0;
     sent_trains_count_ = 0;
+    handled_events_count_ = 0;
+    departed_wagons_count_ = 0;
+    throttled_events_count_ = 0;
+    ring_entries_count_ = 0;
+    reordered_wagons_count_ = 0;
+    early_departures_count_ = 0;
+    head_bypassed_ = 0;
+
+    memory_peaks_.clear();
+    ResetLocator_();
+    utilization_.Reset(number_of_paths_, UtilizationNow_(), model_time_.has_value());
+    ResetDwell_();
 }
 
-void SortingHill::ApplyOperationInfo_(const OperationInfo& op) {
+void SortingHill::SetModelTime(double seconds) {
+    if (recorder_ != nullptr) {
+        recorder_->RecordModelTime(seconds);
+    }
+    const bool switched = !model_time_;
+    model_time_ = seconds;
+    // Команды и секунды не складываются: загрузка считается заново с первого модельного момента.
+    if (switched) {
+        utilization_.Restart(seconds, /*model_time=*/true);
+        if (dwell_) {
+            dwell_->Restart(seconds, /*model_time=*/true);
+        }
+        for (auto& [train_number, train_meta] : trains_) {
+            (void)train_number;
+            train_meta.planned_at = seconds;
+        }
+    }
+}
+
+UtilizationReport SortingHill::GetUtilization() const {
+    return utilization_.GetReport(UtilizationNow_());
+}
+
+void SortingHill::EnableDwellTracking(bool enabled) {
+    if (enabled == HasDwellTracking()) {
+        return;
+    }
+    if (enabled) {
+        dwell_ = std::make_unique<DwellTracker>();
+        ResetDwell_();
+    } else {
+        dwell_.reset();
+    }
+}
+
+bool SortingHill::HasDwellTracking() const {
+    return dwell_ != nullptr;
+}
+
+const DwellReport& SortingHill::GetDwell() const {
+    static const DwellReport kEmpty;
+    return dwell_ ? dwell_->GetReport() : kEmpty;
+}
+
+void SortingHill::ResetDwell_() {
+    if (!dwell_) {
+        return;
+    }
+    const double now = UtilizationNow_();
+    dwell_->Reset(model_time_.has_value());
+    for (const Wagon& wagon : wagon_buffer_) {
+        dwell_->OnIntake(wagon.number, now);
+    }
+    for (size_t i = 0; i < ring_by_type_.size(); ++i) {
+        for (size_t j = 0; j < ring_by_type_[i]; ++j) {
+            dwell_->OnRingPush(static_cast<WagonType>(i), now);
+        }
+    }
+}
+
+double SortingHill::UtilizationNow_() const {
+    return model_time_ ? *model_time_ : static_cast<double>(handled_events_count_);
+}
+
+void SortingHill::UpdatePathState_(int path_id) {
+    if (path_id < 0 || static_cast<size_t>(path_id) >= paths_.size()) {
+        return;
+    }
+
+    const PathMeta& path = paths_[static_cast<size_t>(path_id)];
+    PathState state = path.prepared ? PathState::kPreparedIdle : PathState::kFree;
+    if (path.occupied) {
+        state = PathState::kWaitingLoco;
+        const auto it = trains_.find(path.train_number);
+        if (it != trains_.end() && it->second.has_loco) {
+            const TrainMeta& meta = it->second;
+            state = meta.capacity > 0 && meta.wagons >= meta.capacity ? PathState::kFullWaiting : PathState::kFilling;
+        }
+    }
+    utilization_.SetPathState(static_cast<size_t>(path_id), state, UtilizationNow_());
+}
+
+void SortingHill::ApplyOperationInfo_(const OperationInfo& op, bool command_end) {
     const size_t prev_ring_total = ring_total_;
 
     if (op.ring_total) {
@@ -196,6 +835,22 @@ void SortingHill::ApplyOperationInfo_(const OperationInfo& op) {
             break;
         }
     }
+
+    // Остановка подачи проверяется раз на команду: внутри пакета вагонов она не наступает,
+    // пакет обрывается перед вагоном, которому не хватает места на кольце.
+    if (command_end && !shift_ending_ && IsInputThrottled()) {
+        throttled_events_count_++;
+    }
+    if (++ops_since_memory_sample_ >= kMemorySampleInterval) {
+        UpdateMemoryPeaks_();
+    }
+
+    if (!observers_.empty()) {
+        const HillMetrics metrics = GetMetrics();
+        for (const auto& observer : observers_) {
+            observer->OnOperation(op, metrics);
+        }
+    }
 }
 
 void SortingHill::ApplyRingDrainForTrain_(size_t prev_ring_total, const OperationInfo& op) {
@@ -212,6 +867,9 @@ void SortingHill::ApplyRingDrainForTrain_(size_t prev_ring_total, const Operatio
     if (idx < 0) {
         return;
     }
+    if (dwell_) {
+        dwell_->OnRingDrain(wagon_type, drained, UtilizationNow_());
+    }
 
     size_t& cur = ring_by_type_[static_cast<size_t>(idx)];
     if (drained >= cur) {
@@ -233,9 +891,13 @@ void SortingHill::ApplyPreparePath_(const OperationInfo& op) {
 
     PathMeta& path = paths_[static_cast<size_t>(pid)];
     if (!path.prepared) {
+        if (!path.occupied) {
+            busy_paths_count_++;
+        }
         path.prepared = true;
         prepared_paths_count_++;
     }
+    UpdatePathState_(pid);
 }
 
 void SortingHill::ApplyTrainPlanned_(const OperationInfo& op) {
@@ -251,15 +913,25 @@ void SortingHill::ApplyTrainPlanned_(const OperationInfo& op) {
     const std::string& train_number = *op.train_number;
 
     PathMeta& path = paths_[static_cast<size_t>(pid)];
+    if (!path.prepared && !path.occupied) {
+        busy_paths_count_++;
+    }
     path.occupied = true;
     path.train_number = train_number;
 
     TrainMeta meta;
+    meta.type = TrainNumberToWagonType_(train_number);
     meta.path_id = pid;
+    meta.planned_at = UtilizationNow_();
 
     if (op.loco_attached && op.loco_capacity) {
         meta.has_loco = true;
         meta.capacity = *op.loco_capacity;
+        // Локомотив нового поезда - из резерва.
+        if (op.loco_type) {
+            meta.loco_type = op.loco_type;
+            utilization_.OnLocoAttached(*op.loco_type, /*from_reserve=*/true, UtilizationNow_());
+        }
     }
     if (op.train_wagons) {
         meta.wagons = static_cast<int>(*op.train_wagons);
@@ -267,9 +939,13 @@ void SortingHill::ApplyTrainPlanned_(const OperationInfo& op) {
 
     trains_[train_number] = meta;
     planned_trains_count_++;
+    UpdatePathState_(pid);
 }
 
 void SortingHill::ApplyLocoArrived_(const OperationInfo& op) {
+    if (op.loco_reserved && op.loco_type) {
+        utilization_.OnLocoReserved(*op.loco_type, UtilizationNow_());
+    }
     if (!op.loco_attached || !op.train_number) {
         return;
     }
@@ -288,6 +964,11 @@ void SortingHill::ApplyLocoArrived_(const OperationInfo& op) {
     if (op.path_id) {
         meta.path_id = *op.path_id;
     }
+    if (op.loco_type) {
+        meta.loco_type = op.loco_type;
+        utilization_.OnLocoAttached(*op.loco_type, /*from_reserve=*/false, UtilizationNow_());
+    }
+    UpdatePathState_(meta.path_id);
 }
 
 void SortingHill::ApplyWagonArrived_(const OperationInfo& op) {
@@ -301,7 +982,11 @@ void SortingHill::ApplyWagonArrived_(const OperationInfo& op) {
             if (idx >= 0) {
                 ring_by_type_[static_cast<size_t>(idx)]++;
             }
+            if (dwell_) {
+                dwell_->OnRingPush(op.wagon->wagon_type, UtilizationNow_());
+            }
         }
+        ring_entries_count_++;
 
         if (!op.ring_total) {
             ring_total_++;
@@ -318,6 +1003,7 @@ void SortingHill::ApplyWagonArrived_(const OperationInfo& op) {
         if (op.train_capacity) {
             meta.capacity = *op.train_capacity;
         }
+        UpdatePathState_(meta.path_id);
     }
 }
 
@@ -325,12 +1011,22 @@ void SortingHill::ApplyTrainReady_(const OperationInfo& op) {
     if (!op.train_sent) {
         return;
     }
+    if (op.early_dispatch) {
+        early_departures_count_++;
+    }
+    if (dwell_) {
+        dwell_->OnDeparted(op.departed_wagons, UtilizationNow_());
+    }
 
     if (op.train_number) {
         const std::string& train_number = *op.train_number;
         auto it = trains_.find(train_number);
         if (it != trains_.end()) {
             const int pid = it->second.path_id;
+            if (it->second.loco_type) {
+                utilization_.OnTrainDeparted(*it->second.loco_type, op.train_wagons.value_or(0),
+                                             op.train_capacity.value_or(it->second.capacity), UtilizationNow_());
+            }
             trains_.erase(it);
             FreePath_(pid);
         } else if (op.path_id) {
@@ -338,12 +1034,14 @@ void SortingHill::ApplyTrainReady_(const OperationInfo& op) {
         }
 
         sent_trains_count_++;
+        departed_wagons_count_ += op.train_wagons.value_or(0);
         return;
     }
 
     if (op.path_id) {
         FreePath_(*op.path_id);
         sent_trains_count_++;
+        departed_wagons_count_ += op.train_wagons.value_or(0);
     }
 }
 
@@ -352,12 +1050,18 @@ void SortingHill::FreePath_(int path_id) {
         return;
     }
 
+    const PathMeta& path = paths_[static_cast<size_t>(path_id)];
+    if (path.prepared || path.occupied) {
+        busy_paths_count_--;
+    }
+
     PathMeta cleared;
     cleared.prepared = false;
     cleared.occupied = false;
     cleared.train_number.clear();
 
     paths_[static_cast<size_t>(path_id)] = cleared;
+    UpdatePathState_(path_id);
 }
 
 bool SortingHill::CheckEvent(EventType event) const {
@@ -399,20 +1103,39 @@ bool SortingHill::CheckEvent(EventType event) const {
                 }
             }
 
-            // 2) Частичная отправка - только когда входных вагонов больше не будет
-            if (IsWagonBuffer() || ring_total_ > 0) {
+            // 2) Досрочная отправка неполного поезда по политике станции
+            for (const auto& [train_number, train_meta] : trains_) {
+                (void)train_number;
+                if (IsEarlyDispatchDue_(train_meta)) {
+                    return true;
+                }
+            }
+
+            // 3) Частичная отправка - только когда входных вагонов больше не будет
+            //    или подача стоит, а путь под новый поезд иначе не освободить
+            //    (тогда - любой поезд с локомотивом).
+            const bool release = IsThrottleReleaseDue();
+            if (!release && (HasIncomingWagons() || ring_total_ > 0)) {
                 return false;
             }
 
             for (const auto& [train_number, train_meta] : trains_) {
                 (void)train_number;
-                if (train_meta.has_loco && train_meta.wagons > 0) {
+                if (train_meta.has_loco && (train_meta.wagons > 0 || release)) {
                     return true;
                 }
             }
             return false;
         }
 
+        case EventType::kWagonArrived: {
+            if (wagon_buffer_.empty()) {
+                // Буфер пополняется из источника в начале команды.
+                return wagon_source_ != nullptr && wagon_source_->HasReadyWagons();
+            }
+            return !IsInputThrottled();
+        }
+
         default: {
             return true;
         }
@@ -420,15 +1143,32 @@ bool SortingHill::CheckEvent(EventType event) const {
 }
 
 void SortingHill::HandleEvent(EventType event) {
+    if (event == EventType::kLocoArrived) {
+        HandleLocoArrived(RandomGen::GetRandomElem<LocoType>(kLocoType));
+        return;
+    }
+
     OperationInfo operation_info;
     bool should_apply = false;
 
+    RefillFromSource_();
+    if (recorder_ != nullptr) {
+        recorder_->RecordEvent(event);
+    }
+
     switch (event) {
         case EventType::kShiftStarted: {
             ResetShiftState_();
             for (const auto& handler : handlers_) {
                 handler->StartShift(*this);
             }
+            UpdateMemoryPeaks_();
+            if (!observers_.empty()) {
+                const HillMetrics metrics = GetMetrics();
+                for (const auto& observer : observers_) {
+                    observer->OnShiftStarted(metrics);
+                }
+            }
             return;
         }
 
@@ -454,44 +1194,35 @@ void SortingHill::HandleEvent(EventType event) {
 
             shift_ending_ = false;
 
+            UpdateMemoryPeaks_();
             for (const auto& handler : handlers_) {
                 handler->EndShift(*this);
             }
+            if (!observers_.empty()) {
+                HillMetrics metrics = GetMetrics();
+                metrics.memory = GetMemoryReport();
+                metrics.utilization = GetUtilization();
+                metrics.dwell = GetDwell();
+                for (const auto& observer : observers_) {
+                    observer->OnShiftEnded(metrics);
+                }
+            }
             return;
         }
 
         case EventType::kWagonArrived: {
-            if (!IsWagonBuffer()) {
+            if (!IsWagonBuffer() || IsInputThrottled()) {
                 break;
             }
 
-            const Wagon wagon = wagon_buffer_.front();
+            const size_t index = SelectWagon_();
+            const Wagon wagon = wagon_buffer_[index];
             for (const auto& handler : handlers_) {
                 handler->HandleWagon(*this, wagon, operation_info);
             }
 
             processed_wagons_count_++;
-            {
-                const int idx = WagonTypeIndex_(wagon.wagon_type);
-                if (idx >= 0) {
-                    wagon_buffer_processed_by_type_[static_cast<size_t>(idx)]++;
-                }
-            }
-
-            PopWagon();
-            should_apply = true;
-            break;
-        }
-
-        case EventType::kLocoArrived: {
-            const auto loco_type = RandomGen::GetRandomElem<LocoType>(kLocoType);
-            const Locomotive locomotive{loco_type};
-
-            for (const auto& handler : handlers_) {
-                handler->HandleLocomotive(*this, locomotive, operation_info);
-            }
-
-            arrived_locos_count_++;
+            TakeWagon_(index);
             should_apply = true;
             break;
         }
@@ -526,7 +1257,58 @@ void SortingHill::HandleEvent(EventType event) {
         }
     }
 
+    // Пустой проход горки (вагонов нет) командой не считается.
     if (should_apply) {
+        handled_events_count_++;
+        operation_info.dispatcher_command = true;
         ApplyOperationInfo_(operation_info);
     }
 }
+
+size_t SortingHill::HandleWagonBatch(size_t max_count) {
+    RefillFromSource_();
+    if (!IsWagonBuffer() || IsInputThrottled()) {
+        return 0;
+    }
+
+    const size_t count = std::min(max_count, wagon_buffer_.size());
+    wagon_batch_.assign(wagon_buffer_.begin(), wagon_buffer_.begin() + static_cast<std::ptrdiff_t>(count));
+    batch_infos_.clear();
+    for (const auto& handler : handlers_) {
+        handler->HandleWagonBatch(*this, wagon_batch_, batch_infos_);
+        if (batch_infos_.empty()) {
+            return 0;
+        }
+    }
+
+    batch_infos_.front().dispatcher_command = true;
+    for (size_t i = 0; i < batch_infos_.size(); ++i) {
+        if (recorder_ != nullptr) {
+            recorder_->RecordEvent(EventType::kWagonArrived);
+        }
+        processed_wagons_count_++;
+        PopWagon();
+        handled_events_count_++;
+        ApplyOperationInfo_(batch_infos_[i], /*command_end=*/i + 1 == batch_infos_.size());
+    }
+    return batch_infos_.size();
+}
+
+void SortingHill::HandleLocoArrived(LocoType loco_type) {
+    RefillFromSource_();
+    if (recorder_ != nullptr) {
+        recorder_->RecordLoco(loco_type);
+    }
+
+    handled_events_count_++;
+    OperationInfo operation_info;
+    const Locomotive locomotive{loco_type};
+
+    for (const auto& handler : handlers_) {
+        handler->HandleLocomotive(*this, locomotive, operation_info);
+    }
+
+    arrived_locos_count_++;
+    operation_info.dispatcher_command = true;
+    ApplyOperationInfo_(operation_info);
+}
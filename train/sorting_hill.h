@@ -1,28 +1,80 @@
 #pragma once
 
+#include "dwell_tracker.h"
 #include "handler_interface.h"
+#include "observer_interface.h"
+#include "utilization_tracker.h"
+#include "wagon_locator.h"
+#include "wagon_source.h"
 #include "enums.h"
 #include "common.h"
 
 #include <array>
+#include <deque>
 #include <memory>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class ShiftRecorder;
+
 class SortingHill {
 public:
     explicit SortingHill(size_t number_of_paths,
                          std::vector<std::unique_ptr<SortingHandler>> handlers);
 
+    // Наблюдатели получают каждую применённую операцию после обработчиков.
+    void AddObserver(std::unique_ptr<SortingObserver> observer);
+    // Ждёт наблюдателей в своих потоках: после этого их вывод не смешается с выводом вызывающего.
+    void FlushObservers();
+
     void AddWagon(const Wagon& wagon);
     bool IsWagonBuffer() const;
+
+    // Источник, из которого входной буфер пополняется по ходу смены (не владеющий указатель).
+    // Пока источник не исчерпан, станция считает, что входящие вагоны ещё будут.
+    void AttachWagonSource(WagonSource* source);
+    // Входящие вагоны ещё будут: буфер не пуст или источник не исчерпан.
+    bool HasIncomingWagons() const;
     size_t GetNumberOfPaths() const;
     size_t GetNumberOfWagBuffer() const;
 
+    // Вместимость кольцевого пути. Пока следующий вагон некуда поставить (нет поезда его вида
+    // с местом, а кольцо заполнено), подача стоит: CheckEvent(kWagonArrived) == false.
+    // Чтобы станция не встала, при остановленной подаче разрешена отправка неполных поездов -
+    // но только когда новый поезд для вагона ставить некуда (IsThrottleReleaseDue).
+    // Обработчики получают ограничения в StartShift.
+    void SetRingLimits(const RingLimits& limits);
+    const RingLimits& GetRingLimits() const;
+    bool IsInputThrottled() const;
+    // Подача стоит, все пути заняты поездами и ни один поезд вида следующего вагона не ждёт
+    // локомотив: путь освобождает только отправка неполного (лучше непустого) поезда.
+    bool IsThrottleReleaseDue() const;
+
+    // Окно перестановки на горке (см. HumpReordering). Действует на kWagonArrived;
+    // HandleWagonBatch берёт вагоны строго по очереди.
+    void SetHumpReordering(const HumpReordering& reordering);
+    const HumpReordering& GetHumpReordering() const;
+
+    // Политика досрочной отправки неполных поездов (см. DispatchPolicy): по ней
+    // CheckEvent(kTrainReady) разрешает отправку, а оператор выбирает поезд.
+    void SetDispatchPolicy(const DispatchPolicy& policy);
+    const DispatchPolicy& GetDispatchPolicy() const;
+    // Поезд с этим номером можно отправить досрочно по политике станции.
+    bool IsEarlyDispatchDue(const std::string& train_number) const;
+
     bool CheckEvent(EventType event) const;
     void HandleEvent(EventType event);
+    // Прибытие локомотива заданного типа (HandleEvent(kLocoArrived) выбирает тип случайно).
+    void HandleLocoArrived(LocoType loco_type);
+    // Не более max_count вагонов подряд через горку одним вызовом: для станции и наблюдателей
+    // то же, что столько же команд kWagonArrived, но обработчик раскладывает пакет целиком
+    // (оператор - параллельно по видам поездов). Останавливается на вагоне, который пришлось
+    // бы ставить на заполненное кольцо. Возвращает число пропущенных вагонов.
+    size_t HandleWagonBatch(size_t max_count);
+
+    // Запись всех входных данных смены для воспроизведения (не владеющий указатель).
+    void SetRecorder(ShiftRecorder* recorder);
 
     bool IsShiftEnding() const;
 
@@ -32,15 +84,63 @@ public:
     size_t GetArrivedLocosCount() const;
     size_t GetProcessedWagonsCount() const;
     size_t GetSentTrainsCount() const;
+    size_t GetHandledEventsCount() const;
+    size_t GetDepartedWagonsCount() const;
+    size_t GetThrottledEventsCount() const;
+    size_t GetRingEntriesCount() const;
+    size_t GetReorderedWagonsCount() const;
+    size_t GetEarlyDeparturesCount() const;
 
     size_t GetRingTotal() const;
     size_t GetRingMax() const;
+    // Путей в работе: подготовленных или занятых поездом.
+    size_t GetBusyPathsCount() const;
 
     // Пропущенные вагоны - те, что не попали ни в один отправленный поезд к окончанию смены.
     // Пропущенные вагоны = оставшиеся во входном буфере + оставшиеся на кольцевом пути.
     size_t GetMissedWagons(WagonType type) const;
     size_t GetRingWagons(WagonType type) const;
     size_t GetBufferWagonsLeft(WagonType type) const;
+    // Поступило вагонов за смену: лежавшие в буфере на начало смены + пришедшие по ходу.
+    size_t GetIntakeWagons(WagonType type) const;
+    // Состав первых window вагонов входного буфера (порядок Г, Л, О, П); стоимость O(window).
+    std::array<size_t, 4> GetUpcomingWagons(size_t window) const;
+
+    HillMetrics GetMetrics() const;
+
+    // Модельное время в секундах (ShiftSimulator). Пока не задано, загрузка путей и локомотивов
+    // считается в командах дежурного.
+    void SetModelTime(double seconds);
+    // Загрузка путей и локомотивов с начала смены (или восстановления снимка) до текущего момента.
+    UtilizationReport GetUtilization() const;
+    // Время вагонов на станции и на кольцевом пути с начала смены (или восстановления снимка).
+    // По умолчанию не ведётся (отметка на каждый вагон); включать до начала смены или
+    // восстановления снимка. Без учёта отчёт пуст.
+    void EnableDwellTracking(bool enabled);
+    bool HasDwellTracking() const;
+    const DwellReport& GetDwell() const;
+
+    // Индекс "номер вагона -> место" (буфер, кольцо, поезд, уехал в поезде) с поиском за O(1).
+    // По умолчанию не ведётся; включать до начала смены или восстановления снимка.
+    // Уехавшие вагоны помнятся до конца смены и в снимок не входят.
+    void EnableWagonLocator(bool enabled);
+    bool HasWagonLocator() const;
+    // nullopt - индекс не ведётся или вагона на станции нет.
+    std::optional<WagonLocation> LocateWagon(int wagon_number) const;
+
+    // Память станции и обработчиков по структурам: текущая и максимум за смену.
+    // Последняя запись - "Всего". Максимумы замеряются раз в несколько десятков операций,
+    // в начале и в конце смены; текущие значения входят в отчёт всегда.
+    std::vector<MemoryEntry> GetMemoryReport() const;
+
+    // Сохранение/восстановление состояния станции и обработчиков (см. station_snapshot.h).
+    // Источник вагонов, наблюдатели и запись смены в снимок не входят.
+    // Восстановление в два шага: PrepareState читает и проверяет секцию станции вместе с блоками
+    // обработчиков, ничего не меняя; CommitState применяет прочитанное. LoadState - оба шага.
+    void SaveState(BinaryWriter& out) const;
+    void PrepareState(BinaryReader& in);
+    void CommitState();
+    void LoadState(BinaryReader& in);
 
 private:
     struct PathMeta {
@@ -50,41 +150,96 @@ private:
     };
 
     struct TrainMeta {
+        WagonType type = WagonType::kFreight;
         bool has_loco = false;
         int capacity = 0;
         int wagons = 0;
         int path_id = -1;
+        std::optional<LocoType> loco_type; // неизвестен у поездов из снимка
+        double planned_at = 0.0;           // время учёта загрузки; у поездов из снимка - восстановления
+    };
+
+    // Секция станции из снимка, прочитанная PrepareState.
+    struct LoadedState {
+        std::deque<Wagon> wagon_buffer;
+        std::array<size_t, 4> wagon_buffer_by_type{};
+        std::vector<PathMeta> paths;
+        std::unordered_map<std::string, TrainMeta> trains;
+        bool shift_ending = false;
+        size_t ring_total = 0;
+        size_t ring_max = 0;
+        std::array<size_t, 4> ring_by_type{};
+        std::array<size_t, 4> intake_by_type{};
+        std::array<size_t, 12> counters{};
     };
 
 private:
     std::vector<std::unique_ptr<SortingHandler>> handlers_;
+    std::vector<std::unique_ptr<SortingObserver>> observers_;
     const size_t number_of_paths_;
 
-    std::queue<Wagon> wagon_buffer_;
+    std::deque<Wagon> wagon_buffer_;
+    WagonSource* wagon_source_ = nullptr;
+    std::vector<Wagon> source_chunk_;
+    std::vector<Wagon> wagon_batch_;
+    std::vector<OperationInfo> batch_infos_;
+    std::unique_ptr<WagonLocator> locator_;
+    ShiftRecorder* recorder_ = nullptr;
 
     std::vector<PathMeta> paths_;
+    size_t busy_paths_count_ = 0; // подготовлено или занято поездом: метрики без обхода путей
     std::unordered_map<std::string, TrainMeta> trains_;
 
     bool shift_ending_ = false;
+    RingLimits ring_limits_;
+    HumpReordering hump_reordering_;
+    DispatchPolicy dispatch_policy_;
+    size_t head_bypassed_ = 0; // сколько раз подряд обошли голову буфера
 
     size_t ring_total_ = 0;
     size_t ring_max_ = 0;
 
     std::array<size_t, 4> ring_by_type_{};
-    std::array<size_t, 4> wagon_buffer_initial_by_type_{};
-    std::array<size_t, 4> wagon_buffer_processed_by_type_{};
+    std::array<size_t, 4> wagon_buffer_by_type_{};
+    std::array<size_t, 4> intake_by_type_{};
 
     size_t prepared_paths_count_ = 0;
     size_t planned_trains_count_ = 0;
     size_t arrived_locos_count_ = 0;
     size_t processed_wagons_count_ = 0;
     size_t sent_trains_count_ = 0;
+    size_t handled_events_count_ = 0;
+    size_t departed_wagons_count_ = 0;
+    size_t throttled_events_count_ = 0;
+    size_t ring_entries_count_ = 0;
+    size_t reordered_wagons_count_ = 0;
+    size_t early_departures_count_ = 0;
+
+    UtilizationTracker utilization_;
+    std::unique_ptr<DwellTracker> dwell_;
+    std::optional<double> model_time_;
+
+    std::unique_ptr<LoadedState> loaded_state_;
+
+    std::vector<MemoryEntry> memory_peaks_;
+    std::vector<MemoryEntry> memory_scratch_;
+    size_t ops_since_memory_sample_ = 0;
 
 private:
     void PopWagon();
+    // Какой вагон буфера пойдёт через горку следующим (индекс от головы).
+    size_t SelectWagon_() const;
+    // Снять вагон index из буфера; пропущенные им вагоны сохраняют порядок.
+    void TakeWagon_(size_t index);
+    // Индекс заново: пуст, кроме вагонов входного буфера.
+    void ResetLocator_();
+    // Отметки времени заново: вагоны буфера поступили сейчас, кольцо - по ring_by_type_.
+    void ResetDwell_();
+    void RefillFromSource_();
 
     void ResetShiftState_();
-    void ApplyOperationInfo_(const OperationInfo& operation_info);
+    // command_end - последняя операция команды (в пакете вагонов - последний вагон).
+    void ApplyOperationInfo_(const OperationInfo& operation_info, bool command_end = true);
 
     void ApplyRingDrainForTrain_(size_t prev_ring_total, const OperationInfo& operation_info);
     void ApplyPreparePath_(const OperationInfo& operation_info);
@@ -94,6 +249,15 @@ private:
     void ApplyTrainReady_(const OperationInfo& operation_info);
 
     void FreePath_(int path_id);
+    // Текущее время учёта загрузки: секунды модели или число выполненных команд.
+    double UtilizationNow_() const;
+    void UpdatePathState_(int path_id);
+    void CollectMemory_(std::vector<MemoryEntry>& out) const;
+    void UpdateMemoryPeaks_();
+    bool GoesToFullRing_(const Wagon& wagon) const;
+    bool IsEarlyDispatchDue_(const TrainMeta& meta) const;
+    // Путей для новых поездов нет, а на кольце есть вагоны вида, который не собирает ни один поезд.
+    bool IsUnderPathPressure_() const;
 
     static int WagonTypeIndex_(WagonType type);
     static WagonType TrainNumberToWagonType_(const std::string& train_number);
@@ -4,10 +4,16 @@
 
 using namespace std::literals;
 
+SortingOperatorImpl::SortingOperatorImpl(size_t planning_window, LocoAssignment loco_assignment) {
+    runtime_.SetPlanningWindow(planning_window);
+    runtime_.SetLocoAssignment(loco_assignment);
+}
+
 SortingOperatorImpl::~SortingOperatorImpl() {
 }
 
 void SortingOperatorImpl::StartShift(const SortingHill& sorting_hill) {
+    runtime_.SetRingLimits(sorting_hill.GetRingLimits());
     runtime_.StartShift(sorting_hill.GetNumberOfPaths());
 }
 
@@ -19,18 +25,50 @@ void SortingOperatorImpl::PreparePath(SortingHill&, OperationInfo& operation_inf
     runtime_.PreparePath(&operation_info);
 }
 
-void SortingOperatorImpl::AllocatePathForTrain(SortingHill&, OperationInfo& operation_info) {
-    runtime_.AllocateTrain(&operation_info);
+void SortingOperatorImpl::AllocatePathForTrain(SortingHill& sorting_hill, OperationInfo& operation_info) {
+    runtime_.AllocateTrain(sorting_hill, &operation_info);
 }
 
-void SortingOperatorImpl::HandleLocomotive(SortingHill&, const Locomotive& locomotive, OperationInfo& operation_info) {
-    runtime_.HandleLocomotive(locomotive, &operation_info);
+void SortingOperatorImpl::HandleLocomotive(SortingHill& sorting_hill, const Locomotive& locomotive, OperationInfo& operation_info) {
+    runtime_.HandleLocomotive(sorting_hill, locomotive, &operation_info);
 }
 
 void SortingOperatorImpl::HandleWagon(SortingHill&, const Wagon& wagon, OperationInfo& operation_info) {
     runtime_.HandleWagon(wagon, &operation_info);
 }
 
+void SortingOperatorImpl::HandleWagonBatch(SortingHill&, const std::vector<Wagon>& wagons,
+                                           std::vector<OperationInfo>& operation_infos) {
+    runtime_.HandleWagonBatch(wagons, &operation_infos);
+}
+
+void SortingOperatorImpl::SetLanePool(std::shared_ptr<LanePool> pool) {
+    runtime_.SetLanePool(std::move(pool));
+}
+
 void SortingOperatorImpl::SendTrain(SortingHill& sorting_hill, OperationInfo& operation_info) {
     runtime_.SendTrain(sorting_hill, /*force=*/sorting_hill.IsShiftEnding(), &operation_info);
 }
+
+void SortingOperatorImpl::SaveState(BinaryWriter& out) const {
+    runtime_.SaveState(out);
+}
+
+void SortingOperatorImpl::PrepareState(BinaryReader& in) {
+    loaded_state_ = runtime_.ReadState(in);
+}
+
+void SortingOperatorImpl::CommitState() {
+    if (loaded_state_) {
+        runtime_.ApplyState(std::move(*loaded_state_));
+        loaded_state_.reset();
+    }
+}
+
+void SortingOperatorImpl::AttachWagonLocator(WagonLocator* locator) {
+    runtime_.SetWagonLocator(locator);
+}
+
+void SortingOperatorImpl::CollectMemory(std::vector<MemoryEntry>& out) const {
+    runtime_.CollectMemory(out);
+}
@@ -3,8 +3,14 @@
 #include "handler_interface.h"
 #include "station_runtime.h"
 
+#include <optional>
+
 class SortingOperatorImpl : public SortingHandler {
 public:
+    // planning_window - окно входного буфера для выбора вида нового поезда (0 - без учёта),
+    // loco_assignment - правило выбора локомотива для поезда.
+    explicit SortingOperatorImpl(size_t planning_window = 0,
+                                 LocoAssignment loco_assignment = LocoAssignment::kFifo);
     ~SortingOperatorImpl() override;
 
     void StartShift(const SortingHill& sorting_hill) override;
@@ -13,8 +19,20 @@ public:
     void AllocatePathForTrain(SortingHill& sorting_hill, OperationInfo& operation_info) override;
     void HandleLocomotive(SortingHill& sorting_hill, const Locomotive& locomotive, OperationInfo& operation_info) override;
     void HandleWagon(SortingHill& sorting_hill, const Wagon& wagon, OperationInfo& operation_info) override;
+    void HandleWagonBatch(SortingHill& sorting_hill, const std::vector<Wagon>& wagons,
+                          std::vector<OperationInfo>& operation_infos) override;
     void SendTrain(SortingHill& sorting_hill, OperationInfo& operation_info) override;
 
+    // Параллельная раскладка пакетов вагонов по видам поездов (см. StationRuntime::HandleWagonBatch).
+    void SetLanePool(std::shared_ptr<LanePool> pool);
+
+    void SaveState(BinaryWriter& out) const override;
+    void PrepareState(BinaryReader& in) override;
+    void CommitState() override;
+    void CollectMemory(std::vector<MemoryEntry>& out) const override;
+    void AttachWagonLocator(WagonLocator* locator) override;
+
 private:
     StationRuntime runtime_;
+    std::optional<StationRuntime::LoadedState> loaded_state_;
 };
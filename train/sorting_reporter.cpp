@@ -1,35 +1,43 @@
 #include "sorting_reporter.h"
 #include "sorting_hill.h"
 
-#include <iostream>
+#include <array>
+#include <iomanip>
+#include <string>
 
 using namespace std::literals;
 
+namespace {
+
+size_t Utf8Length(const std::string& s) {
+    size_t length = 0;
+    for (unsigned char c : s) {
+        if ((c & 0xC0) != 0x80) {
+            ++length;
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+SortingReporterImpl::SortingReporterImpl(LogSink& log)
+    : log_(log) {
+}
+
 SortingReporterImpl::~SortingReporterImpl() {
 }
 
 void SortingReporterImpl::StartShift(const SortingHill& sorting_hill) {
-    std::cout << "Начало рабочей смены"s << std::endl;
-    std::cout << "Очередь вагонов: "s << sorting_hill.GetNumberOfWagBuffer() << std::endl;
+    PrintShiftStart_(sorting_hill.GetMetrics());
 }
 
 void SortingReporterImpl::EndShift(const SortingHill& sorting_hill) {
-    std::cout << "Рабочая смена окончена"s << std::endl;
-    std::cout << std::endl;
-    std::cout << "===== ОТЧЁТ О СМЕНЕ ====="s << std::endl;
-    std::cout << "Подготовлено путей:                    "s << sorting_hill.GetPreparedPathsCount() << std::endl;
-    std::cout << "Запланировано поездов:                 "s << sorting_hill.GetPlannedTrainsCount() << std::endl;
-    std::cout << "Прибыло локомотивов:                   "s << sorting_hill.GetArrivedLocosCount() << std::endl;
-    std::cout << "Обработано вагонов (с повторами):      "s << sorting_hill.GetProcessedWagonsCount() << std::endl;
-    std::cout << "Отправлено поездов:                    "s << sorting_hill.GetSentTrainsCount() << std::endl;
-    std::cout << "Осталось вагонов в буфере:             "s
-              << (sorting_hill.GetNumberOfWagBuffer() + sorting_hill.GetRingTotal()) << std::endl;
-    std::cout << "Макс. заполнение кольцевого пути:      "s << sorting_hill.GetRingMax() << std::endl;
-    std::cout << "Пропущено вагонов (Г):                 "s << sorting_hill.GetMissedWagons(WagonType::kFreight) << std::endl;
-    std::cout << "Пропущено вагонов (Л):                 "s << sorting_hill.GetMissedWagons(WagonType::kPass) << std::endl;
-    std::cout << "Пропущено вагонов (О):                 "s << sorting_hill.GetMissedWagons(WagonType::kDanger) << std::endl;
-    std::cout << "Пропущено вагонов (П):                 "s << sorting_hill.GetMissedWagons(WagonType::kEmpty) << std::endl;
-    std::cout << "=========================="s << std::endl;
+    HillMetrics metrics = sorting_hill.GetMetrics();
+    metrics.memory = sorting_hill.GetMemoryReport();
+    metrics.utilization = sorting_hill.GetUtilization();
+    metrics.dwell = sorting_hill.GetDwell();
+    PrintReport_(metrics);
 }
 
 // Репортёр не влияет на работу станции: он лишь печатает отчёт в конце смены.
@@ -48,3 +56,170 @@ void SortingReporterImpl::HandleWagon(SortingHill&, const Wagon&, OperationInfo&
 
 void SortingReporterImpl::SendTrain(SortingHill&, OperationInfo&) {
 }
+
+void SortingReporterImpl::OnShiftStarted(const HillMetrics& metrics) {
+    PrintShiftStart_(metrics);
+}
+
+void SortingReporterImpl::OnOperation(const OperationInfo& operation_info, const HillMetrics&) {
+    // Как в синхронном режиме: строка на команду, без отправок в конце смены и вагонов пакета.
+    if (operation_info.dispatcher_command) {
+        log_.Log() << "Команда дежурного: "s << operation_info.event_type;
+    }
+}
+
+void SortingReporterImpl::OnShiftEnded(const HillMetrics& metrics) {
+    PrintReport_(metrics);
+}
+
+void SortingReporterImpl::PrintShiftStart_(const HillMetrics& metrics) {
+    log_.Log() << "Начало рабочей смены"s;
+    log_.Log() << "Очередь вагонов: "s << metrics.buffer_wagons;
+}
+
+void SortingReporterImpl::PrintMemory_(const std::vector<MemoryEntry>& memory) {
+    log_.Log() << "--- Память: элементов, КиБ сейчас / макс. за смену ---"s;
+    for (const MemoryEntry& entry : memory) {
+        // Выравнивание по символам, а не байтам UTF-8
+        std::string name = entry.name;
+        for (size_t width = Utf8Length(name); width < 24; ++width) {
+            name += ' ';
+        }
+        log_.Log() << name << std::setw(10) << entry.elements
+                   << std::setw(12) << std::fixed << std::setprecision(1) << entry.bytes / 1024.0
+                   << " /"s << std::setw(10) << entry.peak_bytes / 1024.0;
+    }
+}
+
+// Доли времени смены: путь - по состояниям, локомотивы - среднее число в резерве и в поездах.
+void SortingReporterImpl::PrintUtilization_(const UtilizationReport& utilization) {
+    static const std::array<const char*, 4> kLocoNames = {"ЭВЛ-16", "ЭВЛ-32", "ДЛ-24", "ТДЛ-64"};
+
+    if (utilization.elapsed <= 0.0) {
+        return;
+    }
+    const double elapsed = utilization.elapsed;
+    if (utilization.model_time) {
+        log_.Log() << "--- Загрузка за "s << std::fixed << std::setprecision(1) << elapsed / 3600.0
+                   << " ч модели, доли времени ---"s;
+    } else {
+        log_.Log() << "--- Загрузка за "s << static_cast<size_t>(elapsed) << " команд, доли времени ---"s;
+    }
+
+    log_.Log() << "Путь   свободен  подготов.  ждёт лок.      набор ждёт отпр."s;
+    std::array<double, kPathStateCount> total{};
+    for (size_t i = 0; i < utilization.paths.size(); ++i) {
+        auto line = log_.Log();
+        line << "#"s << std::left << std::setw(5) << i << std::right << std::fixed << std::setprecision(2);
+        for (size_t s = 0; s < kPathStateCount; ++s) {
+            line << std::setw(s == 0 ? 9 : 11) << utilization.paths[i][s] / elapsed;
+            total[s] += utilization.paths[i][s];
+        }
+    }
+    {
+        const double path_time = elapsed * static_cast<double>(utilization.paths.size());
+        auto line = log_.Log();
+        line << "Все   "s << std::fixed << std::setprecision(2);
+        for (size_t s = 0; s < kPathStateCount; ++s) {
+            line << std::setw(s == 0 ? 9 : 11) << total[s] / path_time;
+        }
+    }
+
+    log_.Log() << "Локомотив  в резерве  в поездах  отправлено  заполнение"s;
+    for (size_t k = 0; k < kLocoNames.size(); ++k) {
+        std::string name = kLocoNames[k];
+        for (size_t width = Utf8Length(name); width < 9; ++width) {
+            name += ' ';
+        }
+        const size_t departures = utilization.departures[k];
+        log_.Log() << name << std::fixed << std::setprecision(2)
+                   << std::setw(11) << utilization.loco_reserve_time[k] / elapsed
+                   << std::setw(11) << utilization.loco_attached_time[k] / elapsed
+                   << std::setw(12) << departures
+                   << std::setw(12) << (departures > 0 ? utilization.departure_fill_sum[k] / departures : 0.0);
+    }
+}
+
+// По типам вагонов: сводка и ненулевые корзины гистограмм "от-до: вагонов".
+void SortingReporterImpl::PrintDwell_(const DwellReport& dwell) {
+    static const std::array<const char*, 4> kTypeNames = {"Г", "Л", "О", "П"};
+
+    const auto print_histograms = [&](const char* title, const std::array<Log2Histogram, 4>& histograms) {
+        size_t total = 0;
+        for (const Log2Histogram& histogram : histograms) {
+            total += histogram.GetCount();
+        }
+        if (total == 0) {
+            return;
+        }
+        log_.Log() << "--- "s << title << (dwell.model_time ? ", с"s : ", команд"s) << " ---"s;
+        log_.Log() << "Тип   вагонов   среднее       p50       p90      макс"s;
+        for (size_t k = 0; k < histograms.size(); ++k) {
+            const Log2Histogram& histogram = histograms[k];
+            if (histogram.GetCount() == 0) {
+                continue;
+            }
+            log_.Log() << kTypeNames[k] << "   "s << std::setw(9) << histogram.GetCount() << std::fixed
+                       << std::setprecision(1) << std::setw(10) << histogram.GetMean() << std::setw(10)
+                       << histogram.GetPercentile(0.5) << std::setw(10) << histogram.GetPercentile(0.9)
+                       << std::setw(10) << histogram.GetMax();
+        }
+        for (size_t k = 0; k < histograms.size(); ++k) {
+            const Log2Histogram& histogram = histograms[k];
+            if (histogram.GetCount() == 0) {
+                continue;
+            }
+            auto line = log_.Log();
+            line << kTypeNames[k] << ":"s;
+            for (size_t i = 0; i < Log2Histogram::kBuckets; ++i) {
+                if (histogram.GetBucket(i) == 0) {
+                    continue;
+                }
+                line << " "s << Log2Histogram::BucketLow(i) << "-"s << Log2Histogram::BucketLow(i + 1) << ": "s
+                     << histogram.GetBucket(i);
+            }
+        }
+    };
+
+    print_histograms("Время вагона на станции (поступление - отъезд)", dwell.station);
+    print_histograms("Время вагона на кольцевом пути", dwell.ring);
+}
+
+void SortingReporterImpl::PrintReport_(const HillMetrics& metrics) {
+    log_.Log() << "Рабочая смена окончена"s;
+    log_.Log();
+    log_.Log() << "===== ОТЧЁТ О СМЕНЕ ====="s;
+    log_.Log() << "Подготовлено путей:                    "s << metrics.prepared_paths;
+    log_.Log() << "Запланировано поездов:                 "s << metrics.planned_trains;
+    log_.Log() << "Прибыло локомотивов:                   "s << metrics.arrived_locos;
+    log_.Log() << "Обработано вагонов (с повторами):      "s << metrics.processed_wagons;
+    log_.Log() << "Отправлено поездов:                    "s << metrics.sent_trains;
+    log_.Log() << "Выполнено команд:                      "s << metrics.handled_events;
+    log_.Log() << "Вывезено вагонов:                      "s << metrics.departed_wagons;
+    if (metrics.handled_events > 0) {
+        log_.Log() << "Вывезено вагонов на команду:           "s << std::fixed << std::setprecision(3)
+                   << static_cast<double>(metrics.departed_wagons) / metrics.handled_events;
+    }
+    log_.Log() << "Осталось вагонов в буфере:             "s << (metrics.buffer_wagons + metrics.ring_total);
+    log_.Log() << "Поставлено вагонов на кольцо:          "s << metrics.ring_entries;
+    log_.Log() << "Макс. заполнение кольцевого пути:      "s << metrics.ring_max;
+    if (metrics.early_departures > 0) {
+        log_.Log() << "Досрочно отправлено поездов:           "s << metrics.early_departures;
+    }
+    if (metrics.reordered_wagons > 0) {
+        log_.Log() << "Вагонов вне очереди через горку:       "s << metrics.reordered_wagons;
+    }
+    log_.Log() << "Команд при остановленной подаче:       "s << metrics.throttled_events;
+    log_.Log() << "Пропущено вагонов (Г):                 "s << metrics.missed_wagons[0];
+    log_.Log() << "Пропущено вагонов (Л):                 "s << metrics.missed_wagons[1];
+    log_.Log() << "Пропущено вагонов (О):                 "s << metrics.missed_wagons[2];
+    log_.Log() << "Пропущено вагонов (П):                 "s << metrics.missed_wagons[3];
+    if (!metrics.utilization.paths.empty()) {
+        PrintUtilization_(metrics.utilization);
+    }
+    PrintDwell_(metrics.dwell);
+    if (!metrics.memory.empty()) {
+        PrintMemory_(metrics.memory);
+    }
+    log_.Log() << "=========================="s;
+}
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "handler_interface.h"
+#include "log_sink.h"
+#include "observer_interface.h"
 
-class SortingReporterImpl : public SortingHandler {
+// Репортёр работает в одном из двух режимов:
+//  - обработчиком SortingHandler в потоке симуляции;
+//  - наблюдателем SortingObserver (например, внутри ObserverPipeline в своём потоке).
+//    В этом режиме он же печатает команды дежурного по применённым операциям.
+class SortingReporterImpl : public SortingHandler, public SortingObserver {
 public:
+    explicit SortingReporterImpl(LogSink& log);
     ~SortingReporterImpl() override;
 
     void StartShift(const SortingHill& sorting_hill) override;
@@ -13,4 +20,18 @@ public:
     void HandleLocomotive(SortingHill& sorting_hill, const Locomotive& locomotive, OperationInfo& operation_info) override;
     void HandleWagon(SortingHill& sorting_hill, const Wagon& wagon, OperationInfo& operation_info) override;
     void SendTrain(SortingHill& sorting_hill, OperationInfo& operation_info) override;
+
+    void OnShiftStarted(const HillMetrics& metrics) override;
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override;
+    void OnShiftEnded(const HillMetrics& metrics) override;
+
+private:
+    LogSink& log_;
+
+private:
+    void PrintShiftStart_(const HillMetrics& metrics);
+    void PrintReport_(const HillMetrics& metrics);
+    void PrintMemory_(const std::vector<MemoryEntry>& memory);
+    void PrintUtilization_(const UtilizationReport& utilization);
+    void PrintDwell_(const DwellReport& dwell);
 };
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Что делать производителю, если очередь заполнена.
+enum class OverflowPolicy {
+    kBlock, // ждать, пока потребитель освободит место
+    kDrop,  // отбросить элемент и увеличить счётчик потерь
+};
+
+// Ограниченная кольцевая очередь "один писатель - один читатель" без блокировок.
+// TryPush вызывается только из потока-производителя, TryPop - только из потока-потребителя.
+// Ёмкость округляется вверх до степени двойки.
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(RoundUpPow2_(capacity)),
+          mask_(capacity_ - 1),
+          slots_(capacity_) {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    bool TryPush(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ >= capacity_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ >= capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(const T& value) {
+        T copy(value);
+        return TryPush(std::move(copy));
+    }
+
+    bool TryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Приблизительный размер: точен только из потока производителя или потребителя.
+    size_t SizeApprox() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool EmptyApprox() const {
+        return SizeApprox() == 0;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+private:
+    static size_t RoundUpPow2_(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::vector<T> slots_;
+
+    // Сторона потребителя
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+
+    // Сторона производителя
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+};
@@ -1,28 +1,55 @@
 #pragma once
 
 #include "sorting_hill.h"
+#include "station_snapshot.h"
 #include "common.h"
+#include "lane_pool.h"
+#include "wagon_locator.h"
 
 #include <algorithm>
 #include <array>
 #include <deque>
 #include <iomanip>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+// Выбор локомотива для поезда.
+enum class LocoAssignment {
+    kFifo,          // первому поезду без локомотива, из резерва - прибывший раньше всех
+    kCapacityAware  // вместимость локомотива подбирается под ожидаемое заполнение поезда
+};
+
 // Бизнес-логика "сортировочного оператора".
 // Хранит состояние станции и выполняет операции из SortingHandler.
+//
+// Поезда и очереди кольцевого пути разделяются между копиями и копируются при записи,
+// поэтому копия (Fork) дешёвая: обходятся копированием пути, порядка поездов и указателей.
+// Сам объект, как и раньше, используется из одного потока.
 class StationRuntime {
 public:
+    StationRuntime() {
+        ResetRing_();
+    }
+
+    // Независимая копия для расчёта "что если": общие данные копируются при первом изменении.
+    // Индекс вагонов станции копия не ведёт.
+    StationRuntime Fork() const {
+        StationRuntime copy = *this;
+        copy.locator_ = nullptr;
+        return copy;
+    }
+
     void StartShift(size_t number_of_paths) {
         paths_.assign(number_of_paths, PathState{});
         trains_.clear();
         train_order_.clear();
-        free_locos_.clear();
-        for (auto& q : ring_) q.clear();
+        ClearReserve_();
+        ResetRing_();
         ring_total_ = 0;
         ring_max_ = 0;
         next_train_id_ = 1;
@@ -32,18 +59,25 @@ public:
 
     // Окончание смены: приводим внутренние структуры в согласованное состояние.
     void EndShift() {
+        if (locator_) {
+            // Вагоны, не уехавшие до конца смены, снимаются со станции.
+            for (const auto& q : ring_) {
+                for (const auto& w : *q) locator_->Forget(w.number);
+            }
+            for (const auto& [id, tr] : trains_) {
+                for (const auto& w : tr->wagons) locator_->Forget(w.number);
+            }
+        }
         trains_.clear();
         train_order_.clear();
-        free_locos_.clear();
+        ClearReserve_();
 
         for (auto& p : paths_) {
             p.prepared = false;
             p.train_id = -1;
         }
 
-        for (auto& q : ring_) {
-            q.clear();
-        }
+        ResetRing_();
 
         ring_total_ = 0;
         // ring_max_ - метрика смены. Сбрасывается в StartShift().
@@ -72,83 +106,78 @@ public:
         return false;
     }
 
-    bool AllocateTrain(OperationInfo* op) {
-        if (op) ResetOp_(*op, EventType::kTrainPlanned);
+    // Окно планирования: сколько ближайших вагонов входного буфера учитывать при выборе
+    // вида нового поезда. 0 - без учёта буфера (только кольцо и ротация).
+    void SetPlanningWindow(size_t window) {
+        planning_window_ = window;
+    }
 
-        int path_id = -1;
-        for (size_t i = 0; i < paths_.size(); ++i) {
-            if (paths_[i].prepared && paths_[i].train_id == -1) {
-                path_id = static_cast<int>(i);
-                break;
-            }
-        }
-        if (path_id == -1) {
-            if (op) {
-                op->success = false;
-                op->message = "Нет подготовленных свободных путей для поезда";
-            }
-            return false;
-        }
+    size_t GetPlanningWindow() const {
+        return planning_window_;
+    }
 
-        TrainKind kind = ChooseKindForNewTrain_();
-        int id = next_train_id_++;
+    // Вместимость кольцевого пути: вагон, которому нет места, не принимается (HandleWagon == false).
+    void SetRingLimits(const RingLimits& limits) {
+        ring_limits_ = limits;
+    }
 
-        TrainState tr;
-        tr.id = id;
-        tr.kind = kind;
-        tr.path_id = path_id;
-        tr.train_number = MakeTrainNumber_(id, kind);
+    const RingLimits& GetRingLimits() const {
+        return ring_limits_;
+    }
 
-        paths_[path_id].train_id = id;
+    void SetLocoAssignment(LocoAssignment policy) {
+        loco_assignment_ = policy;
+    }
 
-        trains_.emplace(id, tr);
-        train_order_.push_back(id);
+    LocoAssignment GetLocoAssignment() const {
+        return loco_assignment_;
+    }
 
-        // Если есть свободный локомотив - прицепляем сразу
-        if (!free_locos_.empty()) {
-            Locomotive loco = free_locos_.front();
-            free_locos_.pop_front();
-            AttachLocoToTrain_(id, loco, /*op=*/op);
-        }
+    // Индекс "номер вагона -> место" (не владеющий указатель, nullptr - не вести).
+    // Кольцо и поезда отмечаются здесь, входной буфер - станцией.
+    void SetWagonLocator(WagonLocator* locator) {
+        locator_ = locator;
+    }
 
-        if (op) {
-            op->success = true;
-            op->path_id = path_id;
-            op->train_number = trains_.at(id).train_number;
-            op->message = "Запланирован поезд " + trains_.at(id).train_number + " на пути #" + std::to_string(path_id);
-        }
-        return true;
+    // Пул для параллельной раскладки пакетов вагонов по видам поездов (nullptr - в своём потоке).
+    // Копии (Fork) пользуются тем же пулом.
+    void SetLanePool(std::shared_ptr<LanePool> pool) {
+        lane_pool_ = std::move(pool);
     }
 
-    bool HandleLocomotive(const Locomotive& loco, OperationInfo* op) {
-        if (op) {
-            ResetOp_(*op, EventType::kLocoArrived);
-            op->loco_type = loco.loco_type;
-        }
+    // Локомотивов в резерве, всего и по типу.
+    size_t ReservedLocos() const {
+        size_t total = 0;
+        for (const auto& bucket : reserve_) total += bucket.size();
+        return total;
+    }
 
-        int train_id = FindOldestTrainWithoutLoco_();
-        if (train_id == -1) {
-            free_locos_.push_back(loco);
-            if (op) {
-                op->success = true;
-                op->loco_reserved = true;
-                op->message = "Локомотив отправлен в резерв (нет поездов без локомотива)";
-            }
-            return true;
+    size_t ReservedLocos(LocoType type) const {
+        return reserve_[LocoIndex_(type)].size();
+    }
+
+    bool AllocateTrain(OperationInfo* op) {
+        return AllocateTrain_(std::array<size_t, 4>{}, op);
+    }
+
+    // Планирование с учётом ближайших вагонов станции.
+    bool AllocateTrain(const SortingHill& hill, OperationInfo* op) {
+        if (!UsesLookahead_()) {
+            return AllocateTrain(op);
         }
+        return AllocateTrain_(hill.GetUpcomingWagons(LookaheadWindow_()), op);
+    }
 
-        AttachLocoToTrain_(train_id, loco, op);
+    bool HandleLocomotive(const Locomotive& loco, OperationInfo* op) {
+        return HandleLocomotive_(loco, std::array<size_t, 4>{}, op);
+    }
 
-        if (op) {
-            op->success = true;
-            op->train_number = trains_.at(train_id).train_number;
-            op->loco_attached = true;
-            op->loco_capacity = trains_.at(train_id).capacity;
-            op->train_capacity = trains_.at(train_id).capacity;
-            op->train_wagons = trains_.at(train_id).wagons.size();
-            op->message = "Локомотив прицеплен к поезду " + trains_.at(train_id).train_number;
+    // Прибытие локомотива с учётом ближайших вагонов станции.
+    bool HandleLocomotive(const SortingHill& hill, const Locomotive& loco, OperationInfo* op) {
+        if (!UsesLookahead_()) {
+            return HandleLocomotive(loco, op);
         }
-        return true;
+        return HandleLocomotive_(loco, hill.GetUpcomingWagons(LookaheadWindow_()), op);
     }
 
     bool HandleWagon(const Wagon& wagon, OperationInfo* op) {
@@ -160,41 +189,112 @@ public:
         TrainKind kind = WagonKind_(wagon.wagon_type);
         int train_id = FindOldestTrainWithLocoAndSpace_(kind);
 
+        if (train_id == -1 && IsRingFull_(kind)) {
+            if (op) {
+                op->success = false;
+                op->message = "Кольцевой путь заполнен";
+            }
+            return false;
+        }
+
         if (train_id == -1) {
-            ring_[KindIndex_(kind)].push_back(wagon);
             ++ring_total_;
             ring_max_ = std::max(ring_max_, ring_total_);
+            PutWagonToRing_(wagon, MutableRing_(kind), ring_total_, ring_max_, op);
+            if (locator_) locator_->OnRingPush(wagon.number, wagon.wagon_type);
+            return true;
+        }
 
-            if (op) {
-                op->success = true;
-                op->wagon_to_ring = true;
-                op->ring_total = ring_total_;
-                op->ring_max = ring_max_;
-                op->message = "Вагон отправлен на кольцевой путь";
+        TrainState& tr = MutableTrain_(train_id);
+        PutWagonToTrain_(wagon, tr, op);
+        if (locator_) locator_->OnTrainPush(wagon.number, train_id, tr.wagons.size() - 1);
+        return true;
+    }
+
+    // Пакет вагонов с начала входного буфера. Результат тот же, что у HandleWagon для каждого
+    // вагона по очереди до первого вагона, которому нет места: возвращается число принятых,
+    // в ops (если задан) - по записи на каждый принятый вагон.
+    // Вагоны разных видов не пересекаются (свои поезда и своя очередь кольца), поэтому с пулом
+    // дорожки раскладываются параллельно. Общий предел кольца и ring_max считаются одним
+    // проходом в исходном порядке, так что результат от числа потоков не зависит.
+    size_t HandleWagonBatch(const std::vector<Wagon>& wagons, std::vector<OperationInfo>* ops) {
+        const size_t count = wagons.size();
+        for (auto& lane : lanes_) lane.clear();
+        batch_targets_.assign(count, kRingTarget);
+        for (size_t i = 0; i < count; ++i) {
+            lanes_[KindIndex_(WagonKind_(wagons[i].wagon_type))].push_back(i);
+        }
+
+        // 1) Куда пойдёт каждый вагон своего вида; состояние не меняется.
+        std::array<size_t, 4> lane_stop{};
+        RunLanes_(count, [&](size_t k) {
+            lane_stop[k] = PlanLane_(static_cast<TrainKind>(k), lanes_[k], count);
+        });
+
+        // 2) Общий предел кольца и ring_max - в порядке поступления вагонов.
+        size_t accepted = count;
+        size_t ring_total = ring_total_;
+        size_t ring_max = ring_max_;
+        batch_ring_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (i == lane_stop[KindIndex_(WagonKind_(wagons[i].wagon_type))]) {
+                accepted = i;
+                break;
             }
-            return true;
+            if (batch_targets_[i] != kRingTarget) continue;
+            if (ring_limits_.total > 0 && ring_total >= ring_limits_.total) {
+                accepted = i;
+                break;
+            }
+            ++ring_total;
+            ring_max = std::max(ring_max, ring_total);
+            batch_ring_[i] = {ring_total, ring_max};
         }
 
-        TrainState& tr = trains_.at(train_id);
-        tr.wagons.push_back(wagon);
+        // Индекс общий для дорожек - отмечаем в своём потоке, до раскладки.
+        if (locator_) IndexBatch_(wagons, accepted);
 
-        if (op) {
-            op->success = true;
-            op->wagon_to_ring = false;
-            op->train_number = tr.train_number;
-            op->train_wagons = tr.wagons.size();
-            op->train_capacity = tr.capacity;
-            op->message = "Вагон прицеплен к поезду " + tr.train_number;
+        // 3) Раскладка принятых вагонов: каждая дорожка меняет только свои поезда и очередь.
+        if (ops) {
+            ops->resize(accepted);
         }
-        return true;
+        RunLanes_(accepted, [&](size_t k) {
+            int train_id = kRingTarget;
+            TrainState* tr = nullptr;
+            for (size_t i : lanes_[k]) {
+                if (i >= accepted) break;
+                OperationInfo* op = ops ? &(*ops)[i] : nullptr;
+                if (op) {
+                    ResetOp_(*op, EventType::kWagonArrived);
+                    op->wagon = wagons[i];
+                }
+                if (batch_targets_[i] == kRingTarget) {
+                    PutWagonToRing_(wagons[i], MutableRing_(static_cast<TrainKind>(k)),
+                                    batch_ring_[i].first, batch_ring_[i].second, op);
+                    continue;
+                }
+                if (batch_targets_[i] != train_id) {
+                    train_id = batch_targets_[i];
+                    tr = &MutableTrain_(train_id);
+                }
+                PutWagonToTrain_(wagons[i], *tr, op);
+            }
+        });
+
+        ring_total_ = ring_total;
+        ring_max_ = ring_max;
+        return accepted;
     }
 
-    // Отправка: приоритет - полный поезд. Частичный - только если входящих вагонов уже не будет.
+    // Отправка: приоритет - полный поезд, затем досрочная отправка по политике станции
+    // (SortingHill::IsEarlyDispatchDue). Прочий частичный - только если входящих вагонов уже не будет
+    // или подача стоит и путь иначе не освободить (SortingHill::IsThrottleReleaseDue).
     bool SendTrain(const SortingHill& hill, bool force, OperationInfo* op) {
         if (op) ResetOp_(*op, EventType::kTrainReady);
 
-        const bool no_more_incoming = (hill.GetNumberOfWagBuffer() == 0);
-        const bool allow_partial = force || (no_more_incoming && ring_total_ == 0);
+        const bool no_more_incoming = !hill.HasIncomingWagons();
+        const bool release = hill.IsThrottleReleaseDue();
+        const bool allow_partial = force || release || (no_more_incoming && ring_total_ == 0);
 
         // 1) полный поезд
         auto full_it = FindInOrder_([&](const TrainState& tr) {
@@ -202,7 +302,7 @@ public:
         });
         if (full_it != train_order_.end()) {
             int id = *full_it;
-            SendTrainById_(id);
+            SendTrainById_(id, op);
             if (op) {
                 op->success = true;
                 op->train_sent = true;
@@ -212,16 +312,37 @@ public:
             return true;
         }
 
-        // 2) частичный/пустой
+        // 2) досрочно - неполный поезд по политике станции
+        auto early_it = FindInOrder_([&](const TrainState& tr) {
+            return tr.has_loco && !tr.wagons.empty() && hill.IsEarlyDispatchDue(tr.train_number);
+        });
+        if (early_it != train_order_.end()) {
+            int id = *early_it;
+            SendTrainById_(id, op);
+            if (op) {
+                op->success = true;
+                op->train_sent = true;
+                op->early_dispatch = true;
+                op->train_number = last_sent_train_;
+                op->message = "Досрочно отправлен поезд " + last_sent_train_;
+            }
+            return true;
+        }
+
+        // 3) частичный/пустой
         if (allow_partial) {
             auto part_it = FindInOrder_([&](const TrainState& tr) {
                 if (!tr.has_loco) return false;
                 if (force) return true;
                 return !tr.wagons.empty();
             });
+            // Путь под новый поезд освобождает и пустой поезд - если непустых нет.
+            if (part_it == train_order_.end() && release) {
+                part_it = FindInOrder_([](const TrainState& tr) { return tr.has_loco; });
+            }
             if (part_it != train_order_.end()) {
                 int id = *part_it;
-                SendTrainById_(id);
+                SendTrainById_(id, op);
                 if (op) {
                     op->success = true;
                     op->train_sent = true;
@@ -247,6 +368,183 @@ public:
         return ring_max_;
     }
 
+    // Учёт памяти по структурам. Данные, разделённые с копиями (Fork), учитываются в каждой.
+    void CollectMemory(std::vector<MemoryEntry>& out) const {
+        MemoryEntry ring{"Кольцевой путь"};
+        for (const auto& q : ring_) {
+            ring.elements += q->size();
+            ring.bytes += memory::DequeBytes<Wagon>(q->size());
+        }
+
+        MemoryEntry wagons{"Вагоны в поездах"};
+        MemoryEntry trains{"Поезда оператора"};
+        trains.elements = trains_.size();
+        trains.bytes = memory::HashMapBytes(trains_);
+        for (const auto& [id, tr] : trains_) {
+            wagons.elements += tr->wagons.size();
+            wagons.bytes += memory::VectorBytes(tr->wagons);
+            // make_shared: объект и счётчики ссылок одним блоком
+            trains.bytes += sizeof(TrainState) + 2 * sizeof(long) + memory::StringHeapBytes(tr->train_number);
+        }
+
+        MemoryEntry order{"Порядок поездов", train_order_.size(), memory::DequeBytes<int>(train_order_.size())};
+        MemoryEntry paths{"Пути оператора", paths_.size(), memory::VectorBytes(paths_)};
+
+        MemoryEntry reserve{"Резерв локомотивов"};
+        for (const auto& bucket : reserve_) {
+            reserve.elements += bucket.size();
+            reserve.bytes += memory::DequeBytes<ReservedLoco>(bucket.size());
+        }
+
+        MemoryEntry strings{"Строки оператора", 1, memory::StringHeapBytes(last_sent_train_)};
+
+        MemoryEntry batch{"Пакет вагонов", batch_targets_.size(),
+                          memory::VectorBytes(batch_targets_) + memory::VectorBytes(batch_ring_)};
+        for (const auto& lane : lanes_) batch.bytes += memory::VectorBytes(lane);
+
+        out.insert(out.end(), {ring, wagons, trains, order, paths, reserve, strings, batch});
+    }
+
+    // Снимок состояния (см. station_snapshot.h).
+    void SaveState(BinaryWriter& out) const {
+        out.WriteU32(static_cast<std::uint32_t>(paths_.size()));
+        for (const auto& p : paths_) {
+            out.WriteU8(p.prepared ? 1 : 0);
+            out.WriteI32(p.train_id);
+        }
+
+        // Поезда пишем в порядке планирования: порядок в unordered_map не воспроизводим.
+        out.WriteU32(static_cast<std::uint32_t>(train_order_.size()));
+        for (int id : train_order_) {
+            const TrainState& t = Train_(id);
+            out.WriteI32(t.id);
+            out.WriteU8(static_cast<std::uint8_t>(t.kind));
+            out.WriteString(t.train_number);
+            out.WriteI32(t.path_id);
+            out.WriteU8(t.has_loco ? 1 : 0);
+            out.WriteI32(t.capacity);
+            out.WriteU32(static_cast<std::uint32_t>(t.wagons.size()));
+            for (const auto& w : t.wagons) snapshot::WriteWagon(out, w);
+        }
+
+        for (const auto& q : ring_) {
+            out.WriteU32(static_cast<std::uint32_t>(q->size()));
+            for (const auto& w : *q) snapshot::WriteWagon(out, w);
+        }
+        out.WriteU64(ring_total_);
+        out.WriteU64(ring_max_);
+
+        // Резерв - одним списком в порядке прибытия.
+        std::vector<ReservedLoco> reserve;
+        for (const auto& bucket : reserve_) reserve.insert(reserve.end(), bucket.begin(), bucket.end());
+        std::sort(reserve.begin(), reserve.end(), [](const ReservedLoco& a, const ReservedLoco& b) {
+            return a.arrival < b.arrival;
+        });
+        out.WriteU32(static_cast<std::uint32_t>(reserve.size()));
+        for (const auto& l : reserve) out.WriteU8(static_cast<std::uint8_t>(l.loco.loco_type));
+
+        out.WriteI32(next_train_id_);
+        out.WriteI32(kind_rotation_);
+        out.WriteString(last_sent_train_);
+    }
+
+    // Восстановление в два шага: ReadState читает и проверяет снимок, не меняя станцию,
+    // ApplyState подменяет им текущее состояние.
+    struct LoadedState;
+    LoadedState ReadState(BinaryReader& in) const {
+        LoadedState state;
+        state.paths.resize(in.CheckCount(in.ReadU32(), 5));
+        for (auto& p : state.paths) {
+            p.prepared = in.ReadU8() != 0;
+            p.train_id = in.ReadI32();
+        }
+
+        const size_t trains_count = in.CheckCount(in.ReadU32(), 22);
+        for (size_t i = 0; i < trains_count; ++i) {
+            TrainState t;
+            t.id = in.ReadI32();
+            const std::uint8_t kind = in.ReadU8();
+            if (kind > static_cast<std::uint8_t>(TrainKind::kEmpty)) {
+                throw std::runtime_error("Неизвестный вид поезда в снимке");
+            }
+            t.kind = static_cast<TrainKind>(kind);
+            t.train_number = in.ReadString();
+            t.path_id = in.ReadI32();
+            if (t.path_id < -1 || t.path_id >= static_cast<int>(state.paths.size())) {
+                throw std::runtime_error("Поезд в снимке стоит на несуществующем пути");
+            }
+            t.has_loco = in.ReadU8() != 0;
+            t.capacity = in.ReadI32();
+            t.wagons.resize(in.CheckCount(in.ReadU32(), 5));
+            for (auto& w : t.wagons) w = snapshot::ReadWagon(in);
+
+            const int id = t.id;
+            if (!state.trains.emplace(id, std::make_shared<TrainState>(std::move(t))).second) {
+                throw std::runtime_error("Повторный номер поезда в снимке");
+            }
+            state.train_order.push_back(id);
+        }
+        for (const auto& p : state.paths) {
+            if (p.train_id != -1 && state.trains.count(p.train_id) == 0) {
+                throw std::runtime_error("Путь в снимке занят несуществующим поездом");
+            }
+        }
+
+        for (auto& q : state.ring) {
+            q = std::make_shared<std::deque<Wagon>>(in.CheckCount(in.ReadU32(), 5));
+            for (auto& w : *q) w = snapshot::ReadWagon(in);
+        }
+        state.ring_total = static_cast<size_t>(in.ReadU64());
+        state.ring_max = static_cast<size_t>(in.ReadU64());
+
+        state.reserve.resize(in.CheckCount(in.ReadU32(), 1));
+        for (auto& loco_type : state.reserve) loco_type = snapshot::ReadLocoType(in);
+
+        state.next_train_id = in.ReadI32();
+        state.kind_rotation = in.ReadI32();
+        state.last_sent_train = in.ReadString();
+        if (state.kind_rotation < 0) {
+            throw std::runtime_error("Повреждённая очерёдность видов поездов в снимке");
+        }
+        for (int id : state.train_order) {
+            if (id >= state.next_train_id) {
+                throw std::runtime_error("Номер поезда в снимке не меньше следующего номера");
+            }
+        }
+        return state;
+    }
+
+    void ApplyState(LoadedState&& state) {
+        paths_ = std::move(state.paths);
+        trains_ = std::move(state.trains);
+        train_order_ = std::move(state.train_order);
+        ring_ = std::move(state.ring);
+        ring_total_ = state.ring_total;
+        ring_max_ = state.ring_max;
+
+        ClearReserve_();
+        for (LocoType loco_type : state.reserve) ReserveLoco_(Locomotive{loco_type});
+
+        next_train_id_ = state.next_train_id;
+        kind_rotation_ = state.kind_rotation;
+        last_sent_train_ = std::move(state.last_sent_train);
+
+        if (locator_) {
+            for (const auto& q : ring_) {
+                for (const auto& w : *q) locator_->OnRingPush(w.number, w.wagon_type);
+            }
+            for (int id : train_order_) {
+                const TrainState& t = Train_(id);
+                locator_->OnTrainPlanned(id, t.train_number);
+                for (size_t i = 0; i < t.wagons.size(); ++i) locator_->OnTrainPush(t.wagons[i].number, id, i);
+            }
+        }
+    }
+
+    void LoadState(BinaryReader& in) {
+        ApplyState(ReadState(in));
+    }
+
 private:
     enum class TrainKind { kFreight = 0, kPass = 1, kDanger = 2, kEmpty = 3 };
 
@@ -266,28 +564,68 @@ private:
         std::vector<Wagon> wagons;
     };
 
+public:
+    struct LoadedState {
+        std::vector<PathState> paths;
+        std::unordered_map<int, std::shared_ptr<TrainState>> trains;
+        std::deque<int> train_order;
+        std::array<std::shared_ptr<std::deque<Wagon>>, 4> ring{};
+        size_t ring_total = 0;
+        size_t ring_max = 0;
+        std::vector<LocoType> reserve; // в порядке прибытия
+        int next_train_id = 1;
+        int kind_rotation = 0;
+        std::string last_sent_train;
+    };
+
 private:
     std::vector<PathState> paths_;
 
-    std::unordered_map<int, TrainState> trains_;
+    // Общие между копиями данные. Изменяются только через MutableTrain_/MutableRing_.
+    std::unordered_map<int, std::shared_ptr<TrainState>> trains_;
     std::deque<int> train_order_;
 
-    std::array<std::deque<Wagon>, 4> ring_{};
+    std::array<std::shared_ptr<std::deque<Wagon>>, 4> ring_{};
     size_t ring_total_ = 0;
     size_t ring_max_ = 0;
 
-    std::deque<Locomotive> free_locos_;
+    // Резерв локомотивов по типам; arrival - порядок прибытия для kFifo.
+    struct ReservedLoco {
+        Locomotive loco;
+        std::uint64_t arrival = 0;
+    };
+    std::array<std::deque<ReservedLoco>, 4> reserve_{};
+    std::uint64_t next_arrival_ = 0;
+    LocoAssignment loco_assignment_ = LocoAssignment::kFifo;
 
     int next_train_id_ = 1;
     int kind_rotation_ = 0;
     std::string last_sent_train_;
 
+    size_t planning_window_ = 0;
+    RingLimits ring_limits_;
+
+    // Пакетная раскладка: номера вагонов пакета по видам, назначение каждого вагона
+    // (поезд или kRingTarget) и заполнение кольца после вагонов, ушедших на кольцо.
+    std::shared_ptr<LanePool> lane_pool_;
+    WagonLocator* locator_ = nullptr;
+    std::array<std::vector<size_t>, 4> lanes_{};
+    std::vector<int> batch_targets_;
+    std::vector<std::pair<size_t, size_t>> batch_ring_;
+
 private:
     static void ResetOp_(OperationInfo& op, EventType type) {
         op = OperationInfo{};
         op.event_type = type;
     }
 
+    static constexpr int kMinLocoCapacity = 16;
+    static constexpr int kRingTarget = -1;
+    // Меньшие пакеты дешевле разложить в своём потоке, чем раздать пулу.
+    static constexpr size_t kMinParallelBatch = 256;
+    // Окно входного буфера для подбора локомотива, если окно планирования не задано.
+    static constexpr size_t kLocoLookahead = 64;
+
     static int GetLocoCapacity_(LocoType t) {
         switch (t) {
             case LocoType::kElectro16: return 16;
@@ -308,6 +646,16 @@ private:
         }
     }
 
+    static int LocoIndex_(LocoType t) {
+        switch (t) {
+            case LocoType::kElectro16: return 0;
+            case LocoType::kElectro32: return 1;
+            case LocoType::kDiesel24:  return 2;
+            case LocoType::kDiesel64:  return 3;
+            default: return 0;
+        }
+    }
+
     static int KindIndex_(TrainKind k) {
         return static_cast<int>(k);
     }
@@ -328,12 +676,91 @@ private:
         return out.str();
     }
 
-    TrainKind ChooseKindForNewTrain_() {
+    bool AllocateTrain_(const std::array<size_t, 4>& upcoming, OperationInfo* op) {
+        if (op) ResetOp_(*op, EventType::kTrainPlanned);
+
+        int path_id = -1;
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            if (paths_[i].prepared && paths_[i].train_id == -1) {
+                path_id = static_cast<int>(i);
+                break;
+            }
+        }
+        if (path_id == -1) {
+            if (op) {
+                op->success = false;
+                op->message = "Нет подготовленных свободных путей для поезда";
+            }
+            return false;
+        }
+
+        TrainKind kind = ChooseKindForNewTrain_(upcoming);
+        int id = next_train_id_++;
+
+        TrainState tr;
+        tr.id = id;
+        tr.kind = kind;
+        tr.path_id = path_id;
+        tr.train_number = MakeTrainNumber_(id, kind);
+
+        paths_[path_id].train_id = id;
+
+        if (locator_) locator_->OnTrainPlanned(id, tr.train_number);
+        trains_.emplace(id, std::make_shared<TrainState>(std::move(tr)));
+        train_order_.push_back(id);
+
+        // Если есть свободный локомотив - прицепляем сразу
+        if (auto loco = TakeReservedLoco_(ExpectedFill_(kind, upcoming))) {
+            AttachLocoToTrain_(id, *loco, /*op=*/op);
+        }
+
+        if (op) {
+            op->success = true;
+            op->path_id = path_id;
+            op->train_number = Train_(id).train_number;
+            op->message = "Запланирован поезд " + Train_(id).train_number + " на пути #" + std::to_string(path_id);
+        }
+        return true;
+    }
+
+    // Ожидаемая потребность в поезде вида k: кольцо + ближайшие вагоны минус свободные
+    // места в уже запланированных поездах этого вида (без локомотива - по меньшему локомотиву).
+    std::optional<TrainKind> ChooseKindByDemand_(const std::array<size_t, 4>& upcoming) const {
+        std::array<long long, 4> demand{};
+        for (int k = 0; k < 4; ++k) {
+            demand[k] = static_cast<long long>(ring_[k]->size() + upcoming[k]);
+        }
+        for (const auto& [id, tr] : trains_) {
+            const int capacity = tr->has_loco ? tr->capacity : kMinLocoCapacity;
+            demand[KindIndex_(tr->kind)] -= std::max(0, capacity - static_cast<int>(tr->wagons.size()));
+        }
+
+        int best_k = -1;
+        for (int k = 0; k < 4; ++k) {
+            if (demand[k] <= 0) continue;
+            if (best_k == -1 || demand[k] > demand[best_k]
+                || (demand[k] == demand[best_k] && ring_[k]->size() > ring_[best_k]->size())) {
+                best_k = k;
+            }
+        }
+        if (best_k == -1) {
+            return std::nullopt;
+        }
+        return static_cast<TrainKind>(best_k);
+    }
+
+    TrainKind ChooseKindForNewTrain_(const std::array<size_t, 4>& upcoming) {
+        if (planning_window_ > 0) {
+            if (auto kind = ChooseKindByDemand_(upcoming)) {
+                return *kind;
+            }
+        }
+
         // Если в кольце уже есть вагоны - планируем поезд под самый большой "хвост".
         size_t best_sz = 0;
         int best_k = -1;
         for (int k = 0; k < 4; ++k) {
-            size_t sz = ring_[k].size();
+            size_t sz = ring_[k]->size();
             if (sz > best_sz) {
                 best_sz = sz;
                 best_k = k;
@@ -349,10 +776,134 @@ private:
         return k;
     }
 
+    bool IsRingFull_(TrainKind kind) const {
+        const size_t k = static_cast<size_t>(KindIndex_(kind));
+        return (ring_limits_.total > 0 && ring_total_ >= ring_limits_.total)
+            || (ring_limits_.per_kind[k] > 0 && ring_[k]->size() >= ring_limits_.per_kind[k]);
+    }
+
+    bool UsesLookahead_() const {
+        return planning_window_ > 0 || loco_assignment_ == LocoAssignment::kCapacityAware;
+    }
+
+    size_t LookaheadWindow_() const {
+        return planning_window_ > 0 ? planning_window_ : kLocoLookahead;
+    }
+
+    bool HandleLocomotive_(const Locomotive& loco, const std::array<size_t, 4>& upcoming, OperationInfo* op) {
+        if (op) {
+            ResetOp_(*op, EventType::kLocoArrived);
+            op->loco_type = loco.loco_type;
+        }
+
+        int train_id = loco_assignment_ == LocoAssignment::kCapacityAware
+                           ? FindBestTrainForLoco_(GetLocoCapacity_(loco.loco_type), upcoming)
+                           : FindOldestTrainWithoutLoco_();
+        if (train_id == -1) {
+            ReserveLoco_(loco);
+
+            if (op) {
+                op->success = true;
+                op->loco_reserved = true;
+                op->message = "Локомотив отправлен в резерв (нет поездов без локомотива)";
+            }
+            return true;
+        }
+
+        AttachLocoToTrain_(train_id, loco, op);
+
+        if (op) {
+            op->success = true;
+            op->train_number = Train_(train_id).train_number;
+            op->loco_attached = true;
+            op->loco_capacity = Train_(train_id).capacity;
+            op->train_capacity = Train_(train_id).capacity;
+            op->train_wagons = Train_(train_id).wagons.size();
+            op->message = "Локомотив прицеплен к поезду " + Train_(train_id).train_number;
+        }
+        return true;
+    }
+
+
+    // Сколько вагонов вида kind ещё ждут поезда: кольцо + ближайшие минус свободные места
+    // в поездах этого вида, у которых уже есть локомотив.
+    int ExpectedFill_(TrainKind kind, const std::array<size_t, 4>& upcoming) const {
+        long long fill = static_cast<long long>(ring_[KindIndex_(kind)]->size() + upcoming[KindIndex_(kind)]);
+        for (const auto& [id, tr] : trains_) {
+            if (tr->kind != kind || !tr->has_loco) continue;
+            fill -= std::max(0, tr->capacity - static_cast<int>(tr->wagons.size()));
+        }
+        return static_cast<int>(std::max(0LL, fill));
+    }
+
+    // Поезд без локомотива, который локомотив данной вместимости заполнит лучше всего:
+    // больше вагонов увезёт, затем меньше пустых мест, затем старший.
+    int FindBestTrainForLoco_(int capacity, const std::array<size_t, 4>& upcoming) const {
+        int best_id = -1;
+        int best_carried = -1;
+        int best_waste = 0;
+        std::array<bool, 4> kind_seen{};
+        for (int id : train_order_) {
+            auto it = trains_.find(id);
+            if (it == trains_.end() || it->second->has_loco) continue;
+            // Ожидаемые вагоны вида достанутся старшему поезду этого вида.
+            const int k = KindIndex_(it->second->kind);
+            if (kind_seen[k]) continue;
+            kind_seen[k] = true;
+
+            const int fill = ExpectedFill_(it->second->kind, upcoming);
+            const int carried = std::min(capacity, fill);
+            const int waste = capacity - carried;
+            if (carried > best_carried || (carried == best_carried && waste < best_waste)) {
+                best_id = id;
+                best_carried = carried;
+                best_waste = waste;
+            }
+        }
+        return best_id;
+    }
+
+    void ReserveLoco_(const Locomotive& loco) {
+        reserve_[LocoIndex_(loco.loco_type)].push_back(ReservedLoco{loco, next_arrival_++});
+    }
+
+    void ClearReserve_() {
+        for (auto& bucket : reserve_) bucket.clear();
+        next_arrival_ = 0;
+    }
+
+    // Локомотив из резерва для нового поезда с ожидаемым заполнением fill.
+    // kFifo - прибывший раньше всех; kCapacityAware - наименьший, вмещающий fill, иначе самый большой.
+    std::optional<Locomotive> TakeReservedLoco_(int fill) {
+        int best = -1;
+        for (int i = 0; i < 4; ++i) {
+            if (reserve_[i].empty()) continue;
+            if (best == -1) {
+                best = i;
+                continue;
+            }
+            if (loco_assignment_ == LocoAssignment::kFifo) {
+                if (reserve_[i].front().arrival < reserve_[best].front().arrival) best = i;
+                continue;
+            }
+            const int cap = GetLocoCapacity_(reserve_[i].front().loco.loco_type);
+            const int best_cap = GetLocoCapacity_(reserve_[best].front().loco.loco_type);
+            const bool fits = cap >= fill;
+            const bool best_fits = best_cap >= fill;
+            if (fits != best_fits ? fits : (fits ? cap < best_cap : cap > best_cap)) best = i;
+        }
+        if (best == -1) {
+            return std::nullopt;
+        }
+        Locomotive loco = reserve_[best].front().loco;
+        reserve_[best].pop_front();
+        return loco;
+    }
+
     int FindOldestTrainWithoutLoco_() const {
         for (int id : train_order_) {
             auto it = trains_.find(id);
-            if (it != trains_.end() && !it->second.has_loco) return id;
+            if (it != trains_.end() && !it->second->has_loco) return id;
         }
         return -1;
     }
@@ -361,7 +912,7 @@ private:
         for (int id : train_order_) {
             auto it = trains_.find(id);
             if (it == trains_.end()) continue;
-            const TrainState& tr = it->second;
+            const TrainState& tr = *it->second;
             if (tr.kind != kind) continue;
             if (!tr.has_loco) continue;
             if (tr.capacity <= 0) continue;
@@ -370,14 +921,112 @@ private:
         return -1;
     }
 
+    static void PutWagonToRing_(const Wagon& wagon, std::deque<Wagon>& ring, size_t ring_total, size_t ring_max,
+                                OperationInfo* op) {
+        ring.push_back(wagon);
+        if (op) {
+            op->success = true;
+            op->wagon_to_ring = true;
+            op->ring_total = ring_total;
+            op->ring_max = ring_max;
+            op->message = "Вагон отправлен на кольцевой путь";
+        }
+    }
+
+    static void PutWagonToTrain_(const Wagon& wagon, TrainState& tr, OperationInfo* op) {
+        tr.wagons.push_back(wagon);
+        if (op) {
+            op->success = true;
+            op->wagon_to_ring = false;
+            op->train_number = tr.train_number;
+            op->train_wagons = tr.wagons.size();
+            op->train_capacity = tr.capacity;
+            op->message = "Вагон прицеплен к поезду " + tr.train_number;
+        }
+    }
+
+    template <class Task>
+    void RunLanes_(size_t batch_size, const Task& task) {
+        if (lane_pool_ && batch_size >= kMinParallelBatch) {
+            lane_pool_->Run(lanes_.size(), task);
+            return;
+        }
+        for (size_t k = 0; k < lanes_.size(); ++k) task(k);
+    }
+
+    // Назначения вагонов одного вида в пакете: старшие поезда с локомотивом и местом
+    // заполняются по очереди, остальное - на кольцо. Возвращает номер первого вагона,
+    // которому не хватило места в очереди кольца своего вида (count - хватило всем).
+    // Только чтение общего состояния: дорожки выполняются параллельно.
+    size_t PlanLane_(TrainKind kind, const std::vector<size_t>& lane, size_t count) {
+        auto order_it = train_order_.begin();
+        int train_id = kRingTarget;
+        size_t free_places = 0;
+        const auto next_train = [&] {
+            train_id = kRingTarget;
+            for (; order_it != train_order_.end(); ++order_it) {
+                auto it = trains_.find(*order_it);
+                if (it == trains_.end()) continue;
+                const TrainState& tr = *it->second;
+                if (tr.kind == kind && tr.has_loco && tr.capacity > 0
+                    && tr.wagons.size() < static_cast<size_t>(tr.capacity)) {
+                    train_id = tr.id;
+                    free_places = static_cast<size_t>(tr.capacity) - tr.wagons.size();
+                    ++order_it;
+                    return;
+                }
+            }
+        };
+        next_train();
+
+        const size_t k = static_cast<size_t>(KindIndex_(kind));
+        size_t ring_size = ring_[k]->size();
+        for (size_t i : lane) {
+            if (train_id != kRingTarget) {
+                batch_targets_[i] = train_id;
+                if (--free_places == 0) next_train();
+                continue;
+            }
+            if (ring_limits_.per_kind[k] > 0 && ring_size >= ring_limits_.per_kind[k]) return i;
+            batch_targets_[i] = kRingTarget;
+            ++ring_size;
+        }
+        return count;
+    }
+
+    // Места принятых вагонов пакета (по назначениям batch_targets_) - до их раскладки.
+    void IndexBatch_(const std::vector<Wagon>& wagons, size_t accepted) {
+        // Поезда одного вида заполняются по очереди: достаточно текущего поезда каждого вида.
+        std::array<int, 4> lane_train;
+        lane_train.fill(kRingTarget);
+        std::array<size_t, 4> lane_position{};
+        for (size_t i = 0; i < accepted; ++i) {
+            const int target = batch_targets_[i];
+            if (target == kRingTarget) {
+                locator_->OnRingPush(wagons[i].number, wagons[i].wagon_type);
+                continue;
+            }
+            const size_t k = static_cast<size_t>(KindIndex_(WagonKind_(wagons[i].wagon_type)));
+            if (lane_train[k] != target) {
+                lane_train[k] = target;
+                lane_position[k] = Train_(target).wagons.size();
+            }
+            locator_->OnTrainPush(wagons[i].number, target, lane_position[k]++);
+        }
+    }
+
     void AttachLocoToTrain_(int train_id, const Locomotive& loco, OperationInfo* op) {
-        TrainState& tr = trains_.at(train_id);
+        TrainState& tr = MutableTrain_(train_id);
         tr.has_loco = true;
         tr.capacity = GetLocoCapacity_(loco.loco_type);
 
         // Выгружаем вагоны из кольца в поезд
-        auto& q = ring_[KindIndex_(tr.kind)];
+        auto& q = MutableRing_(tr.kind);
         while (!q.empty() && tr.wagons.size() < static_cast<size_t>(tr.capacity)) {
+            if (locator_) {
+                locator_->OnRingPop(q.front().wagon_type);
+                locator_->OnTrainPush(q.front().number, train_id, tr.wagons.size());
+            }
             tr.wagons.push_back(q.front());
             q.pop_front();
             --ring_total_;
@@ -385,6 +1034,7 @@ private:
 
         if (op) {
             op->loco_attached = true;
+            op->loco_type = loco.loco_type;
             op->loco_capacity = tr.capacity;
             op->train_capacity = tr.capacity;
             op->train_wagons = tr.wagons.size();
@@ -393,12 +1043,39 @@ private:
         }
     }
 
+    const TrainState& Train_(int train_id) const {
+        return *trains_.at(train_id);
+    }
+
+    // Поезд для изменения: если он разделён с другой копией, сначала копируется.
+    TrainState& MutableTrain_(int train_id) {
+        auto& tr = trains_.at(train_id);
+        if (tr.use_count() > 1) {
+            tr = std::make_shared<TrainState>(*tr);
+        }
+        return *tr;
+    }
+
+    std::deque<Wagon>& MutableRing_(TrainKind kind) {
+        auto& q = ring_[KindIndex_(kind)];
+        if (q.use_count() > 1) {
+            q = std::make_shared<std::deque<Wagon>>(*q);
+        }
+        return *q;
+    }
+
+    void ResetRing_() {
+        for (auto& q : ring_) {
+            q = std::make_shared<std::deque<Wagon>>();
+        }
+    }
+
     template <class Pred>
     auto FindInOrder_(Pred pred) -> std::deque<int>::iterator {
         for (auto it = train_order_.begin(); it != train_order_.end(); ++it) {
             auto tr_it = trains_.find(*it);
             if (tr_it == trains_.end()) continue;
-            if (pred(tr_it->second)) return it;
+            if (pred(*tr_it->second)) return it;
         }
         return train_order_.end();
     }
@@ -411,12 +1088,25 @@ private:
         }
     }
 
-    void SendTrainById_(int train_id) {
+    void SendTrainById_(int train_id, OperationInfo* op) {
         auto it = trains_.find(train_id);
         if (it == trains_.end()) return;
 
-        last_sent_train_ = it->second.train_number;
-        FreePathForTrain_(it->second);
+        const TrainState& tr = *it->second;
+        last_sent_train_ = tr.train_number;
+        if (locator_) locator_->OnTrainDeparted(train_id, tr.wagons);
+        if (op) {
+            op->path_id = tr.path_id;
+            op->train_wagons = tr.wagons.size();
+            op->train_capacity = tr.capacity;
+            // Поезд удаляется: если он не разделён с копией, состав забирается без копирования.
+            if (it->second.use_count() == 1) {
+                op->departed_wagons = std::move(it->second->wagons);
+            } else {
+                op->departed_wagons = tr.wagons;
+            }
+        }
+        FreePathForTrain_(tr);
         trains_.erase(it);
 
         auto qit = std::find(train_order_.begin(), train_order_.end(), train_id);
@@ -0,0 +1,138 @@
+#include "station_snapshot.h"
+#include "event_scheduler.h"
+#include "random.h"
+#include "sorting_hill.h"
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+using namespace std::literals;
+
+namespace {
+
+BinaryReader OpenSnapshot(const std::string& data, size_t& number_of_paths) {
+    BinaryReader in(data);
+    char magic[sizeof(snapshot::kMagic)];
+    in.ReadBytes(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(snapshot::kMagic))) {
+        throw std::runtime_error("Данные не являются снимком станции"s);
+    }
+    if (in.ReadU16() != snapshot::kVersion) {
+        throw std::runtime_error("Неподдерживаемая версия снимка станции"s);
+    }
+    number_of_paths = in.ReadU32();
+    return in;
+}
+
+using RngState = std::array<std::uint64_t, 4>;
+
+void WriteRngState(BinaryWriter& out, const RngState* state) {
+    out.WriteU8(state ? 1 : 0);
+    if (state) {
+        for (std::uint64_t word : *state) {
+            out.WriteU64(word);
+        }
+    }
+}
+
+std::optional<RngState> ReadRngState(BinaryReader& in) {
+    if (in.ReadU8() == 0) {
+        return std::nullopt;
+    }
+    RngState state{};
+    for (std::uint64_t& word : state) {
+        word = in.ReadU64();
+    }
+    // Нулевое состояние xoshiro256** вырождено: генератор выдавал бы одни нули.
+    if (state == RngState{}) {
+        throw std::runtime_error("Повреждённое состояние генератора нагрузки в снимке"s);
+    }
+    return state;
+}
+
+} // namespace
+
+std::string SaveSnapshot(const SortingHill& sorting_hill, const SnapshotRngs& rngs) {
+    BinaryWriter out;
+    out.WriteBytes(snapshot::kMagic, sizeof(snapshot::kMagic));
+    out.WriteU16(snapshot::kVersion);
+    out.WriteU32(static_cast<std::uint32_t>(sorting_hill.GetNumberOfPaths()));
+    sorting_hill.SaveState(out);
+    out.WriteString(RandomGen::SaveState());
+    WriteRngState(out, rngs.workload ? &rngs.workload->GetRngState() : nullptr);
+    WriteRngState(out, rngs.scheduler ? &rngs.scheduler->GetRngState() : nullptr);
+    return out.Data();
+}
+
+void RestoreSnapshot(SortingHill& sorting_hill, const std::string& data, const SnapshotRngs& rngs) {
+    size_t number_of_paths = 0;
+    BinaryReader in = OpenSnapshot(data, number_of_paths);
+    if (number_of_paths != sorting_hill.GetNumberOfPaths()) {
+        throw std::runtime_error("Снимок снят со станции с другим числом путей"s);
+    }
+
+    // Сначала весь снимок читается и проверяется, затем применяется.
+    sorting_hill.PrepareState(in);
+    const std::mt19937 random_gen = RandomGen::ParseState(in.ReadString());
+    const std::optional<RngState> workload_rng = ReadRngState(in);
+    const std::optional<RngState> scheduler_rng = ReadRngState(in);
+    if (!in.AtEnd()) {
+        throw std::runtime_error("Лишние данные в конце снимка станции"s);
+    }
+
+    sorting_hill.CommitState();
+    RandomGen::SetState(random_gen);
+    if (rngs.workload && workload_rng) {
+        rngs.workload->SetRngState(*workload_rng);
+    }
+    if (rngs.scheduler && scheduler_rng) {
+        rngs.scheduler->SetRngState(*scheduler_rng);
+    }
+}
+
+size_t GetSnapshotNumberOfPaths(const std::string& data) {
+    size_t number_of_paths = 0;
+    OpenSnapshot(data, number_of_paths);
+    return number_of_paths;
+}
+
+void WriteSnapshotFile(const SortingHill& sorting_hill, const std::string& path, const SnapshotRngs& rngs) {
+    const std::string data = SaveSnapshot(sorting_hill, rngs);
+
+    // Пишем во временный файл и переименовываем: при сбое старый снимок остаётся целым.
+    const std::string tmp_path = path + ".tmp"s;
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Ошибка записи снимка станции: "s + tmp_path);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Не удалось сохранить снимок станции: "s + path);
+    }
+}
+
+std::string ReadSnapshotFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Не удалось открыть снимок станции: "s + path);
+    }
+    in.seekg(0, std::ios::end);
+    const auto size = static_cast<size_t>(in.tellg());
+    in.seekg(0, std::ios::beg);
+
+    std::string data(size, '\0');
+    in.read(data.data(), static_cast<std::streamsize>(size));
+    if (!in) {
+        throw std::runtime_error("Ошибка чтения снимка станции: "s + path);
+    }
+    return data;
+}
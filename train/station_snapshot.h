@@ -0,0 +1,73 @@
+#pragma once
+
+#include "binary_io.h"
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+class EventScheduler;
+class SortingHill;
+class WorkloadGenerator;
+
+// Двоичный снимок полного состояния станции: SortingHill, состояние обработчиков
+// (StationRuntime оператора) и генераторов случайных чисел.
+//
+// Формат: "STSN", версия (u16), число путей (u32), секция станции, число обработчиков (u32)
+// и для каждого блок состояния с длиной (u32 + байты), состояние RandomGen (строка),
+// затем FastRng генератора нагрузки и планировщика команд: признак (u8) и при нём 4 x u64.
+//
+// Восстановление транзакционное: снимок читается и проверяется целиком, станция и генераторы
+// меняются, только если в нём нет ошибок.
+namespace snapshot {
+
+inline constexpr char kMagic[4] = {'S', 'T', 'S', 'N'};
+inline constexpr std::uint16_t kVersion = 6;
+
+inline void WriteWagon(BinaryWriter& out, const Wagon& wagon) {
+    out.WriteI32(wagon.number);
+    out.WriteU8(static_cast<std::uint8_t>(wagon.wagon_type));
+}
+
+inline Wagon ReadWagon(BinaryReader& in) {
+    Wagon wagon{};
+    wagon.number = in.ReadI32();
+    const std::uint8_t type = in.ReadU8();
+    if (type >= kWagonType.size()) {
+        throw std::runtime_error("Неизвестный тип вагона в снимке");
+    }
+    wagon.wagon_type = static_cast<WagonType>(type);
+    return wagon;
+}
+
+inline LocoType ReadLocoType(BinaryReader& in) {
+    const std::uint8_t type = in.ReadU8();
+    if (type >= kLocoType.size()) {
+        throw std::runtime_error("Неизвестный тип локомотива в снимке");
+    }
+    return static_cast<LocoType>(type);
+}
+
+} // namespace snapshot
+
+// Генераторы прогона, чьё состояние входит в снимок (не владеющие указатели, nullptr - нет).
+// Состояние генератора, которого нет при восстановлении, пропускается.
+struct SnapshotRngs {
+    WorkloadGenerator* workload = nullptr;
+    EventScheduler* scheduler = nullptr;
+};
+
+// Снимок станции в памяти.
+std::string SaveSnapshot(const SortingHill& sorting_hill, const SnapshotRngs& rngs = {});
+
+// Восстановление. Станция должна быть создана с тем же числом путей и тем же набором
+// обработчиков. Источник вагонов, наблюдатели и запись смены не сохраняются.
+void RestoreSnapshot(SortingHill& sorting_hill, const std::string& data, const SnapshotRngs& rngs = {});
+
+// Число путей станции, с которой снят снимок.
+size_t GetSnapshotNumberOfPaths(const std::string& data);
+
+void WriteSnapshotFile(const SortingHill& sorting_hill, const std::string& path, const SnapshotRngs& rngs = {});
+std::string ReadSnapshotFile(const std::string& path);
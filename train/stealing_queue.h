@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Ограниченная очередь одного производителя с кражей без блокировок (сторона кражи
+// деки Чейза - Лева). TryPush вызывает только производитель; TryTake и TakeBatch - любые
+// потоки, включая владельца: элементы забираются с головы сдвигом head_ по CAS, поэтому
+// владелец и воры получают вагоны в порядке поступления.
+// Ячейки - атомики: вор, прочитавший ячейку по устаревшему head_, не выиграет CAS и
+// прочитанное отбросит, гонки данных при этом нет.
+// Ёмкость округляется вверх до степени двойки.
+template <class T>
+class StealingQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "Элементы копируются через атомарные ячейки");
+
+public:
+    explicit StealingQueue(size_t capacity)
+        : capacity_(RoundUpPow2_(capacity)),
+          mask_(capacity_ - 1),
+          slots_(new std::atomic<T>[capacity_]) {
+    }
+
+    StealingQueue(const StealingQueue&) = delete;
+    StealingQueue& operator=(const StealingQueue&) = delete;
+
+    // false - очередь заполнена.
+    bool TryPush(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+            return false;
+        }
+        slots_[tail & mask_].store(value, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryTake(T& out) {
+        return TakeBatch(&out, 1) == 1;
+    }
+
+    // Забирает с головы не более max_count элементов одним CAS. Возвращает число взятых.
+    size_t TakeBatch(T* out, size_t max_count) {
+        size_t head = head_.load(std::memory_order_acquire);
+        while (true) {
+            const size_t tail = tail_.load(std::memory_order_acquire);
+            if (head >= tail || max_count == 0) {
+                return 0;
+            }
+            const size_t count = tail - head < max_count ? tail - head : max_count;
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = slots_[(head + i) & mask_].load(std::memory_order_relaxed);
+            }
+            if (head_.compare_exchange_weak(head, head + count, std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                return count;
+            }
+        }
+    }
+
+    // Приблизительный размер (для выбора, у кого красть).
+    size_t SizeApprox() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+private:
+    static size_t RoundUpPow2_(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<std::atomic<T>[]> slots_;
+
+    // Сторона потребителей
+    alignas(64) std::atomic<size_t> head_{0};
+    // Сторона производителя
+    alignas(64) std::atomic<size_t> tail_{0};
+};
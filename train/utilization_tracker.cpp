@@ -0,0 +1,96 @@
+#include "utilization_tracker.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std::literals;
+
+void UtilizationTracker::Reset(size_t number_of_paths, double now, bool model_time) {
+    report_ = UtilizationReport{};
+    report_.model_time = model_time;
+    report_.paths.assign(number_of_paths, std::array<double, kPathStateCount>{});
+    paths_.assign(number_of_paths, PathTrack{PathState::kFree, now});
+    start_ = now;
+
+    reserved_.fill(0);
+    attached_.fill(0);
+    locos_since_.fill(now);
+}
+
+void UtilizationTracker::Restart(double now, bool model_time) {
+    std::vector<PathState> states(paths_.size());
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        states[i] = paths_[i].state;
+    }
+    const std::array<size_t, 4> reserved = reserved_;
+    const std::array<size_t, 4> attached = attached_;
+
+    Reset(states.size(), now, model_time);
+    for (size_t i = 0; i < states.size(); ++i) {
+        paths_[i].state = states[i];
+    }
+    reserved_ = reserved;
+    attached_ = attached;
+}
+
+void UtilizationTracker::SetPathState(size_t path_id, PathState state, double now) {
+    if (path_id >= paths_.size()) {
+        throw std::out_of_range("Нет пути #"s + std::to_string(path_id));
+    }
+    PathTrack& path = paths_[path_id];
+    if (path.state == state) {
+        return;
+    }
+    report_.paths[path_id][static_cast<size_t>(path.state)] += now - path.since;
+    path.state = state;
+    path.since = now;
+}
+
+void UtilizationTracker::OnLocoReserved(LocoType loco_type, double now) {
+    const auto k = static_cast<size_t>(loco_type);
+    AdvanceLocos_(k, now);
+    ++reserved_[k];
+}
+
+void UtilizationTracker::OnLocoAttached(LocoType loco_type, bool from_reserve, double now) {
+    const auto k = static_cast<size_t>(loco_type);
+    AdvanceLocos_(k, now);
+    // После восстановления со снимка резерв станции неизвестен: его локомотивы не учитываются.
+    if (from_reserve && reserved_[k] > 0) {
+        --reserved_[k];
+    }
+    ++attached_[k];
+}
+
+void UtilizationTracker::OnTrainDeparted(LocoType loco_type, size_t wagons, int capacity, double now) {
+    const auto k = static_cast<size_t>(loco_type);
+    AdvanceLocos_(k, now);
+    if (attached_[k] > 0) {
+        --attached_[k];
+    }
+    ++report_.departures[k];
+    if (capacity > 0) {
+        report_.departure_fill_sum[k] += static_cast<double>(wagons) / capacity;
+    }
+}
+
+UtilizationReport UtilizationTracker::GetReport(double now) const {
+    UtilizationReport report = report_;
+    report.elapsed = now - start_;
+    for (size_t i = 0; i < paths_.size(); ++i) {
+        report.paths[i][static_cast<size_t>(paths_[i].state)] += now - paths_[i].since;
+    }
+    for (size_t k = 0; k < reserved_.size(); ++k) {
+        const double dt = now - locos_since_[k];
+        report.loco_reserve_time[k] += dt * static_cast<double>(reserved_[k]);
+        report.loco_attached_time[k] += dt * static_cast<double>(attached_[k]);
+    }
+    return report;
+}
+
+void UtilizationTracker::AdvanceLocos_(size_t k, double now) {
+    const double dt = now - locos_since_[k];
+    report_.loco_reserve_time[k] += dt * static_cast<double>(reserved_[k]);
+    report_.loco_attached_time[k] += dt * static_cast<double>(attached_[k]);
+    locos_since_[k] = now;
+}
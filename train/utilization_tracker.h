@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Учёт загрузки путей и локомотивов: сколько времени каждый путь провёл в каждом состоянии,
+// сколько локомотивов каждого типа стояло в резерве и работало в поездах, как заполнены
+// поезда при отправлении. Ведётся станцией (SortingHill) по её переходам путей и поездов;
+// время задаёт станция (команды дежурного или секунды модели), интервалы копятся при смене
+// состояния, открытые досчитываются в отчёте.
+class UtilizationTracker {
+public:
+    // Новая смена с момента now: все пути свободны, локомотивов нет.
+    void Reset(size_t number_of_paths, double now, bool model_time);
+
+    // Счёт времени заново с момента now в другой единице: состояния путей и локомотивов
+    // сохраняются, накопленное сбрасывается.
+    void Restart(double now, bool model_time);
+
+    void SetPathState(size_t path_id, PathState state, double now);
+
+    void OnLocoReserved(LocoType loco_type, double now);
+    // Локомотив прицеплен к поезду: сразу по прибытии или из резерва.
+    void OnLocoAttached(LocoType loco_type, bool from_reserve, double now);
+    void OnTrainDeparted(LocoType loco_type, size_t wagons, int capacity, double now);
+
+    UtilizationReport GetReport(double now) const;
+
+private:
+    struct PathTrack {
+        PathState state = PathState::kFree;
+        double since = 0.0;
+    };
+
+    // Копит время резерва и работы локомотивов типа k до момента now.
+    void AdvanceLocos_(size_t k, double now);
+
+private:
+    UtilizationReport report_;
+    std::vector<PathTrack> paths_;
+    double start_ = 0.0;
+
+    std::array<size_t, 4> reserved_{};
+    std::array<size_t, 4> attached_{};
+    std::array<double, 4> locos_since_{};
+};
@@ -0,0 +1,59 @@
+#include "wagon_intake.h"
+
+#include <thread>
+
+WagonIntake::WagonIntake(size_t capacity)
+    : queue_(capacity) {
+}
+
+bool WagonIntake::TryPush(const Wagon& wagon) {
+    if (closed_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (!queue_.TryPush(wagon)) {
+        return false;
+    }
+    accepted_by_type_[static_cast<size_t>(wagon.wagon_type)].fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WagonIntake::Push(const Wagon& wagon) {
+    while (!TryPush(wagon)) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void WagonIntake::Close() {
+    closed_.store(true, std::memory_order_release);
+}
+
+bool WagonIntake::IsClosed() const {
+    return closed_.load(std::memory_order_acquire);
+}
+
+size_t WagonIntake::GetAcceptedWagons(WagonType type) const {
+    return accepted_by_type_[static_cast<size_t>(type)].load(std::memory_order_relaxed);
+}
+
+size_t WagonIntake::Pull(std::vector<Wagon>& out, size_t max_count) {
+    size_t pulled = 0;
+    Wagon wagon{};
+    while (pulled < max_count && queue_.TryPop(wagon)) {
+        out.push_back(wagon);
+        ++pulled;
+    }
+    return pulled;
+}
+
+bool WagonIntake::IsExhausted() const {
+    // Сначала флаг, потом очередь: всё, что положено до Close(), к этому моменту видно.
+    return closed_.load(std::memory_order_acquire) && queue_.Empty();
+}
+
+bool WagonIntake::HasReadyWagons() const {
+    return !queue_.Empty();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "mpsc_queue.h"
+#include "wagon_source.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Приём вагонов с нескольких входящих линий во время смены.
+// Push/TryPush потокобезопасны; Pull и IsExhausted вызывает только станция из своего потока.
+// После того как все линии закончили, владелец вызывает Close().
+class WagonIntake : public WagonSource {
+public:
+    explicit WagonIntake(size_t capacity = 65536);
+
+    // false - очередь заполнена или приём уже закрыт.
+    bool TryPush(const Wagon& wagon);
+    // Ждёт свободного места. false - приём уже закрыт.
+    bool Push(const Wagon& wagon);
+
+    // Больше вагонов не будет. Вызывается после завершения всех Push.
+    void Close();
+    bool IsClosed() const;
+
+    // Сколько вагонов принято от линий (по типам в порядке Г, Л, О, П).
+    size_t GetAcceptedWagons(WagonType type) const;
+
+    size_t Pull(std::vector<Wagon>& out, size_t max_count) override;
+    bool IsExhausted() const override;
+    // Только из потока станции, как и Pull.
+    bool HasReadyWagons() const override;
+
+private:
+    MpscQueue<Wagon> queue_;
+    std::atomic<bool> closed_{false};
+    std::array<std::atomic<size_t>, 4> accepted_by_type_{};
+};
@@ -0,0 +1,105 @@
+#include "wagon_locator.h"
+
+void WagonLocator::Clear() {
+    entries_.clear();
+    train_numbers_.clear();
+    train_number_bytes_ = 0;
+    buffer_pushed_ = 0;
+    buffer_popped_ = 0;
+    ring_pushed_.fill(0);
+    ring_popped_.fill(0);
+}
+
+void WagonLocator::OnBufferPush(int wagon_number) {
+    entries_[wagon_number] = Entry{WagonPlace::kBuffer, 0, -1, buffer_pushed_++};
+}
+
+void WagonLocator::OnBufferPop() {
+    ++buffer_popped_;
+}
+
+void WagonLocator::OnBufferShift(int wagon_number) {
+    const auto it = entries_.find(wagon_number);
+    if (it != entries_.end() && it->second.place == WagonPlace::kBuffer) {
+        ++it->second.sequence;
+    }
+}
+
+void WagonLocator::OnRingPush(int wagon_number, WagonType kind) {
+    const size_t k = KindIndex_(kind);
+    entries_[wagon_number] = Entry{WagonPlace::kRing, static_cast<std::uint8_t>(k), -1, ring_pushed_[k]++};
+}
+
+void WagonLocator::OnRingPop(WagonType kind) {
+    ++ring_popped_[KindIndex_(kind)];
+}
+
+void WagonLocator::OnTrainPlanned(int train_id, const std::string& train_number) {
+    std::string& number = train_numbers_[train_id];
+    train_number_bytes_ -= memory::StringHeapBytes(number);
+    number = train_number;
+    train_number_bytes_ += memory::StringHeapBytes(number);
+}
+
+void WagonLocator::OnTrainPush(int wagon_number, int train_id, size_t position) {
+    entries_[wagon_number] = Entry{WagonPlace::kTrain, 0, train_id, position};
+}
+
+void WagonLocator::OnTrainDeparted(int train_id, const std::vector<Wagon>& wagons) {
+    for (const Wagon& wagon : wagons) {
+        Entry& entry = entries_[wagon.number];
+        entry.place = WagonPlace::kDeparted;
+        entry.train_id = train_id;
+    }
+}
+
+void WagonLocator::Forget(int wagon_number) {
+    entries_.erase(wagon_number);
+}
+
+std::optional<WagonLocation> WagonLocator::Locate(int wagon_number) const {
+    const auto it = entries_.find(wagon_number);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+
+    const Entry& entry = it->second;
+    WagonLocation location;
+    location.place = entry.place;
+    switch (entry.place) {
+        case WagonPlace::kBuffer: {
+            location.position = static_cast<size_t>(entry.sequence - buffer_popped_);
+            break;
+        }
+        case WagonPlace::kRing: {
+            location.position = static_cast<size_t>(entry.sequence - ring_popped_[entry.ring_kind]);
+            location.ring_kind = static_cast<WagonType>(entry.ring_kind);
+            break;
+        }
+        case WagonPlace::kTrain:
+        case WagonPlace::kDeparted: {
+            location.position = static_cast<size_t>(entry.sequence);
+            const auto train = train_numbers_.find(entry.train_id);
+            if (train != train_numbers_.end()) {
+                location.train_number = train->second;
+            }
+            break;
+        }
+    }
+    return location;
+}
+
+size_t WagonLocator::Size() const {
+    return entries_.size();
+}
+
+void WagonLocator::CollectMemory(std::vector<MemoryEntry>& out) const {
+    MemoryEntry index{"Индекс вагонов", entries_.size(), memory::HashMapBytes(entries_)};
+    MemoryEntry trains{"Номера поездов индекса", train_numbers_.size(),
+                       memory::HashMapBytes(train_numbers_) + train_number_bytes_};
+    out.insert(out.end(), {index, trains});
+}
+
+size_t WagonLocator::KindIndex_(WagonType kind) {
+    return static_cast<size_t>(kind);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Где сейчас вагон.
+enum class WagonPlace {
+    kBuffer,   // во входном буфере станции
+    kRing,     // на кольцевом пути
+    kTrain,    // в поезде на пути
+    kDeparted, // уехал в поезде
+};
+
+struct WagonLocation {
+    WagonPlace place = WagonPlace::kBuffer;
+    // Позиция от головы буфера или очереди кольца; в поезде - номер вагона в составе.
+    size_t position = 0;
+    WagonType ring_kind = WagonType::kFreight; // очередь кольца (kRing)
+    std::string train_number;                  // поезд (kTrain, kDeparted)
+};
+
+// Индекс "номер вагона -> место" с поиском за O(1).
+// Ведётся по ходу работы: буфер - станцией, кольцо и поезда - оператором (StationRuntime).
+// Позиции в очередях не пересчитываются при каждом снятии головы: вагону запоминается
+// порядковый номер постановки в очередь, а позиция - разность с числом уже снятых.
+class WagonLocator {
+public:
+    // Новая смена: индекс пуст.
+    void Clear();
+
+    void OnBufferPush(int wagon_number);
+    void OnBufferPop();
+    // Вагон буфера сдвинут на одно место к хвосту: следующий за ним ушёл через горку раньше.
+    void OnBufferShift(int wagon_number);
+
+    void OnRingPush(int wagon_number, WagonType kind);
+    // Голова очереди кольца ушла в поезд (сам вагон отмечается OnTrainPush).
+    void OnRingPop(WagonType kind);
+
+    void OnTrainPlanned(int train_id, const std::string& train_number);
+    void OnTrainPush(int wagon_number, int train_id, size_t position);
+    void OnTrainDeparted(int train_id, const std::vector<Wagon>& wagons);
+
+    // Вагон больше не на станции и не уехал (снят по окончании смены).
+    void Forget(int wagon_number);
+
+    std::optional<WagonLocation> Locate(int wagon_number) const;
+    size_t Size() const;
+
+    void CollectMemory(std::vector<MemoryEntry>& out) const;
+
+private:
+    struct Entry {
+        WagonPlace place = WagonPlace::kBuffer;
+        std::uint8_t ring_kind = 0;
+        int train_id = -1;
+        std::uint64_t sequence = 0; // порядковый номер в очереди или позиция в составе
+    };
+
+    static size_t KindIndex_(WagonType kind);
+
+private:
+    std::unordered_map<int, Entry> entries_;
+    // Номера поездов смены, в том числе уехавших.
+    std::unordered_map<int, std::string> train_numbers_;
+    size_t train_number_bytes_ = 0; // память строк train_numbers_, ведётся по ходу
+
+    std::uint64_t buffer_pushed_ = 0;
+    std::uint64_t buffer_popped_ = 0;
+    std::array<std::uint64_t, 4> ring_pushed_{};
+    std::array<std::uint64_t, 4> ring_popped_{};
+};
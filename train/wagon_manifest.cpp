@@ -0,0 +1,196 @@
+#include "wagon_manifest.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+// Сколько прочитанных байт ведомости копится перед тем, как отдать страницы ОС.
+constexpr size_t kReleaseStep = 1 << 20;
+
+std::string Trim(const std::string& s) {
+    const auto first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return {};
+    }
+    const auto last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+bool ParseWagonType(const std::string& field, WagonType& type) {
+    if (field == "Г"s || field == "0"s) {
+        type = WagonType::kFreight;
+    } else if (field == "Л"s || field == "1"s) {
+        type = WagonType::kPass;
+    } else if (field == "О"s || field == "2"s) {
+        type = WagonType::kDanger;
+    } else if (field == "П"s || field == "3"s) {
+        type = WagonType::kEmpty;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ManifestWriter::ManifestWriter(const std::string& path)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+        throw std::runtime_error("Не удалось открыть файл ведомости: "s + path);
+    }
+    // Заголовок с нулевым числом вагонов, число проставляется в Finish().
+    buffer_.WriteBytes(manifest::kMagic, sizeof(manifest::kMagic));
+    buffer_.WriteU16(manifest::kVersion);
+    buffer_.WriteU16(0);
+    buffer_.WriteU64(0);
+}
+
+ManifestWriter::~ManifestWriter() {
+    try {
+        Finish();
+    } catch (...) {
+    }
+}
+
+void ManifestWriter::Add(const Wagon& wagon) {
+    buffer_.WriteI32(wagon.number);
+    buffer_.WriteU8(static_cast<std::uint8_t>(wagon.wagon_type));
+    ++count_;
+    if (buffer_.Size() >= kFlushThreshold) {
+        FlushBuffer_();
+    }
+}
+
+void ManifestWriter::Finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    FlushBuffer_();
+
+    BinaryWriter count;
+    count.WriteU64(count_);
+    out_.seekp(static_cast<std::streamoff>(manifest::kHeaderSize - 8));
+    out_.write(count.Data().data(), static_cast<std::streamsize>(count.Size()));
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("Ошибка записи ведомости"s);
+    }
+}
+
+size_t ManifestWriter::GetWagonsCount() const {
+    return count_;
+}
+
+void ManifestWriter::FlushBuffer_() {
+    out_.write(buffer_.Data().data(), static_cast<std::streamsize>(buffer_.Size()));
+    buffer_.Clear();
+}
+
+ManifestSource::ManifestSource(const std::string& path)
+    : file_(path) {
+    BinaryReader header(file_.Data(), file_.Size());
+    char magic[sizeof(manifest::kMagic)];
+    header.ReadBytes(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic), std::begin(manifest::kMagic))) {
+        throw std::runtime_error("Файл не является ведомостью вагонов: "s + path);
+    }
+    if (header.ReadU16() != manifest::kVersion) {
+        throw std::runtime_error("Неподдерживаемая версия ведомости вагонов"s);
+    }
+    header.ReadU16();
+    count_ = static_cast<size_t>(header.ReadU64());
+
+    if ((file_.Size() - manifest::kHeaderSize) / manifest::kRecordSize < count_) {
+        throw std::runtime_error("Ведомость вагонов обрезана: "s + path);
+    }
+}
+
+size_t ManifestSource::GetWagonsCount() const {
+    return count_;
+}
+
+size_t ManifestSource::GetDeliveredCount() const {
+    return next_;
+}
+
+size_t ManifestSource::Pull(std::vector<Wagon>& out, size_t max_count) {
+    const size_t n = std::min(max_count, count_ - next_);
+    if (n == 0) {
+        return 0;
+    }
+
+    const size_t begin = manifest::kHeaderSize + next_ * manifest::kRecordSize;
+    BinaryReader reader(file_.Data() + begin, n * manifest::kRecordSize);
+    for (size_t i = 0; i < n; ++i) {
+        Wagon wagon{};
+        wagon.number = reader.ReadI32();
+        const std::uint8_t type = reader.ReadU8();
+        if (type >= kWagonType.size()) {
+            throw std::runtime_error("Неизвестный тип вагона в ведомости"s);
+        }
+        wagon.wagon_type = static_cast<WagonType>(type);
+        out.push_back(wagon);
+    }
+    next_ += n;
+
+    const size_t consumed = begin + n * manifest::kRecordSize;
+    if (consumed / kReleaseStep != begin / kReleaseStep) {
+        file_.ReleasePrefix(consumed);
+    }
+    return n;
+}
+
+bool ManifestSource::IsExhausted() const {
+    return next_ == count_;
+}
+
+size_t ConvertCsvToManifest(std::istream& csv, const std::string& out_path) {
+    ManifestWriter writer(out_path);
+
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(csv, line)) {
+        ++line_no;
+        line = Trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        const auto comma = line.find(',');
+        if (comma == std::string::npos) {
+            throw std::runtime_error("Строка "s + std::to_string(line_no) + ": ожидается \"номер,тип\""s);
+        }
+        const std::string number_field = Trim(line.substr(0, comma));
+        const std::string type_field = Trim(line.substr(comma + 1));
+
+        Wagon wagon{};
+        size_t parsed = 0;
+        try {
+            const long long number = std::stoll(number_field, &parsed);
+            if (parsed != number_field.size() || number < 0 || number > INT32_MAX) {
+                throw std::invalid_argument(number_field);
+            }
+            wagon.number = static_cast<int>(number);
+        } catch (const std::logic_error&) {
+            // Первая строка может быть заголовком
+            if (line_no == 1) {
+                continue;
+            }
+            throw std::runtime_error("Строка "s + std::to_string(line_no) + ": неверный номер вагона"s);
+        }
+        if (!ParseWagonType(type_field, wagon.wagon_type)) {
+            throw std::runtime_error("Строка "s + std::to_string(line_no) + ": неизвестный тип вагона"s);
+        }
+        writer.Add(wagon);
+    }
+
+    writer.Finish();
+    return writer.GetWagonsCount();
+}
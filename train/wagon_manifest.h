@@ -0,0 +1,74 @@
+#pragma once
+
+#include "binary_io.h"
+#include "mapped_file.h"
+#include "wagon_source.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Двоичная ведомость вагонов.
+//
+// Формат: заголовок "WMAN", версия (u16), резерв (u16), число вагонов (u64),
+// затем записи по 5 байт: номер (i32), тип (u8, WagonType). Числа в little-endian.
+namespace manifest {
+
+inline constexpr char kMagic[4] = {'W', 'M', 'A', 'N'};
+inline constexpr std::uint16_t kVersion = 1;
+inline constexpr size_t kHeaderSize = 16;
+inline constexpr size_t kRecordSize = 5;
+
+} // namespace manifest
+
+// Запись ведомости потоком, без накопления вагонов в памяти.
+class ManifestWriter {
+public:
+    explicit ManifestWriter(const std::string& path);
+    ~ManifestWriter();
+
+    ManifestWriter(const ManifestWriter&) = delete;
+    ManifestWriter& operator=(const ManifestWriter&) = delete;
+
+    void Add(const Wagon& wagon);
+
+    // Дописывает буфер и проставляет число вагонов в заголовке.
+    void Finish();
+
+    size_t GetWagonsCount() const;
+
+private:
+    std::ofstream out_;
+    BinaryWriter buffer_;
+    size_t count_ = 0;
+    bool finished_ = false;
+
+private:
+    void FlushBuffer_();
+};
+
+// Источник вагонов из ведомости, отображённой в память.
+// Станция забирает вагоны порциями (SortingHill::AttachWagonSource), прочитанные страницы
+// отдаются ОС, поэтому ведомость целиком не попадает ни в очередь станции, ни в память процесса.
+class ManifestSource : public WagonSource {
+public:
+    explicit ManifestSource(const std::string& path);
+
+    size_t GetWagonsCount() const;
+    size_t GetDeliveredCount() const;
+
+    size_t Pull(std::vector<Wagon>& out, size_t max_count) override;
+    bool IsExhausted() const override;
+
+private:
+    MappedFile file_;
+    size_t count_ = 0;
+    size_t next_ = 0;
+};
+
+// Преобразует CSV "номер,тип" в двоичную ведомость. Тип - буква Г/Л/О/П или число 0..3
+// (порядок WagonType). Строка заголовка допускается. Возвращает число вагонов.
+size_t ConvertCsvToManifest(std::istream& csv, const std::string& out_path);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+
+#include <cstddef>
+#include <vector>
+
+// Источник вагонов, из которого SortingHill пополняет входной буфер по ходу смены.
+// Окончание поступления сообщается явно через IsExhausted().
+class WagonSource {
+public:
+    virtual ~WagonSource() = default;
+
+    /* Дописывает в out не более max_count вагонов. Возвращает число добавленных. */
+    virtual size_t Pull(std::vector<Wagon>& out, size_t max_count) = 0;
+
+    /* Источник закрыт и всё поступившее уже забрано. */
+    virtual bool IsExhausted() const = 0;
+
+    /* Pull сейчас отдаст хотя бы один вагон. По умолчанию - пока источник не исчерпан;
+       источник, вагоны которого приходят по ходу смены, уточняет. */
+    virtual bool HasReadyWagons() const {
+        return !IsExhausted();
+    }
+};
@@ -0,0 +1,156 @@
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+// Номера идут подряд, после INT_MAX - снова с нуля: длинный поток не переполняет int.
+int NextWagonNumber(int number) {
+    return number == std::numeric_limits<int>::max() ? 0 : number + 1;
+}
+
+template <size_t N>
+std::vector<double> ToVector(const std::array<double, N>& weights) {
+    return std::vector<double>(weights.begin(), weights.end());
+}
+
+} // namespace
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& config)
+    : config_(config),
+      rng_(config.seed),
+      wagon_types_(ToVector(config.wagon_type_weights)),
+      loco_types_(ToVector(config.loco_type_weights)),
+      next_number_(config.first_wagon_number) {
+    if (wagon_types_.Empty()) {
+        throw std::invalid_argument("Нужен хотя бы один тип вагона с положительной долей"s);
+    }
+    if (loco_types_.Empty()) {
+        throw std::invalid_argument("Нужен хотя бы один тип локомотива с положительной долей"s);
+    }
+    if (config_.mean_consist_length < 1.0) {
+        throw std::invalid_argument("Средняя длина группы вагонов должна быть не меньше 1"s);
+    }
+    if (config_.day_length == 0) {
+        throw std::invalid_argument("Длина суток должна быть положительной"s);
+    }
+
+    // Вероятность продолжить группу p = 1 - 1 / L даёт среднюю длину L.
+    const double p_continue = 1.0 - 1.0 / config_.mean_consist_length;
+    continue_threshold_ = static_cast<std::uint64_t>(p_continue * 4294967296.0);
+
+    const double amplitude = std::clamp(config_.diurnal_amplitude, 0.0, 1.0);
+    const double pi = std::acos(-1.0);
+    for (size_t phase = 0; phase < kDayPhases; ++phase) {
+        auto weights = config_.event_weights;
+        const double angle = 2.0 * pi * (static_cast<double>(phase) + 0.5) / kDayPhases;
+        weights[static_cast<size_t>(EventType::kWagonArrived)] *= 1.0 + amplitude * std::sin(angle);
+        // Служебные события не разыгрываются
+        weights[static_cast<size_t>(EventType::kShiftStarted)] = 0.0;
+        weights[static_cast<size_t>(EventType::kShiftEnded)] = 0.0;
+
+        event_tables_[phase].Build(ToVector(weights));
+        if (event_tables_[phase].Empty()) {
+            throw std::invalid_argument("Нужна хотя бы одна команда с положительным весом"s);
+        }
+    }
+}
+
+void WorkloadGenerator::GenerateWagons(Wagon* out, size_t count) {
+    // Локальные копии состояния: компилятор держит их в регистрах.
+    WagonType type = current_type_;
+    bool in_consist = in_consist_;
+    int number = next_number_;
+    const std::uint64_t threshold = continue_threshold_;
+
+    if (threshold == 0) {
+        // Типы соседних вагонов независимы: одно случайное число на вагон.
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = Wagon{number, static_cast<WagonType>(wagon_types_.Sample(rng_.Next()))};
+            number = NextWagonNumber(number);
+        }
+        next_number_ = number;
+        return;
+    }
+
+    // Группа продолжается, пока монетка меньше порога: длина распределена геометрически.
+    for (size_t i = 0; i < count; ++i) {
+        const std::uint64_t r = rng_.Next();
+        if (!in_consist || (r & 0xFFFFFFFFu) >= threshold) {
+            type = static_cast<WagonType>(wagon_types_.Sample(rng_.Next()));
+            in_consist = true;
+        }
+        out[i] = Wagon{number, type};
+        number = NextWagonNumber(number);
+    }
+
+    current_type_ = type;
+    in_consist_ = in_consist;
+    next_number_ = number;
+}
+
+std::vector<Wagon> WorkloadGenerator::GenerateWagons(size_t count) {
+    std::vector<Wagon> wagons(count);
+    GenerateWagons(wagons.data(), count);
+    return wagons;
+}
+
+LocoType WorkloadGenerator::NextLocoType() {
+    return static_cast<LocoType>(loco_types_.Sample(rng_.Next()));
+}
+
+void WorkloadGenerator::GenerateLocoTypes(LocoType* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = NextLocoType();
+    }
+}
+
+void WorkloadGenerator::GenerateEvents(EventType* out, size_t count) {
+    const size_t day = config_.day_length;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t phase = (next_event_ % day) * kDayPhases / day;
+        out[i] = static_cast<EventType>(event_tables_[phase].Sample(rng_.Next()));
+        ++next_event_;
+    }
+}
+
+std::vector<EventType> WorkloadGenerator::GenerateEvents(size_t count) {
+    std::vector<EventType> events(count);
+    GenerateEvents(events.data(), count);
+    return events;
+}
+
+const WorkloadConfig& WorkloadGenerator::GetConfig() const {
+    return config_;
+}
+
+const std::array<std::uint64_t, 4>& WorkloadGenerator::GetRngState() const {
+    return rng_.GetState();
+}
+
+void WorkloadGenerator::SetRngState(const std::array<std::uint64_t, 4>& state) {
+    rng_.SetState(state);
+}
+
+GeneratedWagonSource::GeneratedWagonSource(WorkloadGenerator& generator, size_t total_wagons)
+    : generator_(generator),
+      left_(total_wagons) {
+}
+
+size_t GeneratedWagonSource::Pull(std::vector<Wagon>& out, size_t max_count) {
+    const size_t n = std::min(max_count, left_);
+    const size_t old_size = out.size();
+    out.resize(old_size + n);
+    generator_.GenerateWagons(out.data() + old_size, n);
+    left_ -= n;
+    return n;
+}
+
+bool GeneratedWagonSource::IsExhausted() const {
+    return left_ == 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "alias_table.h"
+#include "common.h"
+#include "fast_rng.h"
+#include "wagon_source.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Параметры генерируемой нагрузки.
+struct WorkloadConfig {
+    std::uint64_t seed = 1;
+
+    // Доли типов вагонов в порядке Г, Л, О, П
+    std::array<double, 4> wagon_type_weights{1.0, 1.0, 1.0, 1.0};
+    // Средняя длина группы однотипных вагонов подряд (длина распределена геометрически).
+    // 1.0 - типы соседних вагонов независимы.
+    double mean_consist_length = 1.0;
+    // Номер первого вагона; дальше номера идут подряд, после INT_MAX - с нуля
+    int first_wagon_number = 0;
+
+    // Доли типов прибывающих локомотивов в порядке ЭВЛ-16, ЭВЛ-32, ДЛ-24, ТДЛ-64
+    std::array<double, 4> loco_type_weights{1.0, 1.0, 1.0, 1.0};
+
+    // Веса команд дежурного (индекс - EventType). По умолчанию - как в kEventsBalanced.
+    std::array<double, 7> event_weights = DefaultEventWeights();
+    // Суточная неравномерность прибытия вагонов: вес kWagonArrived умножается на
+    // 1 + diurnal_amplitude * sin(2 pi t / day_length), t - номер команды.
+    double diurnal_amplitude = 0.0;
+    size_t day_length = 24 * 60;
+
+    static std::array<double, 7> DefaultEventWeights() {
+        std::array<double, 7> weights{};
+        for (EventType event : kEventsBalanced) {
+            weights[static_cast<size_t>(event)] += 1.0;
+        }
+        return weights;
+    }
+};
+
+// Генератор потоков вагонов, локомотивов и расписаний команд.
+// Все выборки - по таблицам псевдонимов и FastRng, без std::*_distribution на каждый элемент.
+// Один и тот же seed даёт одну и ту же последовательность.
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& config);
+
+    void GenerateWagons(Wagon* out, size_t count);
+    std::vector<Wagon> GenerateWagons(size_t count);
+
+    LocoType NextLocoType();
+    void GenerateLocoTypes(LocoType* out, size_t count);
+
+    // Расписание команд с суточной модуляцией прибытия вагонов.
+    void GenerateEvents(EventType* out, size_t count);
+    std::vector<EventType> GenerateEvents(size_t count);
+
+    const WorkloadConfig& GetConfig() const;
+
+    // Состояние FastRng для снимка станции: продолженная смена разыгрывает те же локомотивы.
+    const std::array<std::uint64_t, 4>& GetRngState() const;
+    void SetRngState(const std::array<std::uint64_t, 4>& state);
+
+private:
+    // Число фаз суток, для каждой своя таблица весов команд.
+    static constexpr size_t kDayPhases = 24;
+
+    WorkloadConfig config_;
+    FastRng rng_;
+
+    AliasTable wagon_types_;
+    AliasTable loco_types_;
+    std::array<AliasTable, kDayPhases> event_tables_;
+
+    // Продолжение группы однотипных вагонов: порог для младших 32 бит случайного числа
+    std::uint64_t continue_threshold_ = 0;
+    WagonType current_type_ = WagonType::kFreight;
+    bool in_consist_ = false;
+    int next_number_ = 0;
+    size_t next_event_ = 0;
+};
+
+// Источник вагонов для SortingHill на основе генератора: отдаёт total_wagons вагонов.
+class GeneratedWagonSource : public WagonSource {
+public:
+    GeneratedWagonSource(WorkloadGenerator& generator, size_t total_wagons);
+
+    size_t Pull(std::vector<Wagon>& out, size_t max_count) override;
+    bool IsExhausted() const override;
+
+private:
+    WorkloadGenerator& generator_;
+    size_t left_ = 0;
+};
@@ -0,0 +1,224 @@
+#include "yard_coordinator.h"
+#include "adaptive_dispatcher.h"
+#include "event_scheduler.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+#include "stealing_queue.h"
+#include "wagon_source.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::literals;
+
+namespace {
+
+using WagonQueues = std::vector<std::unique_ptr<StealingQueue<Wagon>>>;
+
+// Источник вагонов одной горки: своя очередь, а когда она пуста - кража у самой
+// загруженной соседки. Вагоны выдаются, только пока входной буфер горки меньше hump_batch,
+// чтобы остальные оставались доступны для кражи.
+class HumpFeed : public WagonSource {
+public:
+    HumpFeed(size_t index, WagonQueues& queues, const std::atomic<bool>& closed, size_t batch)
+        : index_(index), queues_(queues), closed_(closed), batch_(batch) {
+    }
+
+    void SetHill(const SortingHill* hill) {
+        hill_ = hill;
+    }
+
+    size_t Pull(std::vector<Wagon>& out, size_t max_count) override {
+        const size_t buffered = hill_->GetNumberOfWagBuffer();
+        if (buffered >= batch_) {
+            return 0;
+        }
+        const size_t wanted = std::min(max_count, batch_ - buffered);
+
+        chunk_.resize(wanted);
+        size_t taken = queues_[index_]->TakeBatch(chunk_.data(), wanted);
+        own_wagons_ += taken;
+        if (taken == 0) {
+            taken = Steal_(wanted);
+            stolen_wagons_ += taken;
+        }
+        out.insert(out.end(), chunk_.begin(), chunk_.begin() + static_cast<std::ptrdiff_t>(taken));
+        return taken;
+    }
+
+    bool IsExhausted() const override {
+        if (!closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        for (const auto& queue : queues_) {
+            if (queue->SizeApprox() > 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t GetOwnWagons() const {
+        return own_wagons_;
+    }
+
+    size_t GetStolenWagons() const {
+        return stolen_wagons_;
+    }
+
+private:
+    // Половина очереди самой загруженной горки (не больше wanted).
+    size_t Steal_(size_t wanted) {
+        size_t victim = index_;
+        size_t victim_size = 0;
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            const size_t size = queues_[i]->SizeApprox();
+            if (i != index_ && size > victim_size) {
+                victim = i;
+                victim_size = size;
+            }
+        }
+        if (victim == index_) {
+            return 0;
+        }
+        const size_t count = std::min(wanted, std::max<size_t>(1, victim_size / 2));
+        return queues_[victim]->TakeBatch(chunk_.data(), count);
+    }
+
+private:
+    const size_t index_;
+    WagonQueues& queues_;
+    const std::atomic<bool>& closed_;
+    const size_t batch_;
+    const SortingHill* hill_ = nullptr;
+
+    std::vector<Wagon> chunk_;
+    size_t own_wagons_ = 0;
+    size_t stolen_wagons_ = 0;
+};
+
+void RunHump(const YardConfig& config, size_t index, HumpFeed& feed, HumpReport& report) {
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>(config.planning_window, config.loco_assignment));
+    SortingHill sorting_hill(config.paths_per_hump, std::move(handlers));
+    sorting_hill.SetRingLimits(config.ring_limits);
+    feed.SetHill(&sorting_hill);
+    sorting_hill.AttachWagonSource(&feed);
+
+    WorkloadConfig workload = config.workload;
+    workload.seed = config.workload.seed + 1 + index;
+    WorkloadGenerator generator(workload);
+
+    std::unique_ptr<Dispatcher> dispatcher;
+    if (config.adaptive_dispatcher) {
+        dispatcher = std::make_unique<AdaptiveDispatcher>();
+    } else {
+        dispatcher = std::make_unique<EventScheduler>(workload.seed, workload);
+    }
+
+    sorting_hill.HandleEvent(EventType::kShiftStarted);
+    while (sorting_hill.HasIncomingWagons()) {
+        const std::optional<EventType> next_event = dispatcher->NextEvent(sorting_hill);
+        const size_t handled_before = sorting_hill.GetHandledEventsCount();
+        if (next_event == EventType::kLocoArrived) {
+            sorting_hill.HandleLocoArrived(generator.NextLocoType());
+        } else if (next_event) {
+            sorting_hill.HandleEvent(*next_event);
+        }
+        if (sorting_hill.GetHandledEventsCount() == handled_before) {
+            // Вагоны ещё не поступили и украсть нечего.
+            std::this_thread::yield();
+        }
+    }
+    sorting_hill.HandleEvent(EventType::kShiftEnded);
+
+    report.metrics = sorting_hill.GetMetrics();
+    report.own_wagons = feed.GetOwnWagons();
+    report.stolen_wagons = feed.GetStolenWagons();
+}
+
+} // namespace
+
+YardCoordinator::YardCoordinator(const YardConfig& config) : config_(config) {
+    if (config_.humps == 0) {
+        throw std::invalid_argument("В парке должна быть хотя бы одна горка"s);
+    }
+    if (config_.hump_batch == 0) {
+        throw std::invalid_argument("Пустая порция вагонов горки"s);
+    }
+}
+
+YardReport YardCoordinator::Run(const std::vector<Wagon>& wagons) {
+    const size_t humps = config_.humps;
+
+    WagonQueues queues;
+    for (size_t i = 0; i < humps; ++i) {
+        queues.push_back(std::make_unique<StealingQueue<Wagon>>(config_.queue_capacity));
+    }
+    std::atomic<bool> closed{false};
+    std::atomic<bool> failed{false};
+
+    std::vector<std::unique_ptr<HumpFeed>> feeds;
+    for (size_t i = 0; i < humps; ++i) {
+        feeds.push_back(std::make_unique<HumpFeed>(i, queues, closed, config_.hump_batch));
+    }
+
+    YardReport report;
+    report.humps.resize(humps);
+    std::vector<std::exception_ptr> errors(humps);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < humps; ++i) {
+        threads.emplace_back([&, i] {
+            try {
+                RunHump(config_, i, *feeds[i], report.humps[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                failed = true;
+            }
+        });
+    }
+
+    // Вагоны раздаются по кругу; если очередь горки заполнена - следующей горке.
+    size_t next = 0;
+    for (const Wagon& wagon : wagons) {
+        while (!queues[next]->TryPush(wagon)) {
+            next = (next + 1) % humps;
+            if (failed) {
+                break;
+            }
+            if (next == 0) {
+                std::this_thread::yield();
+            }
+        }
+        if (failed) {
+            break;
+        }
+        next = (next + 1) % humps;
+    }
+    closed.store(true, std::memory_order_release);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    report.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (const HumpReport& hump : report.humps) {
+        report.handled_events += hump.metrics.handled_events;
+        report.sent_trains += hump.metrics.sent_trains;
+        report.departed_wagons += hump.metrics.departed_wagons;
+        report.stolen_wagons += hump.stolen_wagons;
+    }
+    return report;
+}
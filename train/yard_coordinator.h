@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.h"
+#include "station_runtime.h"
+#include "workload_generator.h"
+
+#include <cstddef>
+#include <vector>
+
+// Парк из нескольких горок: у каждой своя станция (SortingHill со своими путями и
+// StationRuntime) и свой поток.
+struct YardConfig {
+    size_t humps = 2;
+    size_t paths_per_hump = 8;
+
+    size_t planning_window = 0;
+    LocoAssignment loco_assignment = LocoAssignment::kFifo;
+    RingLimits ring_limits;
+    bool adaptive_dispatcher = false;
+    // Веса команд и доли локомотивов; горка i берёт seed + 1 + i для своих генераторов.
+    WorkloadConfig workload;
+
+    // Ёмкость очереди входящих вагонов каждой горки.
+    size_t queue_capacity = 4096;
+    // Сколько вагонов горка держит во входном буфере; остальные ждут в её очереди,
+    // откуда их могут забрать простаивающие горки.
+    size_t hump_batch = 32;
+};
+
+struct HumpReport {
+    HillMetrics metrics;
+    size_t own_wagons = 0;    // взято из своей очереди
+    size_t stolen_wagons = 0; // забрано из очередей других горок
+};
+
+struct YardReport {
+    std::vector<HumpReport> humps;
+    size_t handled_events = 0;
+    size_t sent_trains = 0;
+    size_t departed_wagons = 0;
+    size_t stolen_wagons = 0;
+    double elapsed_seconds = 0.0; // реальное время прогона
+};
+
+// Координатор парка: распределяет входящие вагоны по очередям горок по кругу и ждёт,
+// пока все горки отработают смену. Горка, у которой своя очередь опустела, забирает
+// половину очереди самой загруженной горки (StealingQueue), поэтому неравномерный поток
+// или медленная горка не оставляют остальные без работы.
+// Каждая горка выбирает команды своим дежурным и разыгрывает локомотивы своим генератором:
+// общих генераторов (RandomGen) потоки горок не трогают.
+class YardCoordinator {
+public:
+    explicit YardCoordinator(const YardConfig& config);
+
+    // Полная смена всех горок по заданному потоку вагонов.
+    YardReport Run(const std::vector<Wagon>& wagons);
+
+private:
+    YardConfig config_;
+};
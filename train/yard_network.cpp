@@ -0,0 +1,316 @@
+#include "yard_network.h"
+#include "adaptive_dispatcher.h"
+#include "event_scheduler.h"
+#include "sorting_hill.h"
+#include "sorting_operator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using namespace std::literals;
+
+TransitSource::TransitSource(size_t links, size_t transit_delay, size_t capacity)
+    : transit_delay_(transit_delay),
+      closed_(new std::atomic<bool>[links]) {
+    for (size_t i = 0; i < links; ++i) {
+        links_.push_back(std::make_unique<SpscRing<std::vector<Wagon>>>(capacity));
+        closed_[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+void TransitSource::Ship(size_t link, std::vector<Wagon> wagons) {
+    if (wagons.empty()) {
+        return;
+    }
+    while (!links_.at(link)->TryPush(std::move(wagons))) {
+        if (IsCancelled()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void TransitSource::Close(size_t link) {
+    closed_[link].store(true, std::memory_order_release);
+}
+
+void TransitSource::Cancel() {
+    cancelled_.store(true, std::memory_order_release);
+}
+
+bool TransitSource::IsCancelled() const {
+    return cancelled_.load(std::memory_order_acquire);
+}
+
+void TransitSource::AddOrigin(const std::vector<Wagon>& wagons, size_t interval) {
+    for (size_t i = 0; i < wagons.size(); ++i) {
+        const std::uint64_t due = static_cast<std::uint64_t>(i) * interval;
+        if (origin_.empty() || origin_.back().due != due) {
+            origin_.push_back(Shipment{due, {}, 0});
+        }
+        origin_.back().wagons.push_back(wagons[i]);
+    }
+}
+
+void TransitSource::SetClock(std::uint64_t now) {
+    clock_ = now;
+}
+
+size_t TransitSource::GetReadyWagons() const {
+    return CountReady_(in_transit_, clock_) + CountReady_(origin_, clock_);
+}
+
+size_t TransitSource::GetReceivedWagons() const {
+    return received_wagons_;
+}
+
+size_t TransitSource::Pull(std::vector<Wagon>& out, size_t max_count) {
+    ReceiveShipments_();
+    size_t pulled = Release_(origin_, clock_, out, max_count);
+    pulled += Release_(in_transit_, clock_, out, max_count - pulled);
+    return pulled;
+}
+
+bool TransitSource::IsExhausted() const {
+    if (!in_transit_.empty() || !origin_.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < links_.size(); ++i) {
+        // Сначала признак закрытия: всё отправленное до Close уже видно в очереди.
+        if (!closed_[i].load(std::memory_order_acquire) || !links_[i]->EmptyApprox()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TransitSource::ReceiveShipments_() {
+    std::vector<Wagon> wagons;
+    for (auto& link : links_) {
+        while (link->TryPop(wagons)) {
+            received_wagons_ += wagons.size();
+            in_transit_.push_back(Shipment{clock_ + transit_delay_, std::move(wagons), 0});
+        }
+    }
+}
+
+size_t TransitSource::Release_(std::deque<Shipment>& shipments, std::uint64_t now, std::vector<Wagon>& out,
+                               size_t max_count) {
+    size_t released = 0;
+    while (released < max_count && !shipments.empty() && shipments.front().due <= now) {
+        Shipment& shipment = shipments.front();
+        const size_t count = std::min(max_count - released, shipment.wagons.size() - shipment.taken);
+        const auto first = shipment.wagons.begin() + static_cast<std::ptrdiff_t>(shipment.taken);
+        out.insert(out.end(), first, first + static_cast<std::ptrdiff_t>(count));
+        shipment.taken += count;
+        released += count;
+        if (shipment.taken == shipment.wagons.size()) {
+            shipments.pop_front();
+        }
+    }
+    return released;
+}
+
+size_t TransitSource::CountReady_(const std::deque<Shipment>& shipments, std::uint64_t now) {
+    size_t ready = 0;
+    for (const Shipment& shipment : shipments) {
+        if (shipment.due > now) {
+            break;
+        }
+        ready += shipment.wagons.size() - shipment.taken;
+    }
+    return ready;
+}
+
+DepartureLink::DepartureLink(TransitSource& target, size_t link) : target_(target), link_(link) {
+}
+
+void DepartureLink::OnShiftStarted(const HillMetrics&) {
+}
+
+void DepartureLink::OnOperation(const OperationInfo& operation_info, const HillMetrics&) {
+    if (operation_info.train_sent) {
+        target_.Ship(link_, operation_info.departed_wagons);
+    }
+}
+
+void DepartureLink::OnShiftEnded(const HillMetrics&) {
+    // Последние поезда ушли в OnOperation при окончании смены.
+    target_.Close(link_);
+}
+
+bool DepartureLink::NeedsOperationDetails() const {
+    return true;
+}
+
+NetworkConfig MakeCorridor(const std::vector<size_t>& paths, size_t transit_delay,
+                           std::vector<Wagon> origin_wagons, size_t origin_interval) {
+    NetworkConfig config;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        NetworkStation station;
+        station.paths = paths[i];
+        station.downstream = i + 1 < paths.size() ? static_cast<int>(i + 1) : -1;
+        station.transit_delay = transit_delay;
+        config.stations.push_back(std::move(station));
+    }
+    if (!config.stations.empty()) {
+        config.stations.front().origin_wagons = std::move(origin_wagons);
+        config.stations.front().origin_interval = origin_interval;
+    }
+    return config;
+}
+
+namespace {
+
+void RunStation(const NetworkConfig& config, size_t index, TransitSource& source, TransitSource* downstream,
+                size_t downstream_link, StationReport& report) {
+    const NetworkStation& station = config.stations[index];
+
+    std::vector<std::unique_ptr<SortingHandler>> handlers;
+    handlers.push_back(std::make_unique<SortingOperatorImpl>(config.planning_window, config.loco_assignment));
+    SortingHill sorting_hill(station.paths, std::move(handlers));
+    sorting_hill.SetRingLimits(config.ring_limits);
+    sorting_hill.AttachWagonSource(&source);
+    if (downstream != nullptr) {
+        sorting_hill.AddObserver(std::make_unique<DepartureLink>(*downstream, downstream_link));
+    }
+
+    WorkloadConfig workload = config.workload;
+    workload.seed = config.workload.seed + 1 + index;
+    WorkloadGenerator generator(workload);
+
+    std::unique_ptr<Dispatcher> dispatcher;
+    if (config.adaptive_dispatcher) {
+        dispatcher = std::make_unique<AdaptiveDispatcher>();
+    } else {
+        dispatcher = std::make_unique<EventScheduler>(workload.seed, workload);
+    }
+
+    if (station.configure) {
+        station.configure(sorting_hill);
+    }
+
+    sorting_hill.HandleEvent(EventType::kShiftStarted);
+    // После ошибки другой станции смена заканчивается досрочно: её итог всё равно не нужен.
+    while (sorting_hill.HasIncomingWagons() && !source.IsCancelled()) {
+        source.SetClock(report.commands++);
+
+        const std::optional<EventType> next_event = dispatcher->NextEvent(sorting_hill);
+        const size_t handled_before = sorting_hill.GetHandledEventsCount();
+        if (next_event == EventType::kLocoArrived) {
+            sorting_hill.HandleLocoArrived(generator.NextLocoType());
+        } else if (next_event) {
+            sorting_hill.HandleEvent(*next_event);
+        }
+
+        report.peak_backlog = std::max(report.peak_backlog,
+                                       sorting_hill.GetNumberOfWagBuffer() + source.GetReadyWagons());
+        if (sorting_hill.GetHandledEventsCount() == handled_before) {
+            // Составы ещё в пути.
+            report.idle_commands++;
+            std::this_thread::yield();
+        }
+    }
+    sorting_hill.HandleEvent(EventType::kShiftEnded);
+
+    report.metrics = sorting_hill.GetMetrics();
+    report.received_wagons = source.GetReceivedWagons();
+    if (report.commands > 0) {
+        report.utilization = 1.0 - static_cast<double>(report.idle_commands) / static_cast<double>(report.commands);
+    }
+}
+
+} // namespace
+
+YardNetwork::YardNetwork(NetworkConfig config) : config_(std::move(config)) {
+    const size_t count = config_.stations.size();
+    if (count == 0) {
+        throw std::invalid_argument("В сети должна быть хотя бы одна станция"s);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const int downstream = config_.stations[i].downstream;
+        if (downstream != -1 && (downstream <= static_cast<int>(i) || downstream >= static_cast<int>(count))) {
+            throw std::invalid_argument("Станция "s + std::to_string(i)
+                                        + ": следующая станция должна стоять дальше по списку"s);
+        }
+    }
+}
+
+NetworkReport YardNetwork::Run() {
+    const size_t count = config_.stations.size();
+
+    // Номера входящих линий: у каждой станции-отправителя своя линия на принимающей станции.
+    std::vector<size_t> inbound_links(count, 0);
+    std::vector<size_t> link_of(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const int downstream = config_.stations[i].downstream;
+        if (downstream != -1) {
+            link_of[i] = inbound_links[static_cast<size_t>(downstream)]++;
+        }
+    }
+
+    std::vector<std::unique_ptr<TransitSource>> sources;
+    for (size_t i = 0; i < count; ++i) {
+        // Задержка - время в пути к этой станции; у всех её отправителей берётся наибольшая.
+        size_t delay = 0;
+        for (const NetworkStation& station : config_.stations) {
+            if (station.downstream == static_cast<int>(i)) {
+                delay = std::max(delay, station.transit_delay);
+            }
+        }
+        sources.push_back(std::make_unique<TransitSource>(inbound_links[i], delay, config_.link_capacity));
+        sources.back()->AddOrigin(config_.stations[i].origin_wagons, config_.stations[i].origin_interval);
+    }
+
+    NetworkReport report;
+    report.stations.resize(count);
+    std::vector<std::exception_ptr> errors(count);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; ++i) {
+        const int downstream = config_.stations[i].downstream;
+        TransitSource* target = downstream == -1 ? nullptr : sources[static_cast<size_t>(downstream)].get();
+        threads.emplace_back([&, i, target] {
+            try {
+                RunStation(config_, i, *sources[i], target, link_of[i], report.stations[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                // Следующая станция не должна ждать состав, который не придёт, а предыдущая -
+                // места в линии, которую никто не разгружает.
+                if (target != nullptr) {
+                    target->Close(link_of[i]);
+                }
+                for (const auto& source : sources) {
+                    source->Cancel();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    report.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < count; ++i) {
+        const StationReport& station = report.stations[i];
+        const StationReport& worst = report.stations[report.bottleneck];
+        if (station.peak_backlog > worst.peak_backlog
+            || (station.peak_backlog == worst.peak_backlog && station.utilization > worst.utilization)) {
+            report.bottleneck = i;
+        }
+        if (config_.stations[i].downstream == -1) {
+            report.delivered_wagons += station.metrics.departed_wagons;
+        }
+    }
+    return report;
+}
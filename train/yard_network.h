@@ -0,0 +1,153 @@
+#pragma once
+
+#include "common.h"
+#include "observer_interface.h"
+#include "spsc_ring.h"
+#include "station_runtime.h"
+#include "wagon_source.h"
+#include "workload_generator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class SortingHill;
+
+// Вагоны, прибывающие на станцию сети: составы, отправленные станциями выше по линии,
+// и собственный (исходный) поток станции.
+// Для каждой входящей линии своя очередь SpscRing: Ship и Close вызывает только поток
+// станции-отправителя, остальное - только поток принимающей станции.
+// Время - команды принимающей станции (SetClock): состав, полученный в момент t,
+// выдаётся станции не раньше t + transit_delay.
+class TransitSource : public WagonSource {
+public:
+    TransitSource(size_t links, size_t transit_delay, size_t capacity = 1024);
+
+    // Поток отправителя: ждёт места в очереди линии. После Cancel состав не ждёт и теряется.
+    void Ship(size_t link, std::vector<Wagon> wagons);
+    // Отправитель закончил смену; больше по линии ничего не придёт.
+    void Close(size_t link);
+    // Любой поток: сеть остановлена из-за ошибки, принимающая станция может больше не забирать составы.
+    void Cancel();
+    bool IsCancelled() const;
+
+    // До начала смены: собственные вагоны станции, по одному через interval команд
+    // (0 - все сразу).
+    void AddOrigin(const std::vector<Wagon>& wagons, size_t interval);
+
+    void SetClock(std::uint64_t now);
+    // Вагоны, время прибытия которых наступило, но ещё не забранные станцией.
+    size_t GetReadyWagons() const;
+    // Всего вагонов получено по линиям.
+    size_t GetReceivedWagons() const;
+
+    size_t Pull(std::vector<Wagon>& out, size_t max_count) override;
+    bool IsExhausted() const override;
+
+private:
+    struct Shipment {
+        std::uint64_t due = 0;
+        std::vector<Wagon> wagons;
+        size_t taken = 0; // уже выдано станции
+    };
+
+    void ReceiveShipments_();
+    static size_t Release_(std::deque<Shipment>& shipments, std::uint64_t now, std::vector<Wagon>& out,
+                           size_t max_count);
+    static size_t CountReady_(const std::deque<Shipment>& shipments, std::uint64_t now);
+
+private:
+    const size_t transit_delay_;
+    std::vector<std::unique_ptr<SpscRing<std::vector<Wagon>>>> links_;
+    std::unique_ptr<std::atomic<bool>[]> closed_;
+    std::atomic<bool> cancelled_{false};
+
+    // Только поток принимающей станции. Очереди упорядочены по due.
+    std::uint64_t clock_ = 0;
+    std::deque<Shipment> in_transit_;
+    std::deque<Shipment> origin_;
+    size_t received_wagons_ = 0;
+};
+
+// Наблюдатель станции-отправителя: состав каждого отправленного поезда уходит
+// по линии на следующую станцию.
+class DepartureLink : public SortingObserver {
+public:
+    DepartureLink(TransitSource& target, size_t link);
+
+    void OnShiftStarted(const HillMetrics& metrics) override;
+    void OnOperation(const OperationInfo& operation_info, const HillMetrics& metrics) override;
+    void OnShiftEnded(const HillMetrics& metrics) override;
+    bool NeedsOperationDetails() const override;
+
+private:
+    TransitSource& target_;
+    const size_t link_;
+};
+
+struct NetworkStation {
+    size_t paths = 8;
+    // Станция, куда уходят отправленные поезда (-1 - конечная). Только дальше по списку:
+    // сеть без циклов, и каждая станция заканчивает смену после всех своих отправителей.
+    int downstream = -1;
+    // Время в пути до downstream, в командах принимающей станции.
+    size_t transit_delay = 0;
+    // Собственные вагоны станции и интервал их прибытия в командах (0 - все к началу смены).
+    std::vector<Wagon> origin_wagons;
+    size_t origin_interval = 0;
+    // Дополнительная настройка станции перед началом смены (свои наблюдатели, пределы кольца).
+    std::function<void(SortingHill&)> configure;
+};
+
+struct NetworkConfig {
+    std::vector<NetworkStation> stations;
+
+    size_t planning_window = 0;
+    LocoAssignment loco_assignment = LocoAssignment::kFifo;
+    RingLimits ring_limits;
+    bool adaptive_dispatcher = false;
+    // Веса команд и доли локомотивов; станция i берёт seed + 1 + i для своих генераторов.
+    WorkloadConfig workload;
+    // Ёмкость очереди каждой линии, в составах.
+    size_t link_capacity = 1024;
+};
+
+// Линия станций одна за другой (paths[i] путей у станции i); исходный поток - у первой.
+NetworkConfig MakeCorridor(const std::vector<size_t>& paths, size_t transit_delay,
+                           std::vector<Wagon> origin_wagons, size_t origin_interval);
+
+struct StationReport {
+    HillMetrics metrics;
+    size_t commands = 0;      // шагов дежурного, включая пустые проходы горки
+    size_t idle_commands = 0; // шаги, на которых ничего не произошло (ждали вагоны)
+    size_t received_wagons = 0;
+    // Наибольшая очередь прибывших, но не пропущенных через горку вагонов.
+    size_t peak_backlog = 0;
+    double utilization = 0.0; // доля шагов с выполненной командой
+};
+
+struct NetworkReport {
+    std::vector<StationReport> stations;
+    // Узкое место: станция с наибольшей очередью перед горкой (при равенстве - с большей загрузкой).
+    size_t bottleneck = 0;
+    size_t delivered_wagons = 0; // вывезено конечными станциями
+    double elapsed_seconds = 0.0;
+};
+
+// Сеть станций, каждая в своём потоке. Станции связаны линиями TransitSource;
+// отправленные поезда через DepartureLink становятся входящими вагонами следующей станции.
+// Ошибка любой станции останавливает всю сеть: остальные заканчивают смену досрочно,
+// а Run бросает эту ошибку.
+class YardNetwork {
+public:
+    explicit YardNetwork(NetworkConfig config);
+
+    NetworkReport Run();
+
+private:
+    NetworkConfig config_;
+};